@@ -3,6 +3,7 @@
 #include "chrono_utility.hpp"
 #include "components_manager_killer.hpp"
 #include "constants.hpp"
+#include "device_grabber_details/complex_modifications_manipulator_manager.hpp"
 #include "device_grabber_details/entry.hpp"
 #include "device_grabber_details/fn_function_keys_manipulator_manager.hpp"
 #include "device_grabber_details/simple_modifications_manipulator_manager.hpp"
@@ -47,14 +48,17 @@ public:
   device_grabber(std::weak_ptr<console_user_server_client> weak_console_user_server_client,
                  std::weak_ptr<grabber_state_json_writer> weak_grabber_state_json_writer)
       : dispatcher_client(),
+        weak_grabber_state_json_writer_(weak_grabber_state_json_writer),
         core_configuration_(std::make_shared<core_configuration::core_configuration>()),
         system_sleeping_(false),
+        pointing_motion_coalescing_(false),
+        coalesced_pointing_motion_count_(0),
         logger_unique_filter_(logger::get_logger()) {
     notification_message_manager_ = std::make_shared<notification_message_manager>(
         constants::get_notification_message_file_path());
 
     simple_modifications_manipulator_manager_ = std::make_shared<device_grabber_details::simple_modifications_manipulator_manager>();
-    complex_modifications_manipulator_manager_ = std::make_shared<manipulator::manipulator_manager>();
+    complex_modifications_manipulator_manager_ = std::make_shared<device_grabber_details::complex_modifications_manipulator_manager>();
     fn_function_keys_manipulator_manager_ = std::make_shared<device_grabber_details::fn_function_keys_manipulator_manager>();
     post_event_to_virtual_devices_manipulator_manager_ = std::make_shared<manipulator::manipulator_manager>();
 
@@ -168,13 +172,18 @@ public:
     manipulator_managers_connector_.emplace_back_connection(simple_modifications_manipulator_manager_->get_manipulator_manager(),
                                                             merged_input_event_queue_,
                                                             simple_modifications_applied_event_queue_);
-    manipulator_managers_connector_.emplace_back_connection(complex_modifications_manipulator_manager_,
+    manipulator_managers_connector_.emplace_back_connection(complex_modifications_manipulator_manager_->get_manipulator_manager(),
                                                             complex_modifications_applied_event_queue_);
     manipulator_managers_connector_.emplace_back_connection(fn_function_keys_manipulator_manager_->get_manipulator_manager(),
                                                             fn_function_keys_applied_event_queue_);
     manipulator_managers_connector_.emplace_back_connection(post_event_to_virtual_devices_manipulator_manager_,
                                                             posted_event_queue_);
 
+    // complex_modifications manipulators are built in background when the configuration is reloaded.
+    complex_modifications_manipulator_manager_->manipulators_updated.connect([this] {
+      update_virtual_hid_pointing();
+    });
+
     external_signal_connections_.emplace_back(
         krbn_notification_center::get_instance().input_event_arrived.connect([this] {
           manipulate(pqrs::osx::chrono::mach_absolute_time_point());
@@ -484,7 +493,9 @@ public:
           simple_modifications_manipulator_manager_->update(profile);
           fn_function_keys_manipulator_manager_->update(profile,
                                                         system_preferences_properties_);
-          update_complex_modifications_manipulators();
+          complex_modifications_manipulator_manager_->update(core_configuration_);
+          post_event_to_virtual_devices_manipulator_->set_coalesce_pointing_inputs(
+              core_configuration_->get_global_configuration().get_coalesce_pointing_input_reports());
 
           update_virtual_hid_keyboard();
           update_virtual_hid_pointing();
@@ -705,6 +716,8 @@ private:
         merged_input_event_queue_->sort_events();
       }
 
+      update_pointing_motion_coalescing();
+
       if (needs_regrab) {
         grab_device(entry);
       }
@@ -715,6 +728,41 @@ private:
     }
   }
 
+  // This method is executed in the shared dispatcher thread.
+  //
+  // When manipulate falls behind the input (e.g., while the configuration is being reloaded),
+  // a backlog of tiny pointing_motion events builds up in merged_input_event_queue_ and the pointer lags behind the hand.
+  // In that case, we merge pending pointing_motion events until the backlog is resolved.
+  void update_pointing_motion_coalescing(void) {
+    auto size = merged_input_event_queue_->get_entries().size();
+
+    if (!pointing_motion_coalescing_) {
+      if (size <= constants::pointing_motion_coalescing_start_queue_size) {
+        return;
+      }
+
+      logger::get_logger()->info("pointing_motion coalescing is started (queue size: {0})", size);
+
+      pointing_motion_coalescing_ = true;
+      if (auto writer = weak_grabber_state_json_writer_.lock()) {
+        writer->set_pointing_motion_coalescing(true);
+      }
+
+    } else if (size <= constants::pointing_motion_coalescing_stop_queue_size) {
+      logger::get_logger()->info("pointing_motion coalescing is stopped (total coalesced events: {0})", coalesced_pointing_motion_count_);
+
+      pointing_motion_coalescing_ = false;
+      if (auto writer = weak_grabber_state_json_writer_.lock()) {
+        writer->set_pointing_motion_coalescing(false);
+        writer->set_coalesced_pointing_motion_count(coalesced_pointing_motion_count_);
+      }
+
+      return;
+    }
+
+    coalesced_pointing_motion_count_ += merged_input_event_queue_->coalesce_pointing_motions();
+  }
+
   void post_device_grabbed_event(gsl::not_null<std::shared_ptr<device_properties>> device_properties) {
     auto event = event_queue::event::make_device_grabbed_event(device_properties);
     event_queue::entry entry(device_properties->get_device_id(),
@@ -969,33 +1017,6 @@ private:
     connected_devices.async_save_to_file(file_path);
   }
 
-  void update_complex_modifications_manipulators(void) {
-    complex_modifications_manipulator_manager_->invalidate_manipulators();
-
-    for (const auto& rule : core_configuration_->get_selected_profile().get_complex_modifications()->get_rules()) {
-      if (!rule->get_enabled()) {
-        continue;
-      }
-
-      for (const auto& manipulator : rule->get_manipulators()) {
-        try {
-          auto m = manipulator::manipulator_factory::make_manipulator(manipulator->to_json(),
-                                                                      manipulator->get_parameters());
-          for (const auto& c : manipulator->get_conditions()) {
-            m->push_back_condition(manipulator::condition_factory::make_condition(c.get_json()));
-          }
-          complex_modifications_manipulator_manager_->push_back_manipulator(m);
-
-        } catch (const pqrs::json::unmarshal_error& e) {
-          logger::get_logger()->error(fmt::format("karabiner.json error: {0}", e.what()));
-
-        } catch (const std::exception& e) {
-          logger::get_logger()->error(e.what());
-        }
-      }
-    }
-  }
-
   void set_system_sleeping(bool value) {
     system_sleeping_ = value;
 
@@ -1003,6 +1024,8 @@ private:
     async_grab_devices();
   }
 
+  std::weak_ptr<grabber_state_json_writer> weak_grabber_state_json_writer_;
+
   std::shared_ptr<pqrs::karabiner::driverkit::virtual_hid_device_service::client> virtual_hid_device_service_client_;
 
   virtual_hid_devices_state virtual_hid_devices_state_;
@@ -1027,11 +1050,13 @@ private:
   std::shared_ptr<notification_message_manager> notification_message_manager_;
 
   std::shared_ptr<event_queue::queue> merged_input_event_queue_;
+  bool pointing_motion_coalescing_;
+  size_t coalesced_pointing_motion_count_;
 
   std::shared_ptr<device_grabber_details::simple_modifications_manipulator_manager> simple_modifications_manipulator_manager_;
   std::shared_ptr<event_queue::queue> simple_modifications_applied_event_queue_;
 
-  std::shared_ptr<manipulator::manipulator_manager> complex_modifications_manipulator_manager_;
+  std::shared_ptr<device_grabber_details::complex_modifications_manipulator_manager> complex_modifications_manipulator_manager_;
   std::shared_ptr<event_queue::queue> complex_modifications_applied_event_queue_;
 
   std::shared_ptr<device_grabber_details::fn_function_keys_manipulator_manager> fn_function_keys_manipulator_manager_;
@@ -0,0 +1,168 @@
+#pragma once
+
+// `krbn::grabber::device_grabber_details::complex_modifications_manipulator_manager` can be used safely in a multi-threaded environment.
+
+#include "core_configuration/core_configuration.hpp"
+#include "logger.hpp"
+#include "manipulator/condition_factory.hpp"
+#include "manipulator/manipulator_cache.hpp"
+#include "manipulator/manipulator_factory.hpp"
+#include "manipulator/manipulator_manager.hpp"
+#include <atomic>
+#include <nod/nod.hpp>
+#include <pqrs/dispatcher.hpp>
+
+namespace krbn {
+namespace grabber {
+namespace device_grabber_details {
+// Builds complex_modifications manipulators in a background thread and swaps them into the manipulator_manager
+// in the dispatcher thread.
+//
+// Parsing manipulators (including compiling expressions and regexes) takes a long time with a large karabiner.json.
+// Building them in the background thread avoids stalling the input event processing while reloading the configuration.
+// In addition, manipulators of unchanged rules are reused, so only added or changed rules are built.
+//
+// Only the first update builds manipulators synchronously, since there are no manipulators to use until the build is finished.
+class complex_modifications_manipulator_manager final : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  // Signals (invoked from the dispatcher thread)
+
+  nod::signal<void(void)> manipulators_updated;
+
+  // Methods
+
+  complex_modifications_manipulator_manager(const complex_modifications_manipulator_manager&) = delete;
+
+  complex_modifications_manipulator_manager(void)
+      : dispatcher_client(),
+        manipulator_manager_(std::make_shared<manipulator::manipulator_manager>()),
+        worker_time_source_(std::make_shared<pqrs::dispatcher::hardware_time_source>()),
+        worker_dispatcher_(std::make_shared<pqrs::dispatcher::dispatcher>(worker_time_source_)),
+        worker_object_id_(pqrs::dispatcher::make_new_object_id()),
+        generation_(0),
+        updated_(false) {
+    worker_dispatcher_->attach(worker_object_id_);
+  }
+
+  virtual ~complex_modifications_manipulator_manager(void) {
+    // Wait until the running build is finished.
+    worker_dispatcher_->detach(worker_object_id_);
+    worker_dispatcher_->terminate();
+
+    detach_from_dispatcher();
+  }
+
+  std::shared_ptr<manipulator::manipulator_manager> get_manipulator_manager(void) const {
+    return manipulator_manager_;
+  }
+
+  // This method has to be called in the dispatcher thread.
+  //
+  // The first update replaces manipulators before returning
+  // in order to apply complex_modifications to input events right after the grabber is started.
+  // Later updates keep the current manipulators until the new ones are built in the background thread.
+  void update(gsl::not_null<std::shared_ptr<const core_configuration::core_configuration>> core_configuration) {
+    auto generation = ++generation_;
+
+    if (!updated_) {
+      updated_ = true;
+
+      auto manipulators = make_manipulators(*core_configuration);
+      manipulator_manager_->replace_manipulators(*manipulators);
+
+      manipulators_updated();
+      return;
+    }
+
+    worker_dispatcher_->enqueue(
+        worker_object_id_,
+        [this, core_configuration, generation] {
+          // Skip outdated requests when the configuration is updated repeatedly.
+          if (generation != generation_) {
+            return;
+          }
+
+          auto manipulators = make_manipulators(*core_configuration);
+
+          enqueue_to_dispatcher([this, manipulators, generation] {
+            if (generation != generation_) {
+              return;
+            }
+
+            manipulator_manager_->replace_manipulators(*manipulators);
+
+            manipulators_updated();
+          });
+        });
+  }
+
+private:
+  // This method is called in the worker thread, except for the first update.
+  std::shared_ptr<manipulator::manipulator_cache::manipulators_t> make_manipulators(const core_configuration::core_configuration& core_configuration) {
+    auto manipulators = std::make_shared<manipulator::manipulator_cache::manipulators_t>();
+
+    manipulator_cache_.begin_update();
+
+    for (const auto& rule : core_configuration.get_selected_profile().get_complex_modifications()->get_rules()) {
+      if (!rule->get_enabled()) {
+        continue;
+      }
+
+      const auto& m = manipulator_cache_.find_or_make(rule->get_content_hash(),
+                                                      rule->get_content_json(),
+                                                      [&rule] {
+                                                        return make_rule_manipulators(*rule);
+                                                      });
+      manipulators->insert(std::end(*manipulators),
+                           std::begin(m),
+                           std::end(m));
+    }
+
+    manipulator_cache_.end_update();
+
+    logger::get_logger()->info("complex_modifications rules are updated (reused: {0}, rebuilt: {1})",
+                               manipulator_cache_.get_reused_count(),
+                               manipulator_cache_.get_rebuilt_count());
+
+    return manipulators;
+  }
+
+  static manipulator::manipulator_cache::manipulators_t make_rule_manipulators(const core_configuration::details::complex_modifications_rule& rule) {
+    manipulator::manipulator_cache::manipulators_t manipulators;
+
+    for (const auto& manipulator : rule.get_manipulators()) {
+      try {
+        auto m = manipulator::manipulator_factory::make_manipulator(manipulator->to_json(),
+                                                                    manipulator->get_parameters());
+        for (const auto& c : manipulator->get_conditions()) {
+          m->push_back_condition(manipulator::condition_factory::make_condition(c.get_json()));
+        }
+        manipulators.push_back(m);
+
+      } catch (const pqrs::json::unmarshal_error& e) {
+        logger::get_logger()->error(fmt::format("karabiner.json error: {0}", e.what()));
+
+      } catch (const std::exception& e) {
+        logger::get_logger()->error(e.what());
+      }
+    }
+
+    return manipulators;
+  }
+
+  std::shared_ptr<manipulator::manipulator_manager> manipulator_manager_;
+
+  std::shared_ptr<pqrs::dispatcher::hardware_time_source> worker_time_source_;
+  std::shared_ptr<pqrs::dispatcher::dispatcher> worker_dispatcher_;
+  pqrs::dispatcher::object_id worker_object_id_;
+
+  // `manipulator_cache_` is used only in the worker thread after the first update.
+  manipulator::manipulator_cache manipulator_cache_;
+
+  std::atomic<uint64_t> generation_;
+  // `updated_` is used only in the dispatcher thread.
+  bool updated_;
+};
+} // namespace device_grabber_details
+} // namespace grabber
+} // namespace krbn
@@ -64,7 +64,7 @@ public:
           game_pad_stick_converter_ = std::make_unique<game_pad_stick_converter>(device_properties_,
                                                                                  core_configuration_);
           game_pad_stick_converter_->pointing_motion_arrived.connect([this](auto&& event_queue_entry) {
-            auto event_queue_entries = std::make_shared<std::vector<event_queue::not_null_const_entry_ptr_t>>();
+            auto event_queue_entries = entries_pool_.make_entries();
             event_queue_entries->push_back(event_queue_entry);
 
             hid_queue_values_arrived(*this,
@@ -144,16 +144,17 @@ public:
       // Make event queue
       //
 
-      auto event_queue_entries = event_queue::utility::make_entries(device_properties_,
+      auto event_queue_entries = event_queue::utility::make_entries(entries_pool_,
+                                                                    device_properties_,
                                                                     hid_values,
                                                                     {
                                                                         .pointing_motion_xy_multiplier = d->get_pointing_motion_xy_multiplier(),
                                                                         .pointing_motion_wheels_multiplier = d->get_pointing_motion_wheels_multiplier(),
                                                                     });
 
-      event_queue::utility::insert_device_keys_and_pointing_buttons_are_released_event(event_queue_entries,
-                                                                                       device_id_,
-                                                                                       pressed_keys_manager_);
+      event_queue::utility::update_pressed_keys_manager(event_queue_entries,
+                                                        device_id_,
+                                                        *pressed_keys_manager_);
       hid_queue_values_arrived(*this,
                                event_queue_entries);
 
@@ -346,6 +347,7 @@ private:
   std::shared_ptr<pqrs::osx::iokit_hid_queue_value_monitor> hid_queue_value_monitor_;
   std::unique_ptr<game_pad_stick_converter> game_pad_stick_converter_;
   hid_queue_values_converter hid_queue_values_converter_;
+  event_queue::entries_pool entries_pool_;
   std::string device_name_;
   std::string device_short_name_;
 
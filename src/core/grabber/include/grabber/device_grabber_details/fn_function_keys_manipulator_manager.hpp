@@ -3,6 +3,7 @@
 #include "core_configuration/core_configuration.hpp"
 #include "json_utility.hpp"
 #include "manipulator/condition_factory.hpp"
+#include "manipulator/manipulator_factory.hpp"
 #include "manipulator/manipulator_manager.hpp"
 #include "manipulator/manipulators/basic/basic.hpp"
 
@@ -77,36 +78,32 @@ public:
     // from_modifiers+f1 -> display_brightness_decrement ...
 
     for (const auto& device : profile.get_devices()) {
-      for (const auto& pair : device->get_fn_function_keys()->get_pairs()) {
-        try {
-          if (auto m = make_function_key_manipulator(pair,
-                                                     from_mandatory_modifiers_fn)) {
-            m->push_back_condition(manipulator::condition_factory::make_event_changed_if_condition(false));
-            m->push_back_condition(manipulator::condition_factory::make_device_unless_touch_bar_condition());
+      try {
+        for (const auto& m : manipulator::manipulator_factory::make_remap_manipulators(make_function_key_definitions(*device->get_fn_function_keys(),
+                                                                                                                     from_mandatory_modifiers_fn))) {
+          m->push_back_condition(manipulator::condition_factory::make_event_changed_if_condition(false));
+          m->push_back_condition(manipulator::condition_factory::make_device_unless_touch_bar_condition());
 
-            auto c = manipulator::condition_factory::make_device_if_condition(*device);
-            m->push_back_condition(c);
+          auto c = manipulator::condition_factory::make_device_if_condition(*device);
+          m->push_back_condition(c);
 
-            manipulator_manager_->push_back_manipulator(m);
-          }
+          manipulator_manager_->push_back_manipulator(m);
+        }
 
-        } catch (const pqrs::json::unmarshal_error& e) {
-          logger::get_logger()->error(fmt::format("karabiner.json error: {0}", e.what()));
+      } catch (const pqrs::json::unmarshal_error& e) {
+        logger::get_logger()->error(fmt::format("karabiner.json error: {0}", e.what()));
 
-        } catch (const std::exception& e) {
-          logger::get_logger()->error(e.what());
-        }
+      } catch (const std::exception& e) {
+        logger::get_logger()->error(e.what());
       }
     }
 
-    for (const auto& pair : profile.get_fn_function_keys()->get_pairs()) {
-      if (auto m = make_function_key_manipulator(pair,
-                                                 from_mandatory_modifiers_fn)) {
-        m->push_back_condition(manipulator::condition_factory::make_event_changed_if_condition(false));
-        m->push_back_condition(manipulator::condition_factory::make_device_unless_touch_bar_condition());
+    for (const auto& m : manipulator::manipulator_factory::make_remap_manipulators(make_function_key_definitions(*profile.get_fn_function_keys(),
+                                                                                                                 from_mandatory_modifiers_fn))) {
+      m->push_back_condition(manipulator::condition_factory::make_event_changed_if_condition(false));
+      m->push_back_condition(manipulator::condition_factory::make_device_unless_touch_bar_condition());
 
-        manipulator_manager_->push_back_manipulator(m);
-      }
+      manipulator_manager_->push_back_manipulator(m);
     }
 
     //
@@ -227,12 +224,26 @@ public:
   }
 
 private:
-  std::shared_ptr<manipulator::manipulators::base> make_function_key_manipulator(const std::pair<std::string, std::string>& pair,
-                                                                                 bool from_mandatory_modifiers_fn) const {
+  std::vector<std::pair<manipulator::manipulators::basic::from_event_definition, manipulator::to_event_definitions>> make_function_key_definitions(const core_configuration::details::simple_modifications& fn_function_keys,
+                                                                                                                                                  bool from_mandatory_modifiers_fn) const {
+    std::vector<std::pair<manipulator::manipulators::basic::from_event_definition, manipulator::to_event_definitions>> definitions;
+
+    for (const auto& pair : fn_function_keys.get_pairs()) {
+      if (auto d = make_function_key_definition(pair,
+                                                from_mandatory_modifiers_fn)) {
+        definitions.push_back(*d);
+      }
+    }
+
+    return definitions;
+  }
+
+  std::optional<std::pair<manipulator::manipulators::basic::from_event_definition, manipulator::to_event_definitions>> make_function_key_definition(const std::pair<std::string, std::string>& pair,
+                                                                                                                                                   bool from_mandatory_modifiers_fn) const {
     try {
       auto from_json = json_utility::parse_jsonc(pair.first);
       if (from_json.empty()) {
-        return nullptr;
+        return std::nullopt;
       }
       from_json["modifiers"]["mandatory"] = nlohmann::json::array();
       if (from_mandatory_modifiers_fn) {
@@ -243,10 +254,10 @@ private:
 
       auto to_json = json_utility::parse_jsonc(pair.second);
       if (to_json.empty()) {
-        return nullptr;
+        return std::nullopt;
       }
 
-      std::vector<gsl::not_null<std::shared_ptr<manipulator::to_event_definition>>> to_event_definitions;
+      manipulator::to_event_definitions to_event_definitions;
       for (auto&& j : to_json) {
         // Note:
         // Normal f1...f12 keys will be changed media control keys by the Apple keyboard driver of macOS.
@@ -302,15 +313,15 @@ private:
         to_event_definitions.push_back(std::make_shared<manipulator::to_event_definition>(j));
       }
 
-      return std::make_shared<manipulator::manipulators::basic::basic>(manipulator::manipulators::basic::from_event_definition(from_json),
-                                                                       to_event_definitions);
+      return std::make_pair(manipulator::manipulators::basic::from_event_definition(from_json),
+                            to_event_definitions);
     } catch (const pqrs::json::unmarshal_error& e) {
       logger::get_logger()->error(fmt::format("karabiner.json error: {0}", e.what()));
     } catch (const std::exception& e) {
       logger::get_logger()->error(e.what());
     }
 
-    return nullptr;
+    return std::nullopt;
   }
 
   bool f1_f12_key(const std::string key_code) const {
@@ -2,6 +2,7 @@
 
 #include "exprtk_utility.hpp"
 #include "logger.hpp"
+#include "timer_wheel.hpp"
 #include "types/device_id.hpp"
 #include <deque>
 #include <memory>
@@ -629,7 +630,7 @@ private:
   event_value horizontal_wheel_value_;
   event_value vertical_wheel_value_;
 
-  pqrs::dispatcher::extra::timer continued_movement_timer_;
+  timer_wheel_timer continued_movement_timer_;
   int continued_movement_timer_count_;
   continued_movement_mode continued_movement_mode_;
 
@@ -3,6 +3,8 @@
 #include "core_configuration/core_configuration.hpp"
 #include "json_utility.hpp"
 #include "manipulator/condition_factory.hpp"
+#include "manipulator/manipulator_cache.hpp"
+#include "manipulator/manipulator_factory.hpp"
 #include "manipulator/manipulator_manager.hpp"
 #include "manipulator/manipulators/basic/basic.hpp"
 
@@ -20,126 +22,180 @@ public:
   }
 
   void update(const core_configuration::details::profile& profile) {
-    manipulator_manager_->invalidate_manipulators();
+    // Manipulators of devices whose settings are not changed are reused.
+
+    manipulator::manipulator_cache::manipulators_t manipulators;
+
+    manipulator_cache_.begin_update();
 
     for (const auto& device : profile.get_devices()) {
-      //
-      // Add profile.device.simple_modifications
-      //
+      auto mouse_basic_json = make_mouse_basic_json(*device);
+
+      auto content = nlohmann::json::object({
+          {"identifiers", device->get_identifiers()},
+          {"simple_modifications", device->get_simple_modifications()->get_content_json()},
+          {"mouse_basic", mouse_basic_json ? *mouse_basic_json : nlohmann::json()},
+      });
+
+      const auto& m = manipulator_cache_.find_or_make(std::hash<nlohmann::json>{}(content),
+                                                      content,
+                                                      [this, &device, &mouse_basic_json] {
+                                                        return make_device_manipulators(*device, mouse_basic_json);
+                                                      });
+      manipulators.insert(std::end(manipulators),
+                          std::begin(m),
+                          std::end(m));
+    }
 
-      for (const auto& pair : device->get_simple_modifications()->get_pairs()) {
-        try {
-          if (auto m = make_manipulator(pair)) {
-            auto c = manipulator::condition_factory::make_device_if_condition(*device);
-            m->push_back_condition(c);
-            manipulator_manager_->push_back_manipulator(m);
-          }
+    {
+      const auto& m = manipulator_cache_.find_or_make(profile.get_simple_modifications()->get_content_hash(),
+                                                      profile.get_simple_modifications()->get_content_json(),
+                                                      [this, &profile] {
+                                                        return make_profile_manipulators(profile);
+                                                      });
+      manipulators.insert(std::end(manipulators),
+                          std::begin(m),
+                          std::end(m));
+    }
 
-        } catch (const pqrs::json::unmarshal_error& e) {
-          logger::get_logger()->error(fmt::format("karabiner.json error: {0}", e.what()));
+    manipulator_cache_.end_update();
 
-        } catch (const std::exception& e) {
-          logger::get_logger()->error(e.what());
-        }
-      }
+    manipulator_manager_->replace_manipulators(manipulators);
 
-      //
-      // Add profile.device.mouse_flip_*, mouse_swap_*
-      //
+    logger::get_logger()->info("simple_modifications are updated (reused: {0}, rebuilt: {1})",
+                               manipulator_cache_.get_reused_count(),
+                               manipulator_cache_.get_rebuilt_count());
+  }
 
-      {
-        auto flip = nlohmann::json::array();
-        if (device->get_mouse_flip_x()) {
-          flip.push_back("x");
-        }
-        if (device->get_mouse_flip_y()) {
-          flip.push_back("y");
-        }
-        if (device->get_mouse_flip_vertical_wheel()) {
-          flip.push_back("vertical_wheel");
-        }
-        if (device->get_mouse_flip_horizontal_wheel()) {
-          flip.push_back("horizontal_wheel");
-        }
+private:
+  manipulator::manipulator_cache::manipulators_t make_device_manipulators(const core_configuration::details::device& device,
+                                                                          const std::optional<nlohmann::json>& mouse_basic_json) const {
+    manipulator::manipulator_cache::manipulators_t manipulators;
+
+    //
+    // Add profile.device.simple_modifications
+    //
+
+    try {
+      for (const auto& m : manipulator::manipulator_factory::make_remap_manipulators(make_definitions(*device.get_simple_modifications()))) {
+        auto c = manipulator::condition_factory::make_device_if_condition(device);
+        m->push_back_condition(c);
+        manipulators.push_back(m);
+      }
 
-        auto swap = nlohmann::json::array();
-        if (device->get_mouse_swap_xy()) {
-          swap.push_back("xy");
-        }
-        if (device->get_mouse_swap_wheels()) {
-          swap.push_back("wheels");
-        }
+    } catch (const pqrs::json::unmarshal_error& e) {
+      logger::get_logger()->error(fmt::format("karabiner.json error: {0}", e.what()));
 
-        auto discard = nlohmann::json::array();
-        if (device->get_mouse_discard_x()) {
-          discard.push_back("x");
-        }
-        if (device->get_mouse_discard_y()) {
-          discard.push_back("y");
-        }
-        if (device->get_mouse_discard_vertical_wheel()) {
-          discard.push_back("vertical_wheel");
-        }
-        if (device->get_mouse_discard_horizontal_wheel()) {
-          discard.push_back("horizontal_wheel");
-        }
+    } catch (const std::exception& e) {
+      logger::get_logger()->error(e.what());
+    }
 
-        if (flip.size() > 0 || swap.size() > 0 || discard.size() > 0) {
-          try {
-            auto json = nlohmann::json::object({
-                {"type", "mouse_basic"},
-                {"flip", flip},
-                {"swap", swap},
-                {"discard", discard},
-            });
-            auto parameters = std::make_shared<krbn::core_configuration::details::complex_modifications_parameters>();
-            auto m = std::make_shared<manipulator::manipulators::mouse_basic::mouse_basic>(json,
-                                                                                           parameters);
-            auto c = manipulator::condition_factory::make_device_if_condition(*device);
-            m->push_back_condition(c);
-            manipulator_manager_->push_back_manipulator(m);
-          } catch (const std::exception& e) {
-            logger::get_logger()->error(e.what());
-          }
-        }
+    //
+    // Add profile.device.mouse_flip_*, mouse_swap_*
+    //
+
+    if (mouse_basic_json) {
+      try {
+        auto parameters = std::make_shared<krbn::core_configuration::details::complex_modifications_parameters>();
+        auto m = std::make_shared<manipulator::manipulators::mouse_basic::mouse_basic>(*mouse_basic_json,
+                                                                                       parameters);
+        auto c = manipulator::condition_factory::make_device_if_condition(device);
+        m->push_back_condition(c);
+        manipulators.push_back(m);
+      } catch (const std::exception& e) {
+        logger::get_logger()->error(e.what());
       }
     }
 
-    for (const auto& pair : profile.get_simple_modifications()->get_pairs()) {
-      if (auto m = make_manipulator(pair)) {
-        manipulator_manager_->push_back_manipulator(m);
-      }
+    return manipulators;
+  }
+
+  manipulator::manipulator_cache::manipulators_t make_profile_manipulators(const core_configuration::details::profile& profile) const {
+    return manipulator::manipulator_factory::make_remap_manipulators(make_definitions(*profile.get_simple_modifications()));
+  }
+
+  static std::optional<nlohmann::json> make_mouse_basic_json(const core_configuration::details::device& device) {
+    auto flip = nlohmann::json::array();
+    if (device.get_mouse_flip_x()) {
+      flip.push_back("x");
+    }
+    if (device.get_mouse_flip_y()) {
+      flip.push_back("y");
+    }
+    if (device.get_mouse_flip_vertical_wheel()) {
+      flip.push_back("vertical_wheel");
+    }
+    if (device.get_mouse_flip_horizontal_wheel()) {
+      flip.push_back("horizontal_wheel");
+    }
+
+    auto swap = nlohmann::json::array();
+    if (device.get_mouse_swap_xy()) {
+      swap.push_back("xy");
+    }
+    if (device.get_mouse_swap_wheels()) {
+      swap.push_back("wheels");
+    }
+
+    auto discard = nlohmann::json::array();
+    if (device.get_mouse_discard_x()) {
+      discard.push_back("x");
+    }
+    if (device.get_mouse_discard_y()) {
+      discard.push_back("y");
+    }
+    if (device.get_mouse_discard_vertical_wheel()) {
+      discard.push_back("vertical_wheel");
+    }
+    if (device.get_mouse_discard_horizontal_wheel()) {
+      discard.push_back("horizontal_wheel");
+    }
+
+    if (flip.size() > 0 || swap.size() > 0 || discard.size() > 0) {
+      return nlohmann::json::object({
+          {"type", "mouse_basic"},
+          {"flip", flip},
+          {"swap", swap},
+          {"discard", discard},
+      });
     }
+
+    return std::nullopt;
   }
 
-private:
-  std::shared_ptr<manipulator::manipulators::base> make_manipulator(const std::pair<std::string, std::string>& pair) const {
-    if (!pair.first.empty() && !pair.second.empty()) {
-      try {
-        auto from_json = json_utility::parse_jsonc(pair.first);
-        from_json["modifiers"]["optional"] = nlohmann::json::array();
-        from_json["modifiers"]["optional"].push_back("any");
-
-        auto to_json = json_utility::parse_jsonc(pair.second);
-        std::vector<gsl::not_null<std::shared_ptr<manipulator::to_event_definition>>> to_event_definitions;
-        for (auto&& j : to_json) {
-          to_event_definitions.push_back(std::make_shared<manipulator::to_event_definition>(j));
-        }
+  static std::vector<std::pair<manipulator::manipulators::basic::from_event_definition, manipulator::to_event_definitions>> make_definitions(const core_configuration::details::simple_modifications& simple_modifications) {
+    std::vector<std::pair<manipulator::manipulators::basic::from_event_definition, manipulator::to_event_definitions>> definitions;
 
-        return std::make_shared<manipulator::manipulators::basic::basic>(manipulator::manipulators::basic::from_event_definition(from_json),
-                                                                         to_event_definitions);
+    for (const auto& pair : simple_modifications.get_pairs()) {
+      if (!pair.first.empty() && !pair.second.empty()) {
+        try {
+          auto from_json = json_utility::parse_jsonc(pair.first);
+          from_json["modifiers"]["optional"] = nlohmann::json::array();
+          from_json["modifiers"]["optional"].push_back("any");
+
+          auto to_json = json_utility::parse_jsonc(pair.second);
+          manipulator::to_event_definitions to_event_definitions;
+          for (auto&& j : to_json) {
+            to_event_definitions.push_back(std::make_shared<manipulator::to_event_definition>(j));
+          }
 
-      } catch (const pqrs::json::unmarshal_error& e) {
-        logger::get_logger()->error(fmt::format("karabiner.json error: {0}", e.what()));
+          definitions.emplace_back(manipulator::manipulators::basic::from_event_definition(from_json),
+                                   to_event_definitions);
 
-      } catch (const std::exception& e) {
-        logger::get_logger()->error(e.what());
+        } catch (const pqrs::json::unmarshal_error& e) {
+          logger::get_logger()->error(fmt::format("karabiner.json error: {0}", e.what()));
+
+        } catch (const std::exception& e) {
+          logger::get_logger()->error(e.what());
+        }
       }
     }
-    return nullptr;
+
+    return definitions;
   }
 
   std::shared_ptr<manipulator::manipulator_manager> manipulator_manager_;
+  manipulator::manipulator_cache manipulator_cache_;
 };
 } // namespace device_grabber_details
 } // namespace grabber
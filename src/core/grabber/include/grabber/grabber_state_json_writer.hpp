@@ -15,6 +15,8 @@ public:
     set_driver_activated(std::nullopt);
     set_driver_connected(std::nullopt);
     set_driver_version_mismatched(std::nullopt);
+    set_pointing_motion_coalescing(std::nullopt);
+    set_coalesced_pointing_motion_count(std::nullopt);
   }
 
   void set_hid_device_open_permitted(std::optional<bool> value) {
@@ -33,6 +35,14 @@ public:
     state_json_writer_.set("driver_version_mismatched", value);
   }
 
+  void set_pointing_motion_coalescing(std::optional<bool> value) {
+    state_json_writer_.set("pointing_motion_coalescing", value);
+  }
+
+  void set_coalesced_pointing_motion_count(std::optional<size_t> value) {
+    state_json_writer_.set("coalesced_pointing_motion_count", value);
+  }
+
 private:
   krbn::state_json_writer state_json_writer_;
 };
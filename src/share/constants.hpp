@@ -18,6 +18,11 @@ class constants final {
 public:
   static constexpr size_t local_datagram_buffer_size = 32 * 1024;
 
+  // device_grabber merges pending pointing_motion events while the input event queue is backlogged.
+  // Merging starts when the queue size exceeds the start size, and stops when the queue size falls to the stop size.
+  static constexpr size_t pointing_motion_coalescing_start_queue_size = 256;
+  static constexpr size_t pointing_motion_coalescing_stop_queue_size = 32;
+
   static const std::filesystem::path& get_version_file_path(void) {
     static auto path = std::filesystem::path("/Library/Application Support/org.pqrs/Karabiner-Elements/version");
     return path;
@@ -49,6 +49,10 @@ public:
                                          reorder_same_timestamp_input_events_to_prioritize_modifiers_,
                                          true);
 
+    helper_values_.push_back_value<bool>("coalesce_pointing_input_reports",
+                                         coalesce_pointing_input_reports_,
+                                         false);
+
     pqrs::json::requires_object(json, "json");
 
     helper_values_.update_value(json, error_handling);
@@ -125,6 +129,13 @@ public:
     reorder_same_timestamp_input_events_to_prioritize_modifiers_ = value;
   }
 
+  const bool& get_coalesce_pointing_input_reports(void) const {
+    return coalesce_pointing_input_reports_;
+  }
+  void set_coalesce_pointing_input_reports(bool value) {
+    coalesce_pointing_input_reports_ = value;
+  }
+
 private:
   nlohmann::json json_;
   bool check_for_updates_on_startup_;
@@ -136,6 +147,7 @@ private:
   bool unsafe_ui_;
   bool filter_useless_events_from_specific_devices_;
   bool reorder_same_timestamp_input_events_to_prioritize_modifiers_;
+  bool coalesce_pointing_input_reports_;
   configuration_json_helper::helper_values helper_values_;
 };
 
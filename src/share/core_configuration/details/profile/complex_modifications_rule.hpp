@@ -1,6 +1,7 @@
 #pragma once
 
 #include "complex_modifications_parameters.hpp"
+#include <pqrs/hash.hpp>
 #include <pqrs/json.hpp>
 
 namespace krbn {
@@ -83,7 +84,8 @@ public:
   complex_modifications_rule(const nlohmann::json& json,
                              gsl::not_null<std::shared_ptr<const core_configuration::details::complex_modifications_parameters>> parameters,
                              error_handling error_handling)
-      : json_(json) {
+      : json_(json),
+        content_hash_(0) {
     helper_values_.push_back_value<bool>("enabled",
                                          enabled_,
                                          true);
@@ -134,6 +136,15 @@ public:
         }
       }
     }
+
+    // `parameters` are inherited by manipulators, so they are a part of the content.
+    auto content_json = json_;
+    content_json.erase("enabled");
+    content_json_ = nlohmann::json::object({
+        {"rule", content_json},
+        {"parameters", parameters->to_json()},
+    });
+    pqrs::hash::combine(content_hash_, content_json_);
   }
 
   nlohmann::json to_json(void) const {
@@ -160,8 +171,21 @@ public:
     return description_;
   }
 
+  // The hash of the rule content which affects manipulators (`enabled` is not included).
+  // Manipulators built from rules which have the same hash are interchangeable.
+  size_t get_content_hash(void) const {
+    return content_hash_;
+  }
+
+  // The rule content which `get_content_hash` is calculated from.
+  const nlohmann::json& get_content_json(void) const {
+    return content_json_;
+  }
+
 private:
   nlohmann::json json_;
+  nlohmann::json content_json_;
+  size_t content_hash_;
   std::vector<gsl::not_null<std::shared_ptr<manipulator>>> manipulators_;
   bool enabled_;
   std::string description_;
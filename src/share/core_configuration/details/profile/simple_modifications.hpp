@@ -2,6 +2,7 @@
 
 #include "json_utility.hpp"
 #include <natural_sort.hpp>
+#include <pqrs/hash.hpp>
 
 namespace krbn {
 namespace core_configuration {
@@ -65,6 +66,24 @@ public:
     return pairs_;
   }
 
+  // The hash of `pairs_`.
+  // (`pairs_` can be changed via `push_back_pair`, `replace_pair`, etc., so the hash is not cached.)
+  size_t get_content_hash(void) const {
+    size_t h = 0;
+
+    for (const auto& [from, to] : pairs_) {
+      pqrs::hash::combine(h, from);
+      pqrs::hash::combine(h, to);
+    }
+
+    return h;
+  }
+
+  // The content which `get_content_hash` is calculated from.
+  nlohmann::json get_content_json(void) const {
+    return pairs_;
+  }
+
   void update(const nlohmann::json& json) {
     handle_json(json);
   }
@@ -1,43 +1,86 @@
 #pragma once
 
 #include "device_properties.hpp"
+#include <optional>
 #include <unordered_map>
+#include <vector>
 
 namespace krbn {
+// `device_properties_manager` stores device_properties in a flat vector.
+// Each device gets a dense index when it is inserted (grabbed), and the index is reused after the device is erased (ungrabbed).
+//
+// The shared_ptr is held only while the device is inserted.
+// `find` returns a non-owning pointer in order to avoid the reference count updates on every event.
+// The pointer is valid until the device is erased or replaced.
 class device_properties_manager final {
 public:
+  using index = size_t;
+
   device_properties_manager(const device_properties_manager&) = delete;
 
   device_properties_manager(void) {
   }
 
-  const std::unordered_map<device_id, std::shared_ptr<device_properties>>& get_map(void) const {
-    return map_;
+  // Returns all slots. Slots of erased devices are nullptr.
+  const std::vector<std::shared_ptr<device_properties>>& get_device_properties(void) const {
+    return device_properties_;
   }
 
   void insert(device_id key,
               gsl::not_null<std::shared_ptr<device_properties>> value) {
-    map_[key] = value;
+    auto it = indices_.find(key);
+    if (it != std::end(indices_)) {
+      device_properties_[it->second] = value;
+      return;
+    }
+
+    index i = device_properties_.size();
+    if (!free_indices_.empty()) {
+      i = free_indices_.back();
+      free_indices_.pop_back();
+      device_properties_[i] = value;
+    } else {
+      device_properties_.push_back(value);
+    }
+
+    indices_[key] = i;
   }
 
   void erase(device_id key) {
-    map_.erase(key);
+    auto it = indices_.find(key);
+    if (it != std::end(indices_)) {
+      device_properties_[it->second] = nullptr;
+      free_indices_.push_back(it->second);
+      indices_.erase(it);
+    }
   }
 
   void clear(void) {
-    map_.clear();
+    device_properties_.clear();
+    indices_.clear();
+    free_indices_.clear();
   }
 
-  std::shared_ptr<device_properties> find(device_id key) const {
-    auto it = map_.find(key);
-    if (it != std::end(map_)) {
+  std::optional<index> find_index(device_id key) const {
+    auto it = indices_.find(key);
+    if (it != std::end(indices_)) {
       return it->second;
     }
+    return std::nullopt;
+  }
+
+  const device_properties* find(device_id key) const {
+    auto it = indices_.find(key);
+    if (it != std::end(indices_)) {
+      return device_properties_[it->second].get();
+    }
     return nullptr;
   }
 
 private:
-  // std::unordered_map<T1, gsl::not_null<T2>> results in a build error because gsl::not_null<T2> is not hashable. Therefore, we will not use gsl::not_null here.
-  std::unordered_map<device_id, std::shared_ptr<device_properties>> map_;
+  // std::vector<gsl::not_null<T>> cannot have empty slots. Therefore, we will not use gsl::not_null here.
+  std::vector<std::shared_ptr<device_properties>> device_properties_;
+  std::unordered_map<device_id, index> indices_;
+  std::vector<index> free_indices_;
 };
 } // namespace krbn
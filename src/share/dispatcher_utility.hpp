@@ -2,6 +2,7 @@
 
 // `krbn::dispatcher_utility` can be used safely in a multi-threaded environment.
 
+#include "timer_wheel.hpp"
 #include <pqrs/dispatcher.hpp>
 
 namespace krbn {
@@ -11,6 +12,7 @@ public:
   public:
     scoped_dispatcher_manager(void) {
       pqrs::dispatcher::extra::initialize_shared_dispatcher();
+      initialize_shared_timer_wheel();
 
       {
         std::lock_guard<std::mutex> lock(get_file_writer_mutex());
@@ -22,6 +24,7 @@ public:
     }
 
     ~scoped_dispatcher_manager(void) {
+      terminate_shared_timer_wheel();
       pqrs::dispatcher::extra::terminate_shared_dispatcher();
 
       {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "event_queue/entries_pool.hpp"
 #include "event_queue/entry.hpp"
 #include "event_queue/event.hpp"
 #include "event_queue/event_time_stamp.hpp"
@@ -0,0 +1,116 @@
+#pragma once
+
+// `krbn::event_queue::entries_pool` is not thread-safe.
+
+#include "entry.hpp"
+#include <gsl/gsl>
+#include <memory>
+#include <vector>
+
+namespace krbn {
+namespace event_queue {
+
+// An object pool for the entries which are made from hid values on every hid queue callback.
+//
+// Entries and batch containers are handed out as shared_ptr and returned to the pool implicitly:
+// an object is reused when the pool holds the last reference to it.
+// Thus, the pool have to be used in a single thread (e.g., the shared dispatcher thread).
+class entries_pool final {
+public:
+  entries_pool(size_t max_entry_count = 256,
+               size_t max_entries_count = 8)
+      : max_entry_count_(max_entry_count),
+        max_entries_count_(max_entries_count),
+        entry_cursor_(0),
+        entry_allocation_count_(0),
+        entry_reuse_count_(0),
+        entries_allocation_count_(0),
+        entries_reuse_count_(0) {
+  }
+
+  entries_pool(const entries_pool&) = delete;
+
+  // Returns an empty batch container.
+  not_null_entries_ptr_t make_entries(void) {
+    std::shared_ptr<std::vector<not_null_const_entry_ptr_t>> result;
+
+    for (const auto& e : entries_) {
+      if (e.use_count() == 1) {
+        // Unused containers are cleared in order to release their entries to `make_entry`.
+        // The capacity is kept.
+        e->clear();
+
+        if (!result) {
+          result = e;
+        }
+      }
+    }
+
+    if (result) {
+      ++entries_reuse_count_;
+      return result;
+    }
+
+    auto e = std::make_shared<std::vector<not_null_const_entry_ptr_t>>();
+    ++entries_allocation_count_;
+
+    if (entries_.size() < max_entries_count_) {
+      entries_.push_back(e);
+    }
+
+    return e;
+  }
+
+  template <typename... Args>
+  not_null_const_entry_ptr_t make_entry(Args&&... args) {
+    for (size_t i = 0; i < entry_pool_.size(); ++i) {
+      auto index = (entry_cursor_ + i) % entry_pool_.size();
+      auto& e = entry_pool_[index];
+      if (e.use_count() == 1) {
+        *e = entry(std::forward<Args>(args)...);
+        entry_cursor_ = index + 1;
+        ++entry_reuse_count_;
+        return e;
+      }
+    }
+
+    auto e = std::make_shared<entry>(std::forward<Args>(args)...);
+    ++entry_allocation_count_;
+
+    if (entry_pool_.size() < max_entry_count_) {
+      entry_pool_.push_back(e);
+    }
+
+    return e;
+  }
+
+  size_t get_entry_allocation_count(void) const {
+    return entry_allocation_count_;
+  }
+
+  size_t get_entry_reuse_count(void) const {
+    return entry_reuse_count_;
+  }
+
+  size_t get_entries_allocation_count(void) const {
+    return entries_allocation_count_;
+  }
+
+  size_t get_entries_reuse_count(void) const {
+    return entries_reuse_count_;
+  }
+
+private:
+  size_t max_entry_count_;
+  size_t max_entries_count_;
+  std::vector<std::shared_ptr<entry>> entry_pool_;
+  std::vector<std::shared_ptr<std::vector<not_null_const_entry_ptr_t>>> entries_;
+  size_t entry_cursor_;
+  size_t entry_allocation_count_;
+  size_t entry_reuse_count_;
+  size_t entries_allocation_count_;
+  size_t entries_reuse_count_;
+};
+
+} // namespace event_queue
+} // namespace krbn
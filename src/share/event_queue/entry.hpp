@@ -1,6 +1,7 @@
 #pragma once
 
-// `krbn::event_queue::entry` can be used safely in a multi-threaded environment.
+// `krbn::event_queue::entry` is not thread-safe.
+// Entries are owned by `event_queue::queue` and `event_queue::entries_pool`, and they are used only in the dispatcher thread.
 
 #include "event.hpp"
 #include "event_time_stamp.hpp"
@@ -29,26 +30,15 @@ public:
         validity_(validity),
         state_(state),
         lazy_(lazy),
-        event_(event),
         event_type_(event_type),
+        event_(event),
         original_event_(original_event) {
   }
 
-  entry& operator=(const entry& other) {
-    device_id_ = other.device_id_;
-    event_time_stamp_ = other.event_time_stamp_;
-    validity_ = other.validity_;
-    state_ = other.state_;
-    lazy_ = other.lazy_;
-    event_ = other.event_;
-    event_type_ = other.event_type_;
-    original_event_ = other.original_event_;
-    return *this;
-  }
-
-  entry(const entry& other) {
-    *this = other;
-  }
+  entry(const entry&) = default;
+  entry(entry&&) = default;
+  entry& operator=(const entry&) = default;
+  entry& operator=(entry&&) = default;
 
   static entry make_from_json(const nlohmann::json& json) {
     entry result(device_id(0),
@@ -98,13 +88,13 @@ public:
   // Methods
 
   device_id get_device_id(void) const {
-    // We don't have to use mutex since there is not setter.
+    // We don't have to use atomic since there is not setter.
 
     return device_id_;
   }
 
   const event_time_stamp& get_event_time_stamp(void) const {
-    // We don't have to use mutex since there is not setter.
+    // We don't have to use atomic since there is not setter.
 
     return event_time_stamp_;
   }
@@ -114,55 +104,43 @@ public:
   }
 
   validity get_validity(void) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     return validity_;
   }
 
   void set_validity(validity value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     validity_ = value;
   }
 
   state get_state(void) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     return state_;
   }
 
   void set_state(state value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     state_ = value;
   }
 
   bool get_lazy(void) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     return lazy_;
   }
 
   void set_lazy(bool value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     lazy_ = value;
   }
 
   const event& get_event(void) const {
-    // We don't have to use mutex since there is not setter.
+    // We don't have to use atomic since there is not setter.
 
     return event_;
   }
 
   event_type get_event_type(void) const {
-    // We don't have to use mutex since there is not setter.
+    // We don't have to use atomic since there is not setter.
 
     return event_type_;
   }
 
   const event& get_original_event(void) const {
-    // We don't have to use mutex since there is not setter.
+    // We don't have to use atomic since there is not setter.
 
     return original_event_;
   }
@@ -214,12 +192,14 @@ private:
   state state_;
 
   bool lazy_;
-  event event_;
   event_type event_type_;
+  event event_;
   event original_event_;
-  mutable std::mutex mutex_;
 };
 
+// Keep entries within two cache lines since `queue` copies them on each manipulation stage.
+static_assert(sizeof(entry) <= 128);
+
 inline void to_json(nlohmann::json& json, const entry& value) {
   json = value.to_json();
 }
@@ -43,25 +43,29 @@ public:
     virtual_hid_devices_state_changed,
   };
 
-  using value_t = std::variant<momentary_switch_event,                                   // For type::momentary_switch_event
-                               pointing_motion,                                          // For type::pointing_motion
-                               int64_t,                                                  // For type::caps_lock_state_changed
-                               std::string,                                              // For shell_command
-                               std::vector<pqrs::osx::input_source_selector::specifier>, // For select_input_source
-                               manipulator_environment_variable_set_variable,            // For set_variable
-                               notification_message,                                     // For set_notification_message
-                               mouse_key,                                                // For mouse_key
-                               std::pair<modifier_flag, sticky_modifier_type>,           // For sticky_modifier
-                               software_function,                                        // For software_function
-                               pqrs::osx::frontmost_application_monitor::application,    // For frontmost_application_changed
-                               pqrs::osx::input_source::properties,                      // For input_source_changed
-                               gsl::not_null<std::shared_ptr<device_properties>>,        // For device_grabbed
-                               pqrs::osx::system_preferences::properties,                // For system_preferences_properties_changed
-                               virtual_hid_devices_state,                                // For virtual_hid_devices_state_changed
-                               std::monostate>;                                          // For virtual events
-
-  event(void) : type_(type::none),
-                value_(std::monostate()) {
+  // Small alternatives are stored inline.
+  using inline_value_t = std::variant<momentary_switch_event,                         // For type::momentary_switch_event
+                                      pointing_motion,                                // For type::pointing_motion
+                                      int64_t,                                        // For type::caps_lock_state_changed
+                                      std::pair<modifier_flag, sticky_modifier_type>, // For sticky_modifier
+                                      virtual_hid_devices_state,                      // For virtual_hid_devices_state_changed
+                                      mouse_key,                                      // For mouse_key
+                                      std::monostate>;                                // For virtual events
+
+  // Heavyweight alternatives are stored out of line in shared immutable storage
+  // in order to keep `event` (and `entry` which has two events) compact and cheap to copy.
+  using shared_value_t = std::variant<std::string,                                              // For shell_command
+                                      std::vector<pqrs::osx::input_source_selector::specifier>, // For select_input_source
+                                      manipulator_environment_variable_set_variable,            // For set_variable
+                                      notification_message,                                     // For set_notification_message
+                                      software_function,                                        // For software_function
+                                      pqrs::osx::frontmost_application_monitor::application,    // For frontmost_application_changed
+                                      pqrs::osx::input_source::properties,                      // For input_source_changed
+                                      gsl::not_null<std::shared_ptr<device_properties>>,        // For device_grabbed
+                                      pqrs::osx::system_preferences::properties>;               // For system_preferences_properties_changed
+
+  event(void) : inline_value_(std::monostate()),
+                type_(type::none) {
   }
 
   static event make_from_json(const nlohmann::json& json) {
@@ -73,33 +77,33 @@ public:
           if (key == "type") {
             result.type_ = to_type(value.get<std::string>());
           } else if (key == "momentary_switch_event") {
-            result.value_ = value.get<momentary_switch_event>();
+            result.set_value(value.get<momentary_switch_event>());
           } else if (key == "pointing_motion") {
-            result.value_ = value.get<pointing_motion>();
+            result.set_value(value.get<pointing_motion>());
           } else if (key == "caps_lock_state_changed") {
-            result.value_ = value.get<int64_t>();
+            result.set_value(value.get<int64_t>());
           } else if (key == "shell_command") {
-            result.value_ = value.get<std::string>();
+            result.set_value(value.get<std::string>());
           } else if (key == "input_source_specifiers") {
-            result.value_ = value.get<std::vector<pqrs::osx::input_source_selector::specifier>>();
+            result.set_value(value.get<std::vector<pqrs::osx::input_source_selector::specifier>>());
           } else if (key == "set_variable") {
-            result.value_ = value.get<manipulator_environment_variable_set_variable>();
+            result.set_value(value.get<manipulator_environment_variable_set_variable>());
           } else if (key == "set_notification_message") {
-            result.value_ = value.get<notification_message>();
+            result.set_value(value.get<notification_message>());
           } else if (key == "mouse_key") {
-            result.value_ = value.get<mouse_key>();
+            result.set_value(value.get<mouse_key>());
           } else if (key == "sticky_modifier") {
-            result.value_ = value.get<std::pair<modifier_flag, sticky_modifier_type>>();
+            result.set_value(value.get<std::pair<modifier_flag, sticky_modifier_type>>());
           } else if (key == "software_function") {
-            result.value_ = value.get<software_function>();
+            result.set_value(value.get<software_function>());
           } else if (key == "frontmost_application") {
-            result.value_ = value.get<pqrs::osx::frontmost_application_monitor::application>();
+            result.set_value(value.get<pqrs::osx::frontmost_application_monitor::application>());
           } else if (key == "input_source_properties") {
-            result.value_ = value.get<pqrs::osx::input_source::properties>();
+            result.set_value(value.get<pqrs::osx::input_source::properties>());
           } else if (key == "system_preferences_properties") {
-            result.value_ = value.get<pqrs::osx::system_preferences::properties>();
+            result.set_value(value.get<pqrs::osx::system_preferences::properties>());
           } else if (key == "virtual_hid_devices_state") {
-            result.value_ = value.get<virtual_hid_devices_state>();
+            result.set_value(value.get<virtual_hid_devices_state>());
           }
         }
       }
@@ -190,13 +194,13 @@ public:
         break;
 
       case type::system_preferences_properties_changed:
-        if (auto v = std::get_if<pqrs::osx::system_preferences::properties>(&value_)) {
+        if (auto v = get_if<pqrs::osx::system_preferences::properties>()) {
           json["system_preferences_properties"] = *v;
         }
         break;
 
       case type::virtual_hid_devices_state_changed:
-        if (auto v = std::get_if<virtual_hid_devices_state>(&value_)) {
+        if (auto v = get_if<virtual_hid_devices_state>()) {
           json["virtual_hid_devices_state"] = *v;
         }
         break;
@@ -212,53 +216,53 @@ public:
     return json;
   }
 
-  explicit event(momentary_switch_event momentary_switch_event) : type_(type::momentary_switch_event),
-                                                                  value_(momentary_switch_event) {
+  explicit event(momentary_switch_event momentary_switch_event) : inline_value_(momentary_switch_event),
+                                                                  type_(type::momentary_switch_event) {
   }
 
-  explicit event(const pointing_motion& pointing_motion) : type_(type::pointing_motion),
-                                                           value_(pointing_motion) {
+  explicit event(const pointing_motion& pointing_motion) : inline_value_(pointing_motion),
+                                                           type_(type::pointing_motion) {
   }
 
   static event make_shell_command_event(const std::string& shell_command) {
     event e;
     e.type_ = type::shell_command;
-    e.value_ = shell_command;
+    e.set_value(shell_command);
     return e;
   }
 
   static event make_select_input_source_event(const std::vector<pqrs::osx::input_source_selector::specifier>& input_source_specifiers) {
     event e;
     e.type_ = type::select_input_source;
-    e.value_ = input_source_specifiers;
+    e.set_value(input_source_specifiers);
     return e;
   }
 
   static event make_set_variable_event(const manipulator_environment_variable_set_variable& value) {
     event e;
     e.type_ = type::set_variable;
-    e.value_ = value;
+    e.set_value(value);
     return e;
   }
 
   static event make_set_notification_message_event(const notification_message& value) {
     event e;
     e.type_ = type::set_notification_message;
-    e.value_ = value;
+    e.set_value(value);
     return e;
   }
 
   static event make_mouse_key_event(const mouse_key& mouse_key) {
     event e;
     e.type_ = type::mouse_key;
-    e.value_ = mouse_key;
+    e.set_value(mouse_key);
     return e;
   }
 
   static event make_sticky_modifier_event(const std::pair<modifier_flag, sticky_modifier_type>& value) {
     event e;
     e.type_ = type::sticky_modifier;
-    e.value_ = value;
+    e.set_value(value);
     return e;
   }
 
@@ -269,7 +273,7 @@ public:
   static event make_software_function_event(const software_function& value) {
     event e;
     e.type_ = type::software_function;
-    e.value_ = value;
+    e.set_value(value);
     return e;
   }
 
@@ -284,7 +288,7 @@ public:
   static event make_device_grabbed_event(gsl::not_null<std::shared_ptr<device_properties>> device_properties) {
     event e;
     e.type_ = type::device_grabbed;
-    e.value_ = device_properties;
+    e.set_value(device_properties);
     return e;
   }
 
@@ -295,7 +299,7 @@ public:
   static event make_caps_lock_state_changed_event(int64_t state) {
     event e;
     e.type_ = type::caps_lock_state_changed;
-    e.value_ = state;
+    e.set_value(state);
     return e;
   }
 
@@ -306,28 +310,28 @@ public:
   static event make_frontmost_application_changed_event(const pqrs::osx::frontmost_application_monitor::application& application) {
     event e;
     e.type_ = type::frontmost_application_changed;
-    e.value_ = application;
+    e.set_value(application);
     return e;
   }
 
   static event make_input_source_changed_event(const pqrs::osx::input_source::properties& properties) {
     event e;
     e.type_ = type::input_source_changed;
-    e.value_ = properties;
+    e.set_value(properties);
     return e;
   }
 
   static event make_system_preferences_properties_changed_event(const pqrs::osx::system_preferences::properties& properties) {
     event e;
     e.type_ = type::system_preferences_properties_changed;
-    e.value_ = properties;
+    e.set_value(properties);
     return e;
   }
 
   static event make_virtual_hid_devices_state_changed_event(const virtual_hid_devices_state& virtual_hid_devices_state) {
     event e;
     e.type_ = type::virtual_hid_devices_state_changed;
-    e.value_ = virtual_hid_devices_state;
+    e.set_value(virtual_hid_devices_state);
     return e;
   }
 
@@ -335,115 +339,110 @@ public:
     return type_;
   }
 
-  const value_t& get_value(void) const {
-    return value_;
+  const inline_value_t& get_inline_value(void) const {
+    return inline_value_;
+  }
+
+  const std::shared_ptr<const shared_value_t>& get_shared_value(void) const {
+    return shared_value_;
   }
 
   template <typename T>
   const T* get_if(void) const {
-    return std::get_if<T>(&value_);
+    if constexpr (is_alternative<T, inline_value_t>::value) {
+      return std::get_if<T>(&inline_value_);
+    } else {
+      if (shared_value_) {
+        return std::get_if<T>(shared_value_.get());
+      }
+      return nullptr;
+    }
   }
 
   std::optional<pointing_motion> get_pointing_motion(void) const {
-    try {
-      if (type_ == type::pointing_motion) {
-        return std::get<pointing_motion>(value_);
-      }
-    } catch (std::bad_variant_access&) {
-    }
-    return std::nullopt;
+    return get_optional<pointing_motion>(type::pointing_motion);
   }
 
   std::optional<int64_t> get_integer_value(void) const {
-    try {
-      if (type_ == type::caps_lock_state_changed) {
-        return std::get<int64_t>(value_);
-      }
-    } catch (std::bad_variant_access&) {
-    }
-    return std::nullopt;
+    return get_optional<int64_t>(type::caps_lock_state_changed);
   }
 
   std::optional<std::string> get_shell_command(void) const {
-    try {
-      if (type_ == type::shell_command) {
-        return std::get<std::string>(value_);
-      }
-    } catch (std::bad_variant_access&) {
-    }
-    return std::nullopt;
+    return get_optional<std::string>(type::shell_command);
   }
 
   std::optional<std::vector<pqrs::osx::input_source_selector::specifier>> get_input_source_specifiers(void) const {
-    try {
-      if (type_ == type::select_input_source) {
-        return std::get<std::vector<pqrs::osx::input_source_selector::specifier>>(value_);
-      }
-    } catch (std::bad_variant_access&) {
-    }
-    return std::nullopt;
+    return get_optional<std::vector<pqrs::osx::input_source_selector::specifier>>(type::select_input_source);
   }
 
   std::optional<manipulator_environment_variable_set_variable> get_set_variable(void) const {
-    try {
-      if (type_ == type::set_variable) {
-        return std::get<manipulator_environment_variable_set_variable>(value_);
-      }
-    } catch (std::bad_variant_access&) {
-    }
-    return std::nullopt;
+    return get_optional<manipulator_environment_variable_set_variable>(type::set_variable);
   }
 
   std::optional<mouse_key> get_mouse_key(void) const {
-    try {
-      if (type_ == type::mouse_key) {
-        return std::get<mouse_key>(value_);
-      }
-    } catch (std::bad_variant_access&) {
-    }
-    return std::nullopt;
+    return get_optional<mouse_key>(type::mouse_key);
   }
 
   std::optional<std::pair<modifier_flag, sticky_modifier_type>> get_sticky_modifier(void) const {
-    try {
-      if (type_ == type::sticky_modifier) {
-        return std::get<std::pair<modifier_flag, sticky_modifier_type>>(value_);
-      }
-    } catch (std::bad_variant_access&) {
-    }
-    return std::nullopt;
+    return get_optional<std::pair<modifier_flag, sticky_modifier_type>>(type::sticky_modifier);
   }
 
   std::optional<pqrs::osx::frontmost_application_monitor::application> get_frontmost_application(void) const {
-    try {
-      if (type_ == type::frontmost_application_changed) {
-        return std::get<pqrs::osx::frontmost_application_monitor::application>(value_);
-      }
-    } catch (std::bad_variant_access&) {
-    }
-    return std::nullopt;
+    return get_optional<pqrs::osx::frontmost_application_monitor::application>(type::frontmost_application_changed);
   }
 
   std::optional<pqrs::osx::input_source::properties> get_input_source_properties(void) const {
-    try {
-      if (type_ == type::input_source_changed) {
-        return std::get<pqrs::osx::input_source::properties>(value_);
-      }
-    } catch (std::bad_variant_access&) {
-    }
-    return std::nullopt;
+    return get_optional<pqrs::osx::input_source::properties>(type::input_source_changed);
   }
 
   bool operator==(const event& other) const {
-    return get_type() == other.get_type() &&
-           value_ == other.value_;
+    if (get_type() != other.get_type() ||
+        inline_value_ != other.inline_value_) {
+      return false;
+    }
+
+    if (shared_value_ == other.shared_value_) {
+      return true;
+    }
+
+    if (shared_value_ && other.shared_value_) {
+      return *shared_value_ == *(other.shared_value_);
+    }
+
+    return false;
   }
 
 private:
+  template <typename T, typename V>
+  struct is_alternative;
+
+  template <typename T, typename... Ts>
+  struct is_alternative<T, std::variant<Ts...>> : std::disjunction<std::is_same<T, Ts>...> {};
+
+  template <typename T>
+  void set_value(const T& value) {
+    if constexpr (is_alternative<T, inline_value_t>::value) {
+      inline_value_ = value;
+      shared_value_ = nullptr;
+    } else {
+      inline_value_ = std::monostate();
+      shared_value_ = std::make_shared<const shared_value_t>(value);
+    }
+  }
+
+  template <typename T>
+  std::optional<T> get_optional(type t) const {
+    if (type_ == t) {
+      if (auto v = get_if<T>()) {
+        return *v;
+      }
+    }
+    return std::nullopt;
+  }
+
   static event make_virtual_event(type type) {
     event e;
     e.type_ = type;
-    e.value_ = std::monostate();
     return e;
   }
 
@@ -513,8 +512,11 @@ private:
     return type::none;
   }
 
+  // `type_` is placed in the tail padding of `inline_value_` (after the variant index)
+  // so that `mouse_key` can be stored inline without growing `event`.
+  [[no_unique_address]] inline_value_t inline_value_;
   type type_;
-  value_t value_;
+  std::shared_ptr<const shared_value_t> shared_value_;
 };
 
 inline void to_json(nlohmann::json& json, const event& value) {
@@ -530,7 +532,10 @@ struct hash<krbn::event_queue::event> final {
     std::size_t h = 0;
 
     pqrs::hash::combine(h, value.get_type());
-    pqrs::hash::combine(h, value.get_value());
+    pqrs::hash::combine(h, value.get_inline_value());
+    if (auto& v = value.get_shared_value()) {
+      pqrs::hash::combine(h, *v);
+    }
 
     return h;
   }
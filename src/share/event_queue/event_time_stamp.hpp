@@ -1,6 +1,7 @@
 #pragma once
 
-// `krbn::event_queue::event_time_stamp` can be used safely in a multi-threaded environment.
+// `krbn::event_queue::event_time_stamp` is not thread-safe.
+// (It is a part of `event_queue::entry`, which is used only in the dispatcher thread.)
 
 #include "types.hpp"
 #include <ostream>
@@ -25,16 +26,6 @@ public:
                                                                   input_delay_duration_(input_delay_duration) {
   }
 
-  event_time_stamp& operator=(const event_time_stamp& other) {
-    time_stamp_ = other.get_time_stamp();
-    input_delay_duration_ = other.get_input_delay_duration();
-    return *this;
-  }
-
-  event_time_stamp(const event_time_stamp& other) {
-    *this = other;
-  }
-
   static event_time_stamp make_from_json(const nlohmann::json& json) {
     event_time_stamp result(absolute_time_point(0),
                             absolute_time_duration(0));
@@ -53,32 +44,22 @@ public:
   // Methods
 
   absolute_time_point get_time_stamp(void) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     return time_stamp_;
   }
 
   void set_time_stamp(absolute_time_point value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     time_stamp_ = value;
   }
 
   absolute_time_duration get_input_delay_duration(void) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     return input_delay_duration_;
   }
 
   void set_input_delay_duration(absolute_time_duration value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     input_delay_duration_ = value;
   }
 
   absolute_time_point make_time_stamp_with_input_delay(void) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     return time_stamp_ + input_delay_duration_;
   }
 
@@ -101,7 +82,6 @@ public:
 private:
   absolute_time_point time_stamp_;
   absolute_time_duration input_delay_duration_;
-  mutable std::mutex mutex_;
 };
 
 inline std::ostream& operator<<(std::ostream& stream, const event_time_stamp& value) {
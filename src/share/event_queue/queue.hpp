@@ -5,7 +5,12 @@
 #include "event_queue/event_time_stamp.hpp"
 #include "modifier_flag_manager.hpp"
 #include "pointing_button_manager.hpp"
+#include "ring_buffer.hpp"
+#include <algorithm>
+#include <limits>
+#include <optional>
 #include <string_view>
+#include <vector>
 
 namespace krbn {
 namespace event_queue {
@@ -13,7 +18,8 @@ class queue {
 public:
   queue(const queue&) = delete;
 
-  queue(void) : time_stamp_delay_(0) {
+  queue(void) : sorted_size_(0),
+                time_stamp_delay_(0) {
   }
 
   void emplace_back_entry(device_id device_id,
@@ -27,141 +33,14 @@ public:
     auto t = event_time_stamp;
     t.set_time_stamp(t.get_time_stamp() + time_stamp_delay_);
 
-    events_.emplace_back(device_id,
-                         t,
-                         event,
-                         event_type,
-                         original_event,
-                         state,
-                         lazy,
-                         validity);
-
-    //
-    // Update modifier_flag_manager, pointing_button_manager
-    //
-
-    if (auto e = event.get_if<momentary_switch_event>()) {
-      if (auto modifier_flag = e->make_modifier_flag()) {
-        auto type = (event_type == event_type::key_down ? modifier_flag_manager::active_modifier_flag::type::increase
-                                                        : modifier_flag_manager::active_modifier_flag::type::decrease);
-        modifier_flag_manager::active_modifier_flag active_modifier_flag(type,
-                                                                         *modifier_flag,
-                                                                         device_id);
-        modifier_flag_manager_.push_back_active_modifier_flag(active_modifier_flag);
-      }
-
-      if (e->pointing_button()) {
-        auto type = (event_type == event_type::key_down ? pointing_button_manager::active_pointing_button::type::increase
-                                                        : pointing_button_manager::active_pointing_button::type::decrease);
-        pointing_button_manager::active_pointing_button active_pointing_button(type,
-                                                                               e->get_usage_pair(),
-                                                                               device_id);
-        pointing_button_manager_.push_back_active_pointing_button(active_pointing_button);
-      }
-
-      // Erase sticky modifiers
-      if (event_type == event_type::key_down &&
-          validity == validity::valid &&
-          !e->modifier_flag()) {
-        modifier_flag_manager_.erase_all_sticky_modifier_flags();
-      }
-
-    } else if (event.get_type() == event::type::sticky_modifier) {
-      if (event_type == event_type::key_down || event_type == event_type::single) {
-        if (auto sticky_modifier = event.get_sticky_modifier()) {
-          auto type = modifier_flag_manager::active_modifier_flag::type::increase_sticky;
-
-          if (sticky_modifier->second == sticky_modifier_type::toggle) {
-            if (modifier_flag_manager_.sticky_size(sticky_modifier->first) > 0) {
-              type = modifier_flag_manager::active_modifier_flag::type::decrease_sticky;
-            }
-          } else {
-            if (sticky_modifier->second != sticky_modifier_type::on) {
-              type = modifier_flag_manager::active_modifier_flag::type::decrease_sticky;
-            }
-          }
-
-          modifier_flag_manager::active_modifier_flag active_modifier_flag(type,
-                                                                           sticky_modifier->first,
-                                                                           device_id);
-          modifier_flag_manager_.push_back_active_modifier_flag(active_modifier_flag);
-        }
-      }
-
-    } else if (event.get_type() == event::type::caps_lock_state_changed) {
-      if (auto integer_value = event.get_integer_value()) {
-        auto type = (*integer_value ? modifier_flag_manager::active_modifier_flag::type::increase_led_lock
-                                    : modifier_flag_manager::active_modifier_flag::type::decrease_led_lock);
-        modifier_flag_manager::active_modifier_flag active_modifier_flag(type,
-                                                                         modifier_flag::caps_lock,
-                                                                         device_id);
-        modifier_flag_manager_.push_back_active_modifier_flag(active_modifier_flag);
-      }
-    }
-
-    //
-    // Update manipulator_environment
-    //
-
-    if (event.get_type() == event::type::device_grabbed) {
-      if (auto v = event.get_if<gsl::not_null<std::shared_ptr<device_properties>>>()) {
-        manipulator_environment_.insert_device_properties(device_id, *v);
-      }
-    }
-    if (event.get_type() == event::type::device_ungrabbed) {
-      manipulator_environment_.erase_device_properties(device_id);
-    }
-    if (auto frontmost_application = event.get_frontmost_application()) {
-      manipulator_environment_.set_frontmost_application(*frontmost_application);
-    }
-    if (auto properties = event.get_input_source_properties()) {
-      manipulator_environment_.set_input_source_properties(*properties);
-    }
-    if (auto set_variable = event.get_set_variable()) {
-      switch (event_type) {
-        case event_type::key_down:
-          if (auto n = set_variable->get_name()) {
-            switch (set_variable->get_type()) {
-              case manipulator_environment_variable_set_variable::type::set:
-                if (auto v = set_variable->get_value()) {
-                  manipulator_environment_.set_variable(*n, *v);
-                }
-                break;
-
-              case manipulator_environment_variable_set_variable::type::unset:
-                manipulator_environment_.unset_variable(*n);
-                break;
-            }
-          }
-          break;
-        case event_type::key_up:
-          if (auto n = set_variable->get_name()) {
-            switch (set_variable->get_type()) {
-              case manipulator_environment_variable_set_variable::type::set:
-                if (auto v = set_variable->get_key_up_value()) {
-                  manipulator_environment_.set_variable(*n, *v);
-                }
-                break;
-              case manipulator_environment_variable_set_variable::type::unset:
-                // Do nothing
-                break;
-            }
-          }
-          break;
-        case event_type::single:
-          // Do nothing
-          break;
-      }
-    }
-    if (auto properties = event.get_if<pqrs::osx::system_preferences::properties>()) {
-      manipulator_environment_.set_variable("system.use_fkeys_as_standard_function_keys",
-                                            manipulator_environment_variable_value(properties->get_use_fkeys_as_standard_function_keys()));
-      manipulator_environment_.set_variable("system.scroll_direction_is_natural",
-                                            manipulator_environment_variable_value(properties->get_scroll_direction_is_natural()));
-    }
-    if (auto state = event.get_if<virtual_hid_devices_state>()) {
-      manipulator_environment_.set_virtual_hid_devices_state(*state);
-    }
+    update_states(events_.emplace_back(device_id,
+                                       t,
+                                       event,
+                                       event_type,
+                                       original_event,
+                                       state,
+                                       lazy,
+                                       validity));
   }
 
   void push_back_entry(const entry& entry) {
@@ -175,8 +54,18 @@ public:
                        entry.get_validity());
   }
 
+  // Move `entry` into the queue without copying its events.
+  // (e.g., passing through the entry to the next queue.)
+  void push_back_entry(entry&& entry) {
+    auto& t = entry.get_event_time_stamp();
+    t.set_time_stamp(t.get_time_stamp() + time_stamp_delay_);
+
+    update_states(events_.emplace_back(std::move(entry)));
+  }
+
   void clear_events(void) {
     events_.clear();
+    sorted_size_ = 0;
     time_stamp_delay_ = absolute_time_duration(0);
   }
 
@@ -185,7 +74,10 @@ public:
   }
 
   void erase_front_event(void) {
-    events_.erase(std::begin(events_));
+    events_.pop_front();
+    if (sorted_size_ > 0) {
+      --sorted_size_;
+    }
     if (events_.empty()) {
       time_stamp_delay_ = absolute_time_duration(0);
     }
@@ -195,7 +87,7 @@ public:
     return events_.empty();
   }
 
-  const std::vector<entry>& get_entries(void) const {
+  const ring_buffer<entry>& get_entries(void) const {
     return events_;
   }
 
@@ -251,21 +143,90 @@ public:
     time_stamp_delay_ += value;
   }
 
+  // Reorder entries which have the same time stamp by `needs_swap`.
+  //
+  // Entries before `sorted_size_` are already reordered,
+  // so we only insert each newly added entry into the run of preceding entries which have the same time stamp.
   void sort_events(void) {
-    if (events_.empty()) {
-      return;
+    for (; sorted_size_ < events_.size(); ++sorted_size_) {
+      for (auto i = sorted_size_; i > 0; --i) {
+        if (!needs_swap(events_[i - 1], events_[i])) {
+          break;
+        }
+
+        std::swap(events_[i - 1], events_[i]);
+      }
     }
+  }
+
+  // Merge adjacent pending pointing_motion entries of the same device into one entry.
+  // This is used to catch up with the input when the queue is backlogged.
+  //
+  // Entries are merged only while no other kind of event (e.g., key or button events) sits between them,
+  // so the order of pointing_motion and the other events is kept.
+  // x, y and wheels are summed, and the merged entry has the time stamp of the first entry.
+  // Entries are not merged if a summed value exceeds the range of a pointing report in order to preserve the totals.
+  //
+  // Returns the number of merged (removed) entries.
+  size_t coalesce_pointing_motions(void) {
+    auto size = events_.size();
+    size_t sorted_size = 0;
+    size_t w = 0;
+
+    // The last pointing_motion entry of each device in the current run.
+    coalesce_targets_.clear();
+
+    for (size_t r = 0; r < size; ++r) {
+      if (r == sorted_size_) {
+        sorted_size = w;
+      }
 
-    for (int i = 0; i < events_.size() - 1;) {
-      if (needs_swap(events_[i], events_[i + 1])) {
-        std::swap(events_[i], events_[i + 1]);
-        if (i > 0) {
-          --i;
+      auto& e = events_[r];
+
+      if (coalescable(e)) {
+        auto it = std::find_if(std::begin(coalesce_targets_),
+                               std::end(coalesce_targets_),
+                               [&](const auto& pair) {
+                                 return pair.first == e.get_device_id();
+                               });
+        if (it != std::end(coalesce_targets_)) {
+          auto& target = events_[it->second];
+          if (auto m = merge_pointing_motions(*(target.get_event().get_pointing_motion()),
+                                              *(e.get_event().get_pointing_motion()))) {
+            event merged(*m);
+            target = entry(target.get_device_id(),
+                           target.get_event_time_stamp(),
+                           merged,
+                           event_type::single,
+                           merged,
+                           target.get_state());
+            continue;
+          }
+
+          it->second = w;
+        } else {
+          coalesce_targets_.emplace_back(e.get_device_id(), w);
         }
-        continue;
+      } else {
+        coalesce_targets_.clear();
+      }
+
+      if (w != r) {
+        events_[w] = std::move(e);
       }
-      ++i;
+      ++w;
     }
+
+    if (sorted_size_ >= size) {
+      sorted_size = w;
+    }
+
+    while (events_.size() > w) {
+      events_.pop_back();
+    }
+    sorted_size_ = sorted_size;
+
+    return size - w;
   }
 
   static bool needs_swap(const entry& v1, const entry& v2) {
@@ -348,7 +309,172 @@ public:
   }
 
 private:
-  std::vector<entry> events_;
+  static bool coalescable(const entry& e) {
+    return e.get_event().get_type() == event::type::pointing_motion &&
+           e.get_original_event().get_type() == event::type::pointing_motion &&
+           e.get_event_type() == event_type::single &&
+           e.get_state() == state::original &&
+           !e.get_lazy() &&
+           e.get_validity() == validity::valid;
+  }
+
+  static std::optional<pointing_motion> merge_pointing_motions(const pointing_motion& m1,
+                                                               const pointing_motion& m2) {
+    pointing_motion m(m1.get_x() + m2.get_x(),
+                      m1.get_y() + m2.get_y(),
+                      m1.get_vertical_wheel() + m2.get_vertical_wheel(),
+                      m1.get_horizontal_wheel() + m2.get_horizontal_wheel());
+
+    // Keep the merged motion within the range which a pointing_input report can carry.
+    constexpr int max = std::numeric_limits<int8_t>::max();
+
+    for (auto v : {m.get_x(), m.get_y(), m.get_vertical_wheel(), m.get_horizontal_wheel()}) {
+      if (v < -max || max < v) {
+        return std::nullopt;
+      }
+    }
+
+    return m;
+  }
+
+  // Update modifier_flag_manager, pointing_button_manager and manipulator_environment with the added entry.
+  void update_states(const entry& entry) {
+    auto device_id = entry.get_device_id();
+    const class event& event = entry.get_event();
+    auto event_type = entry.get_event_type();
+    auto validity = entry.get_validity();
+
+    //
+    // Update modifier_flag_manager, pointing_button_manager
+    //
+
+    if (auto e = event.get_if<momentary_switch_event>()) {
+      if (auto modifier_flag = e->make_modifier_flag()) {
+        auto type = (event_type == event_type::key_down ? modifier_flag_manager::active_modifier_flag::type::increase
+                                                        : modifier_flag_manager::active_modifier_flag::type::decrease);
+        modifier_flag_manager::active_modifier_flag active_modifier_flag(type,
+                                                                         *modifier_flag,
+                                                                         device_id);
+        modifier_flag_manager_.push_back_active_modifier_flag(active_modifier_flag);
+      }
+
+      if (e->pointing_button()) {
+        auto type = (event_type == event_type::key_down ? pointing_button_manager::active_pointing_button::type::increase
+                                                        : pointing_button_manager::active_pointing_button::type::decrease);
+        pointing_button_manager::active_pointing_button active_pointing_button(type,
+                                                                               e->get_usage_pair(),
+                                                                               device_id);
+        pointing_button_manager_.push_back_active_pointing_button(active_pointing_button);
+      }
+
+      // Erase sticky modifiers
+      if (event_type == event_type::key_down &&
+          validity == validity::valid &&
+          !e->modifier_flag()) {
+        modifier_flag_manager_.erase_all_sticky_modifier_flags();
+      }
+
+    } else if (event.get_type() == event::type::sticky_modifier) {
+      if (event_type == event_type::key_down || event_type == event_type::single) {
+        if (auto sticky_modifier = event.get_sticky_modifier()) {
+          auto type = modifier_flag_manager::active_modifier_flag::type::increase_sticky;
+
+          if (sticky_modifier->second == sticky_modifier_type::toggle) {
+            if (modifier_flag_manager_.sticky_size(sticky_modifier->first) > 0) {
+              type = modifier_flag_manager::active_modifier_flag::type::decrease_sticky;
+            }
+          } else {
+            if (sticky_modifier->second != sticky_modifier_type::on) {
+              type = modifier_flag_manager::active_modifier_flag::type::decrease_sticky;
+            }
+          }
+
+          modifier_flag_manager::active_modifier_flag active_modifier_flag(type,
+                                                                           sticky_modifier->first,
+                                                                           device_id);
+          modifier_flag_manager_.push_back_active_modifier_flag(active_modifier_flag);
+        }
+      }
+
+    } else if (event.get_type() == event::type::caps_lock_state_changed) {
+      if (auto integer_value = event.get_integer_value()) {
+        auto type = (*integer_value ? modifier_flag_manager::active_modifier_flag::type::increase_led_lock
+                                    : modifier_flag_manager::active_modifier_flag::type::decrease_led_lock);
+        modifier_flag_manager::active_modifier_flag active_modifier_flag(type,
+                                                                         modifier_flag::caps_lock,
+                                                                         device_id);
+        modifier_flag_manager_.push_back_active_modifier_flag(active_modifier_flag);
+      }
+    }
+
+    //
+    // Update manipulator_environment
+    //
+
+    if (event.get_type() == event::type::device_grabbed) {
+      if (auto v = event.get_if<gsl::not_null<std::shared_ptr<device_properties>>>()) {
+        manipulator_environment_.insert_device_properties(device_id, *v);
+      }
+    }
+    if (event.get_type() == event::type::device_ungrabbed) {
+      manipulator_environment_.erase_device_properties(device_id);
+    }
+    if (auto frontmost_application = event.get_frontmost_application()) {
+      manipulator_environment_.set_frontmost_application(*frontmost_application);
+    }
+    if (auto properties = event.get_input_source_properties()) {
+      manipulator_environment_.set_input_source_properties(*properties);
+    }
+    if (auto set_variable = event.get_set_variable()) {
+      switch (event_type) {
+        case event_type::key_down:
+          if (auto n = set_variable->get_name_slot()) {
+            switch (set_variable->get_type()) {
+              case manipulator_environment_variable_set_variable::type::set:
+                if (auto v = set_variable->get_value()) {
+                  manipulator_environment_.set_variable(*n, *v);
+                }
+                break;
+
+              case manipulator_environment_variable_set_variable::type::unset:
+                manipulator_environment_.unset_variable(*n);
+                break;
+            }
+          }
+          break;
+        case event_type::key_up:
+          if (auto n = set_variable->get_name_slot()) {
+            switch (set_variable->get_type()) {
+              case manipulator_environment_variable_set_variable::type::set:
+                if (auto v = set_variable->get_key_up_value()) {
+                  manipulator_environment_.set_variable(*n, *v);
+                }
+                break;
+              case manipulator_environment_variable_set_variable::type::unset:
+                // Do nothing
+                break;
+            }
+          }
+          break;
+        case event_type::single:
+          // Do nothing
+          break;
+      }
+    }
+    if (auto properties = event.get_if<pqrs::osx::system_preferences::properties>()) {
+      manipulator_environment_.set_variable("system.use_fkeys_as_standard_function_keys",
+                                            manipulator_environment_variable_value(properties->get_use_fkeys_as_standard_function_keys()));
+      manipulator_environment_.set_variable("system.scroll_direction_is_natural",
+                                            manipulator_environment_variable_value(properties->get_scroll_direction_is_natural()));
+    }
+    if (auto state = event.get_if<virtual_hid_devices_state>()) {
+      manipulator_environment_.set_virtual_hid_devices_state(*state);
+    }
+  }
+
+  ring_buffer<entry> events_;
+  size_t sorted_size_;
+  std::vector<std::pair<device_id, size_t>> coalesce_targets_;
   modifier_flag_manager modifier_flag_manager_;
   pointing_button_manager pointing_button_manager_;
   manipulator::manipulator_environment manipulator_environment_;
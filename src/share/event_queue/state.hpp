@@ -1,11 +1,12 @@
 #pragma once
 
+#include <cstdint>
 #include <pqrs/json.hpp>
 #include <spdlog/fmt/fmt.h>
 
 namespace krbn {
 namespace event_queue {
-enum class state {
+enum class state : uint8_t {
   original,
   manipulated,
   virtual_event,
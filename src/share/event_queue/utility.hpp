@@ -1,6 +1,7 @@
 #pragma once
 
 #include "device_properties.hpp"
+#include "entries_pool.hpp"
 #include "hat_switch_convert.hpp"
 #include "pressed_keys_manager.hpp"
 #include "queue.hpp"
@@ -33,10 +34,11 @@ struct make_entries_parameters final {
   double pointing_motion_wheels_multiplier = 1.0;
 };
 
-static inline not_null_entries_ptr_t make_entries(gsl::not_null<std::shared_ptr<device_properties>> device_properties,
+static inline not_null_entries_ptr_t make_entries(entries_pool& pool,
+                                                  gsl::not_null<std::shared_ptr<device_properties>> device_properties,
                                                   const std::vector<pqrs::osx::iokit_hid_value>& hid_values,
                                                   const make_entries_parameters& parameters) {
-  auto result = std::make_shared<std::vector<not_null_const_entry_ptr_t>>();
+  auto result = pool.make_entries();
 
   // The pointing motion usage (hid_usage::gd_x, hid_usage::gd_y, etc.) are splitted from one HID report.
   // We have to join them into one pointing_motion event to avoid VMware Remote Console problem that VMRC ignores frequently events.
@@ -56,12 +58,12 @@ static inline not_null_entries_ptr_t make_entries(gsl::not_null<std::shared_ptr<
           pointing_motion_horizontal_wheel ? *pointing_motion_horizontal_wheel : 0);
 
       event_queue::event event(pointing_motion);
-      auto e = std::make_shared<entry>(device_properties->get_device_id(),
-                                       event_time_stamp(*pointing_motion_time_stamp),
-                                       event,
-                                       event_type::single,
-                                       event,
-                                       state::original);
+      auto e = pool.make_entry(device_properties->get_device_id(),
+                               event_time_stamp(*pointing_motion_time_stamp),
+                               event,
+                               event_type::single,
+                               event,
+                               state::original);
       result->push_back(e);
 
       pointing_motion_time_stamp = std::nullopt;
@@ -85,82 +87,94 @@ static inline not_null_entries_ptr_t make_entries(gsl::not_null<std::shared_ptr<
   for (const auto& v : hid_values) {
     if (auto usage_page = v.get_usage_page()) {
       if (auto usage = v.get_usage()) {
-        if (momentary_switch_event::target(*usage_page, *usage)) {
-          event_queue::event event(momentary_switch_event(*usage_page, *usage));
-          auto e = std::make_shared<entry>(device_properties->get_device_id(),
-                                           event_time_stamp(v.get_time_stamp()),
-                                           event,
-                                           v.get_integer_value() ? event_type::key_down : event_type::key_up,
-                                           event,
-                                           state::original);
-          result->push_back(e);
-
-        } else if (v.conforms_to(pqrs::hid::usage_page::generic_desktop,
-                                 pqrs::hid::usage::generic_desktop::x) &&
-                   !is_game_pad) {
-          if (pointing_motion_x) {
-            emplace_back_pointing_motion_event();
-          }
-          pointing_motion_time_stamp = v.get_time_stamp();
-          pointing_motion_x = adjust_pointing_motion_value(v,
-                                                           parameters.pointing_motion_xy_multiplier);
-
-        } else if (v.conforms_to(pqrs::hid::usage_page::generic_desktop,
-                                 pqrs::hid::usage::generic_desktop::y) &&
-                   !is_game_pad) {
-          if (pointing_motion_y) {
-            emplace_back_pointing_motion_event();
-          }
-          pointing_motion_time_stamp = v.get_time_stamp();
-          pointing_motion_y = adjust_pointing_motion_value(v,
-                                                           parameters.pointing_motion_xy_multiplier);
-
-        } else if (v.conforms_to(pqrs::hid::usage_page::generic_desktop,
-                                 pqrs::hid::usage::generic_desktop::wheel)) {
-          if (pointing_motion_vertical_wheel) {
-            emplace_back_pointing_motion_event();
-          }
-          pointing_motion_time_stamp = v.get_time_stamp();
-          pointing_motion_vertical_wheel = adjust_pointing_motion_value(v,
-                                                                        parameters.pointing_motion_wheels_multiplier);
-
-        } else if (v.conforms_to(pqrs::hid::usage_page::consumer,
-                                 pqrs::hid::usage::consumer::ac_pan)) {
-          if (pointing_motion_horizontal_wheel) {
-            emplace_back_pointing_motion_event();
+        auto usage_class = classify_hid_usage(*usage_page, *usage);
+
+        switch (usage_class.kind) {
+          case hid_usage_kind::momentary_switch: {
+            event_queue::event event(momentary_switch_event(*usage_page, *usage, usage_class));
+            auto e = pool.make_entry(device_properties->get_device_id(),
+                                     event_time_stamp(v.get_time_stamp()),
+                                     event,
+                                     v.get_integer_value() ? event_type::key_down : event_type::key_up,
+                                     event,
+                                     state::original);
+            result->push_back(e);
+            break;
           }
-          pointing_motion_time_stamp = v.get_time_stamp();
-          pointing_motion_horizontal_wheel = adjust_pointing_motion_value(v,
+
+          case hid_usage_kind::pointing_motion_x:
+            if (!is_game_pad) {
+              if (pointing_motion_x) {
+                emplace_back_pointing_motion_event();
+              }
+              pointing_motion_time_stamp = v.get_time_stamp();
+              pointing_motion_x = adjust_pointing_motion_value(v,
+                                                               parameters.pointing_motion_xy_multiplier);
+            }
+            break;
+
+          case hid_usage_kind::pointing_motion_y:
+            if (!is_game_pad) {
+              if (pointing_motion_y) {
+                emplace_back_pointing_motion_event();
+              }
+              pointing_motion_time_stamp = v.get_time_stamp();
+              pointing_motion_y = adjust_pointing_motion_value(v,
+                                                               parameters.pointing_motion_xy_multiplier);
+            }
+            break;
+
+          case hid_usage_kind::pointing_motion_vertical_wheel:
+            if (pointing_motion_vertical_wheel) {
+              emplace_back_pointing_motion_event();
+            }
+            pointing_motion_time_stamp = v.get_time_stamp();
+            pointing_motion_vertical_wheel = adjust_pointing_motion_value(v,
                                                                           parameters.pointing_motion_wheels_multiplier);
+            break;
 
-        } else if (v.conforms_to(pqrs::hid::usage_page::leds,
-                                 pqrs::hid::usage::led::caps_lock)) {
-          auto event = event_queue::event::make_caps_lock_state_changed_event(v.get_integer_value());
-          auto e = std::make_shared<entry>(device_properties->get_device_id(),
-                                           event_time_stamp(v.get_time_stamp()),
-                                           event,
-                                           event_type::single,
-                                           event,
-                                           state::virtual_event);
-          result->push_back(e);
-
-        } else if (is_game_pad) {
-          if (v.conforms_to(pqrs::hid::usage_page::generic_desktop,
-                            pqrs::hid::usage::generic_desktop::hat_switch)) {
-            // Convert hat switch to dpad.
-            auto pairs = hat_switch_converter::get_global_hat_switch_converter()->to_dpad_events(device_properties->get_device_id(),
-                                                                                                 v.get_integer_value());
-            for (const auto& pair : pairs) {
-              event_queue::event event(pair.first);
-              auto e = std::make_shared<entry>(device_properties->get_device_id(),
-                                               event_time_stamp(v.get_time_stamp()),
-                                               event,
-                                               pair.second,
-                                               event,
-                                               state::original);
-              result->push_back(e);
+          case hid_usage_kind::pointing_motion_horizontal_wheel:
+            if (pointing_motion_horizontal_wheel) {
+              emplace_back_pointing_motion_event();
             }
+            pointing_motion_time_stamp = v.get_time_stamp();
+            pointing_motion_horizontal_wheel = adjust_pointing_motion_value(v,
+                                                                            parameters.pointing_motion_wheels_multiplier);
+            break;
+
+          case hid_usage_kind::caps_lock_led: {
+            auto event = event_queue::event::make_caps_lock_state_changed_event(v.get_integer_value());
+            auto e = pool.make_entry(device_properties->get_device_id(),
+                                     event_time_stamp(v.get_time_stamp()),
+                                     event,
+                                     event_type::single,
+                                     event,
+                                     state::virtual_event);
+            result->push_back(e);
+            break;
           }
+
+          case hid_usage_kind::hat_switch:
+            if (is_game_pad) {
+              // Convert hat switch to dpad.
+              auto pairs = hat_switch_converter::get_global_hat_switch_converter()->to_dpad_events(device_properties->get_device_id(),
+                                                                                                   v.get_integer_value());
+              for (const auto& pair : pairs) {
+                event_queue::event event(pair.first);
+                auto e = pool.make_entry(device_properties->get_device_id(),
+                                         event_time_stamp(v.get_time_stamp()),
+                                         event,
+                                         pair.second,
+                                         event,
+                                         state::original);
+                result->push_back(e);
+              }
+            }
+            break;
+
+          case hid_usage_kind::none:
+            // Do nothing
+            break;
         }
       }
     }
@@ -171,10 +185,43 @@ static inline not_null_entries_ptr_t make_entries(gsl::not_null<std::shared_ptr<
   return result;
 }
 
-static inline not_null_entries_ptr_t insert_device_keys_and_pointing_buttons_are_released_event(not_null_entries_ptr_t entries,
+static inline not_null_entries_ptr_t make_entries(gsl::not_null<std::shared_ptr<device_properties>> device_properties,
+                                                  const std::vector<pqrs::osx::iokit_hid_value>& hid_values,
+                                                  const make_entries_parameters& parameters) {
+  entries_pool pool;
+  return make_entries(pool,
+                      device_properties,
+                      hid_values,
+                      parameters);
+}
+
+// Update `pressed_keys_manager` with key_down and key_up events of `device_id` in `entries`.
+// This function does not build any entries, so it can be used in the hid queue callback of each device.
+static inline void update_pressed_keys_manager(const not_null_entries_ptr_t& entries,
+                                               device_id device_id,
+                                               pressed_keys_manager& pressed_keys_manager) {
+  for (const auto& entry : *entries) {
+    if (entry->get_device_id() == device_id) {
+      if (auto e = entry->get_event().get_if<momentary_switch_event>()) {
+        if (entry->get_event_type() == event_type::key_down) {
+          pressed_keys_manager.insert(*e);
+        } else if (entry->get_event_type() == event_type::key_up) {
+          if (!pressed_keys_manager.empty()) {
+            pressed_keys_manager.erase(*e);
+          }
+        }
+      }
+    }
+  }
+}
+
+// Make entries which device_keys_and_pointing_buttons_are_released events are inserted into `entries`.
+// Use `update_pressed_keys_manager` if the inserted events are not needed.
+static inline not_null_entries_ptr_t insert_device_keys_and_pointing_buttons_are_released_event(entries_pool& pool,
+                                                                                                not_null_entries_ptr_t entries,
                                                                                                 device_id device_id,
                                                                                                 gsl::not_null<std::shared_ptr<pressed_keys_manager>> pressed_keys_manager) {
-  auto result = std::make_shared<std::vector<not_null_const_entry_ptr_t>>();
+  auto result = pool.make_entries();
 
   for (const auto& entry : *entries) {
     result->push_back(entry);
@@ -192,12 +239,12 @@ static inline not_null_entries_ptr_t insert_device_keys_and_pointing_buttons_are
 
           if (pressed_keys_manager->empty()) {
             auto event = event::make_device_keys_and_pointing_buttons_are_released_event();
-            auto e = std::make_shared<event_queue::entry>(device_id,
-                                                          entry->get_event_time_stamp(),
-                                                          event,
-                                                          event_type::single,
-                                                          event,
-                                                          state::virtual_event);
+            auto e = pool.make_entry(device_id,
+                                     entry->get_event_time_stamp(),
+                                     event,
+                                     event_type::single,
+                                     event,
+                                     state::virtual_event);
             result->push_back(e);
           }
         }
@@ -208,6 +255,16 @@ static inline not_null_entries_ptr_t insert_device_keys_and_pointing_buttons_are
   return result;
 }
 
+static inline not_null_entries_ptr_t insert_device_keys_and_pointing_buttons_are_released_event(not_null_entries_ptr_t entries,
+                                                                                                device_id device_id,
+                                                                                                gsl::not_null<std::shared_ptr<pressed_keys_manager>> pressed_keys_manager) {
+  entries_pool pool;
+  return insert_device_keys_and_pointing_buttons_are_released_event(pool,
+                                                                    entries,
+                                                                    device_id,
+                                                                    pressed_keys_manager);
+}
+
 } // namespace utility
 } // namespace event_queue
 } // namespace krbn
@@ -13,6 +13,9 @@
 #include <exprtk/exprtk.hpp>
 #include <gsl/gsl>
 #include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 namespace krbn {
 namespace exprtk_utility {
@@ -32,15 +35,92 @@ inline bool is_string_variable_name(const std::string& name) {
   return name.ends_with("_string");
 }
 
+// The backing storage of variables which is shared among multiple expressions.
+// A variable is written once and all expressions which reference it observe the new value.
+//
+// Note:
+// The storage is protected by a mutex, but the values are read by expressions without the mutex.
+// Thus, values have to be written in the same thread as the expressions are evaluated.
+class shared_variables final {
+public:
+  shared_variables(const shared_variables&) = delete;
+
+  shared_variables(void) {
+  }
+
+  // The returned reference is valid while this instance exists.
+  double& get_variable(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return variables_[name];
+  }
+
+  // The returned reference is valid while this instance exists.
+  std::string& get_string_variable(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return string_variables_[name];
+  }
+
+  // Returns true if the value is changed.
+  bool set_variable(const std::string& name,
+                    double value) {
+    auto& v = get_variable(name);
+    if (v == value) {
+      return false;
+    }
+
+    v = value;
+    return true;
+  }
+
+  // Returns true if the value is changed.
+  bool set_variable(const std::string& name,
+                    const std::string& value) {
+    auto& v = get_string_variable(name);
+    if (v == value) {
+      return false;
+    }
+
+    v = value;
+    return true;
+  }
+
+private:
+  // std::unordered_map never invalidates references to elements on insertion.
+  std::unordered_map<std::string, double> variables_;
+  std::unordered_map<std::string, std::string> string_variables_;
+  std::mutex mutex_;
+};
+
 // Treat undefined variables as 0.
 struct zeroing_unknown_symbol_resolver : public unknown_symbol_resolver_t {
-  zeroing_unknown_symbol_resolver(void)
-      : unknown_symbol_resolver_t(unknown_symbol_resolver_t::e_usrmode_extended) {
+  zeroing_unknown_symbol_resolver(std::shared_ptr<shared_variables> shared_variables)
+      : unknown_symbol_resolver_t(unknown_symbol_resolver_t::e_usrmode_extended),
+        storage(shared_variables) {
   }
 
   bool process(const std::string& name,
                symbol_table_t& primary,
                std::string& error_message) override {
+    if (storage) {
+      // Bind the variable to the shared storage.
+      if (is_string_variable_name(name)) {
+        if (!primary.add_stringvar(name, storage->get_string_variable(name))) {
+          error_message = "failed to add string variable: " + name;
+          return false;
+        }
+      } else {
+        if (!primary.add_variable(name, storage->get_variable(name))) {
+          error_message = "failed to add variable: " + name;
+          return false;
+        }
+      }
+
+      variable_names.push_back(name);
+      return true;
+    }
+
     // With `create_variable` and `create_stringvar`,
     // exprtk manages the variable's storage internally.
     // So unlike `add_variable` and `add_stringvar`,
@@ -56,16 +136,23 @@ struct zeroing_unknown_symbol_resolver : public unknown_symbol_resolver_t {
         return false;
       }
     }
+
+    variable_names.push_back(name);
     return true;
   }
+
+  std::shared_ptr<shared_variables> storage;
+  std::vector<std::string> variable_names;
 };
 
 class expression_wrapper final {
 public:
   expression_wrapper(const expression_wrapper&) = delete;
 
-  expression_wrapper(const std::string& expression_string)
-      : expression_string_(expression_string) {
+  expression_wrapper(const std::string& expression_string,
+                     std::shared_ptr<shared_variables> shared_variables = nullptr)
+      : expression_string_(expression_string),
+        zeroing_unknown_symbol_resolver_(shared_variables) {
     symbol_table_.add_constants(); // pi, epsilon and inf
     expression_.register_symbol_table(symbol_table_);
 
@@ -102,6 +189,11 @@ public:
     return true;
   }
 
+  // The names of variables which are referenced in the expression.
+  const std::vector<std::string>& get_variable_names(void) const {
+    return zeroing_unknown_symbol_resolver_.variable_names;
+  }
+
   double value(void) const noexcept {
     std::lock_guard<std::mutex> lock(mutex_);
 
@@ -139,8 +231,10 @@ private:
   mutable std::mutex mutex_;
 };
 
-inline gsl::not_null<std::shared_ptr<expression_wrapper>> compile(const std::string& expression_string) {
-  return std::make_shared<expression_wrapper>(expression_string);
+inline gsl::not_null<std::shared_ptr<expression_wrapper>> compile(const std::string& expression_string,
+                                                                   std::shared_ptr<shared_variables> shared_variables = nullptr) {
+  return std::make_shared<expression_wrapper>(expression_string,
+                                              shared_variables);
 }
 
 } // namespace exprtk_utility
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "conditions/expression.hpp"
+#include <algorithm>
 #include <gsl/gsl>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -11,8 +14,8 @@
 namespace krbn {
 namespace manipulator {
 
-// We manage all conditions::expression instances with a manager
-// because changing a variable via set_variable requires updating every instance.
+// We manage all conditions::expression instances with a manager.
+// The expressions share the storage of variables, so changing a variable via set_variable is a single write.
 //
 // Note:
 // Because expression variables can include key information, they must remain within the grabber.
@@ -21,67 +24,104 @@ namespace manipulator {
 
 class condition_expression_manager final {
 public:
+  // The inputs of `device.*` variables.
+  struct device_variables_source final {
+    uint64_t manipulator_environment_instance_id;
+    uint64_t devices_generation;
+    uint64_t core_configuration_generation;
+    device_id entry_device_id;
+
+    bool operator==(const device_variables_source&) const = default;
+  };
+
+  condition_expression_manager(void)
+      : shared_variables_(std::make_shared<exprtk_utility::shared_variables>()) {
+  }
+
+  // Expressions have to be compiled with this storage in order to observe variables set via `set_variable`.
+  gsl::not_null<std::shared_ptr<exprtk_utility::shared_variables>> get_shared_variables(void) const {
+    return shared_variables_;
+  }
+
+  // `insert` can be called from a thread other than the dispatcher thread (e.g., while building manipulators in background).
   void insert(std::weak_ptr<exprtk_utility::expression_wrapper> expression) {
-    expressions_.push_back(expression);
+    std::lock_guard<std::mutex> lock(mutex_);
 
-    // Set variables for new instance.
+    // Update the dependency index.
     if (auto shared_ptr = expression.lock()) {
-      for (auto&& [name, value] : variables_) {
-        shared_ptr->set_variable(name, value);
+      for (const auto& name : shared_ptr->get_variable_names()) {
+        auto& expressions = expressions_[name];
+        std::erase_if(expressions, [](auto&& weak_ptr) {
+          return weak_ptr.expired();
+        });
+        expressions.push_back(expression);
       }
+    }
 
-      for (auto&& [name, value] : string_variables_) {
-        shared_ptr->set_variable(name, value);
-      }
+    // The new expression may reference `device.*` variables which have not been pushed yet.
+    device_variables_source_ = std::nullopt;
+  }
+
+  // Returns true if `device.*` variables have to be pushed for `source`.
+  bool update_device_variables_source(const device_variables_source& source) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (device_variables_source_ == source) {
+      return false;
     }
+
+    device_variables_source_ = source;
+    return true;
   }
 
-  void set_variable(const std::string& name,
+  // Returns true if any living expression references the variable.
+  bool referenced(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = expressions_.find(name);
+    if (it == std::end(expressions_)) {
+      return false;
+    }
+
+    return std::any_of(std::begin(it->second),
+                       std::end(it->second),
+                       [](auto&& weak_ptr) {
+                         return !weak_ptr.expired();
+                       });
+  }
+
+  // Returns true if the value is changed.
+  bool set_variable(const std::string& name,
                     double value) {
-    std::erase_if(expressions_, [&](auto&& weak_ptr) {
-      if (auto shared_ptr = weak_ptr.lock()) {
-        if (!exprtk_utility::is_string_variable_name(name)) {
-          shared_ptr->set_variable(name, value);
-          variables_.insert_or_assign(name, value);
-        }
-
-        return false;
-      }
+    if (exprtk_utility::is_string_variable_name(name)) {
+      return false;
+    }
 
-      return true;
-    });
+    // The value is written once into the shared storage.
+    return shared_variables_->set_variable(name, value);
   }
 
-  void set_variable(const std::string& name,
+  // Returns true if the value is changed.
+  bool set_variable(const std::string& name,
                     const std::string& value) {
-    std::erase_if(expressions_, [&](auto&& weak_ptr) {
-      if (auto shared_ptr = weak_ptr.lock()) {
-        if (exprtk_utility::is_string_variable_name(name)) {
-          shared_ptr->set_variable(name, value);
-          string_variables_.insert_or_assign(name, value);
-        }
-
-        return false;
-      }
+    if (!exprtk_utility::is_string_variable_name(name)) {
+      return false;
+    }
 
-      return true;
-    });
+    return shared_variables_->set_variable(name, value);
   }
 
 private:
-  std::vector<std::weak_ptr<exprtk_utility::expression_wrapper>> expressions_;
-  std::unordered_map<std::string, double> variables_;
-  std::unordered_map<std::string, std::string> string_variables_;
+  gsl::not_null<std::shared_ptr<exprtk_utility::shared_variables>> shared_variables_;
+  // The dependency index (variable name -> expressions which reference the variable)
+  std::unordered_map<std::string, std::vector<std::weak_ptr<exprtk_utility::expression_wrapper>>> expressions_;
+  std::optional<device_variables_source> device_variables_source_;
+  mutable std::mutex mutex_;
 };
 
 inline gsl::not_null<std::shared_ptr<condition_expression_manager>> get_shared_condition_expression_manager(void) {
-  static std::mutex mutex;
-  std::lock_guard<std::mutex> lock(mutex);
-
-  static std::shared_ptr<condition_expression_manager> p;
-  if (!p) {
-    p = std::make_shared<condition_expression_manager>();
-  }
+  // The initialization of a function-local static variable is thread-safe.
+  static auto p = std::make_shared<condition_expression_manager>();
 
   return p;
 }
@@ -37,8 +37,10 @@ inline gsl::not_null<std::shared_ptr<conditions::base>> make_condition(const nlo
     return std::make_shared<conditions::event_changed>(json);
   } else if (type == "expression_if" ||
              type == "expression_unless") {
-    auto c = std::make_shared<conditions::expression>(json);
-    get_shared_condition_expression_manager()->insert(c->get_expression());
+    auto m = get_shared_condition_expression_manager();
+    auto c = std::make_shared<conditions::expression>(json,
+                                                      m->get_shared_variables());
+    m->insert(c->get_expression());
     return c;
   } else if (type == "frontmost_application_if" ||
              type == "frontmost_application_unless") {
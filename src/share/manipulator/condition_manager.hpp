@@ -17,59 +17,153 @@ public:
 
   void push_back_condition(gsl::not_null<std::shared_ptr<manipulator::conditions::base>> condition) {
     conditions_.push_back(condition);
+    dependencies_.push_back(condition->get_dependencies());
+    cached_results_.push_back(std::nullopt);
   }
 
   bool is_fulfilled(const event_queue::entry& entry,
                     const manipulator_environment& manipulator_environment) const {
     bool result = true;
+    bool condition_expression_variables_updated = false;
 
-    //
-    // Update condition expression variables
-    //
-
-    {
-      auto m = get_shared_condition_expression_manager();
-      auto c = manipulator_environment.get_core_configuration();
-      if (auto dp = manipulator_environment.find_device_properties(entry.get_device_id())) {
-        m->set_variable("device.vendor_id",
-                        type_safe::get(dp->get_device_identifiers().get_vendor_id()));
-        m->set_variable("device.product_id",
-                        type_safe::get(dp->get_device_identifiers().get_product_id()));
-        m->set_variable("device.location_id",
-                        type_safe::get(dp->get_location_id()));
-        m->set_variable("device.device_address",
-                        dp->get_device_identifiers().get_device_address());
-        m->set_variable("device.is_keyboard",
-                        dp->get_device_identifiers().get_is_keyboard());
-        m->set_variable("device.is_pointing_device",
-                        dp->get_device_identifiers().get_is_pointing_device());
-        m->set_variable("device.is_game_pad",
-                        dp->get_device_identifiers().get_is_game_pad());
-        m->set_variable("device.is_consumer",
-                        dp->get_device_identifiers().get_is_consumer());
-        m->set_variable("device.is_touch_bar",
-                        dp->get_is_built_in_touch_bar());
-        m->set_variable("device.is_built_in_keyboard",
-                        device_utility::determine_is_built_in_keyboard(*c, *dp));
+    for (size_t i = 0; i < conditions_.size(); ++i) {
+      //
+      // Use the cached result if the dependencies are not changed.
+      //
+
+      auto& dependencies = dependencies_[i];
+      auto& cached_result = cached_results_[i];
+
+      std::optional<cache_key> key;
+      if (dependencies) {
+        key = make_cache_key(*dependencies,
+                             entry,
+                             manipulator_environment);
+
+        if (cached_result && cached_result->first == *key) {
+          if (!cached_result->second) {
+            result = false;
+          }
+          continue;
+        }
+      }
+
+      //
+      // Update condition expression variables
+      //
+
+      if (!condition_expression_variables_updated &&
+          (!dependencies || dependencies->device_id)) {
+        update_condition_expression_variables(entry,
+                                              manipulator_environment);
+        condition_expression_variables_updated = true;
       }
-    }
 
-    //
-    // Evaluate condition rules.
-    //
+      //
+      // Evaluate condition rule.
+      //
 
-    for (const auto& c : conditions_) {
-      if (!c->is_fulfilled(entry,
-                           manipulator_environment)) {
+      auto fulfilled = conditions_[i]->is_fulfilled(entry,
+                                                    manipulator_environment);
+      if (!fulfilled) {
         result = false;
       }
+
+      if (key) {
+        cached_result = std::make_pair(*key, fulfilled);
+      }
     }
 
     return result;
   }
 
 private:
+  struct cache_key final {
+    uint64_t manipulator_environment_instance_id;
+    manipulator_environment::generations generations;
+    std::optional<device_id> entry_device_id;
+
+    bool operator==(const cache_key&) const = default;
+  };
+
+  static cache_key make_cache_key(const conditions::base::dependencies& dependencies,
+                                  const event_queue::entry& entry,
+                                  const manipulator_environment& manipulator_environment) {
+    cache_key key{
+        .manipulator_environment_instance_id = manipulator_environment.get_instance_id(),
+    };
+
+    key.generations.fill(0);
+    for (const auto& f : dependencies.facets) {
+      key.generations[static_cast<size_t>(f)] = manipulator_environment.get_generation(f);
+    }
+
+    if (dependencies.device_id) {
+      key.entry_device_id = entry.get_device_id();
+    }
+
+    return key;
+  }
+
+  static void update_condition_expression_variables(const event_queue::entry& entry,
+                                                    const manipulator_environment& manipulator_environment) {
+    auto m = get_shared_condition_expression_manager();
+
+    // Push `device.*` variables only when the device is changed.
+    if (!m->update_device_variables_source({
+            .manipulator_environment_instance_id = manipulator_environment.get_instance_id(),
+            .devices_generation = manipulator_environment.get_generation(manipulator_environment::facet::devices),
+            .core_configuration_generation = manipulator_environment.get_generation(manipulator_environment::facet::core_configuration),
+            .entry_device_id = entry.get_device_id(),
+        })) {
+      return;
+    }
+
+    auto c = manipulator_environment.get_core_configuration();
+    if (auto dp = manipulator_environment.find_device_properties(entry.get_device_id())) {
+      // Skip variables which no expression references.
+      auto set_variable = [&m](const std::string& name, auto&& make_value) {
+        if (m->referenced(name)) {
+          m->set_variable(name, make_value());
+        }
+      };
+
+      set_variable("device.vendor_id", [&] {
+        return type_safe::get(dp->get_device_identifiers().get_vendor_id());
+      });
+      set_variable("device.product_id", [&] {
+        return type_safe::get(dp->get_device_identifiers().get_product_id());
+      });
+      set_variable("device.location_id", [&] {
+        return type_safe::get(dp->get_location_id());
+      });
+      set_variable("device.device_address", [&] {
+        return dp->get_device_identifiers().get_device_address();
+      });
+      set_variable("device.is_keyboard", [&] {
+        return dp->get_device_identifiers().get_is_keyboard();
+      });
+      set_variable("device.is_pointing_device", [&] {
+        return dp->get_device_identifiers().get_is_pointing_device();
+      });
+      set_variable("device.is_game_pad", [&] {
+        return dp->get_device_identifiers().get_is_game_pad();
+      });
+      set_variable("device.is_consumer", [&] {
+        return dp->get_device_identifiers().get_is_consumer();
+      });
+      set_variable("device.is_touch_bar", [&] {
+        return dp->get_is_built_in_touch_bar();
+      });
+      set_variable("device.is_built_in_keyboard", [&] {
+        return device_utility::determine_is_built_in_keyboard(*c, *dp);
+      });
+    }
+  }
+
   std::vector<gsl::not_null<std::shared_ptr<manipulator::conditions::base>>> conditions_;
+  std::vector<std::optional<conditions::base::dependencies>> dependencies_;
+  mutable std::vector<std::optional<std::pair<cache_key, bool>>> cached_results_;
 };
 } // namespace manipulator
 } // namespace krbn
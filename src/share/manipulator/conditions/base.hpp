@@ -2,11 +2,21 @@
 
 #include "event_queue.hpp"
 #include "manipulator/manipulator_environment.hpp"
+#include <optional>
+#include <vector>
 
 namespace krbn {
 namespace manipulator {
 namespace conditions {
 class base {
+public:
+  // The inputs which the result of `is_fulfilled` depends on.
+  struct dependencies final {
+    std::vector<manipulator_environment::facet> facets;
+    // Whether the result depends on `entry.get_device_id()`.
+    bool device_id = false;
+  };
+
 protected:
   base(void) {
   }
@@ -17,6 +27,12 @@ public:
 
   virtual bool is_fulfilled(const event_queue::entry& entry,
                             const manipulator_environment& manipulator_environment) const = 0;
+
+  // condition_manager caches the result of `is_fulfilled` while the dependencies are not changed.
+  // std::nullopt means the result cannot be cached.
+  virtual std::optional<dependencies> get_dependencies(void) const {
+    return std::nullopt;
+  }
 };
 } // namespace conditions
 } // namespace manipulator
@@ -3,6 +3,8 @@
 #include "base.hpp"
 #include "device_properties_manager.hpp"
 #include "device_utility.hpp"
+#include "manipulator_device_condition_results.hpp"
+#include <algorithm>
 #include <optional>
 #include <pqrs/hid.hpp>
 #include <pqrs/hid/extra/nlohmann_json.hpp>
@@ -57,9 +59,33 @@ public:
         throw pqrs::json::unmarshal_error(fmt::format("unknown key `{0}` in `{1}`", key, pqrs::json::dump_for_error_message(json)));
       }
     }
+
+    switch (type_) {
+      case type::device_if:
+      case type::device_unless:
+        // `is_built_in_keyboard` depends on core_configuration which may be changed in place,
+        // so the results are cached only if the definitions depend on the device properties alone.
+        if (std::none_of(std::begin(definitions_),
+                         std::end(definitions_),
+                         [](const auto& d) {
+                           return d.is_built_in_keyboard.has_value();
+                         })) {
+          condition_id_ = get_shared_manipulator_device_condition_id_table().acquire();
+        }
+        break;
+      case type::device_exists_if:
+      case type::device_exists_unless:
+        // Do nothing
+        break;
+    }
   }
 
+  device(const device&) = delete;
+
   virtual ~device(void) {
+    if (condition_id_) {
+      get_shared_manipulator_device_condition_id_table().release(*condition_id_);
+    }
   }
 
   virtual bool is_fulfilled(const event_queue::entry& entry,
@@ -68,25 +94,23 @@ public:
       switch (type_) {
         case type::device_if:
         case type::device_unless:
-          if (auto dp = manipulator_environment.find_device_properties(entry.get_device_id())) {
-            for (const auto& d : definitions_) {
-              if (d.fulfilled(*dp, manipulator_environment)) {
-                switch (type_) {
-                  case type::device_if:
-                  case type::device_exists_if:
-                    return true;
-                  case type::device_unless:
-                  case type::device_exists_unless:
-                    return false;
-                }
-              }
+          if (condition_id_) {
+            // The result is evaluated once per device and cached until the device is grabbed or ungrabbed again.
+            auto& results = manipulator_environment.get_device_condition_results();
+            if (auto r = results.find(entry.get_device_id(), *condition_id_)) {
+              return *r;
             }
+
+            auto r = is_device_fulfilled(entry.get_device_id(), manipulator_environment);
+            results.set(entry.get_device_id(), *condition_id_, r);
+            return r;
           }
-          break;
+
+          return is_device_fulfilled(entry.get_device_id(), manipulator_environment);
 
         case type::device_exists_if:
         case type::device_exists_unless:
-          for (const auto& [device_id, dp] : manipulator_environment.get_device_properties_manager().get_map()) {
+          for (const auto& dp : manipulator_environment.get_device_properties_manager().get_device_properties()) {
             if (dp) {
               for (const auto& d : definitions_) {
                 if (d.fulfilled(*dp, manipulator_environment)) {
@@ -118,7 +142,42 @@ public:
     }
   }
 
+  virtual std::optional<dependencies> get_dependencies(void) const {
+    switch (type_) {
+      case type::device_if:
+      case type::device_unless:
+        return dependencies{
+            .facets = {manipulator_environment::facet::devices,
+                       manipulator_environment::facet::core_configuration},
+            .device_id = true,
+        };
+      case type::device_exists_if:
+      case type::device_exists_unless:
+        return dependencies{
+            .facets = {manipulator_environment::facet::devices,
+                       manipulator_environment::facet::core_configuration},
+        };
+    }
+
+    return std::nullopt;
+  }
+
 private:
+  bool is_device_fulfilled(device_id device_id,
+                           const manipulator_environment& manipulator_environment) const {
+    if (auto dp = manipulator_environment.find_device_properties(device_id)) {
+      for (const auto& d : definitions_) {
+        if (d.fulfilled(*dp, manipulator_environment)) {
+          return type_ == type::device_if;
+        }
+      }
+    }
+
+    // Not found
+
+    return type_ == type::device_unless;
+  }
+
   struct definition final {
     std::optional<pqrs::hid::vendor_id::value_t> vendor_id;
     std::optional<pqrs::hid::product_id::value_t> product_id;
@@ -265,6 +324,8 @@ private:
 
   type type_;
   std::vector<definition> definitions_;
+  // The bit index in `manipulator_device_condition_results`. (Only `device_if` and `device_unless` have it.)
+  std::optional<manipulator_device_condition_id_table::id> condition_id_;
 };
 } // namespace conditions
 } // namespace manipulator
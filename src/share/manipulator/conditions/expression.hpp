@@ -15,8 +15,10 @@ public:
     expression_unless,
   };
 
-  expression(const nlohmann::json& json) : base(),
-                                           type_(type::expression_if) {
+  expression(const nlohmann::json& json,
+             std::shared_ptr<exprtk_utility::shared_variables> shared_variables = nullptr)
+      : base(),
+        type_(type::expression_if) {
     pqrs::json::requires_object(json, "json");
 
     for (const auto& [key, value] : json.items()) {
@@ -37,7 +39,8 @@ public:
 
       } else if (key == "expression") {
         if (value.is_string()) {
-          expression_ = exprtk_utility::compile(value.get<std::string>());
+          expression_ = exprtk_utility::compile(value.get<std::string>(),
+                                                shared_variables);
 
         } else if (value.is_array()) {
           std::stringstream ss;
@@ -46,7 +49,8 @@ public:
             ss << j.template get<std::string>();
           }
 
-          expression_ = exprtk_utility::compile(ss.str());
+          expression_ = exprtk_utility::compile(ss.str(),
+                                                shared_variables);
 
         } else {
           throw pqrs::json::unmarshal_error(fmt::format("`{0}` must be array of string, or string, but is `{1}`",
@@ -85,6 +89,15 @@ public:
     return false;
   }
 
+  // The expression variables are `device.*` which are made from the entry's device properties.
+  virtual std::optional<dependencies> get_dependencies(void) const {
+    return dependencies{
+        .facets = {manipulator_environment::facet::devices,
+                   manipulator_environment::facet::core_configuration},
+        .device_id = true,
+    };
+  }
+
   std::shared_ptr<exprtk_utility::expression_wrapper> get_expression(void) const {
     return expression_;
   }
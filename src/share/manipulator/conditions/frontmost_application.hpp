@@ -1,7 +1,7 @@
 #pragma once
 
 #include "base.hpp"
-#include <regex>
+#include "manipulator/pattern_matcher.hpp"
 #include <string>
 #include <vector>
 
@@ -16,7 +16,9 @@ public:
   };
 
   frontmost_application(const nlohmann::json& json) : base(),
-                                                      type_(type::frontmost_application_if) {
+                                                      type_(type::frontmost_application_if),
+                                                      bundle_identifier_matcher_(get_shared_pattern_matcher(pattern_matcher::subject::bundle_identifier)),
+                                                      file_path_matcher_(get_shared_pattern_matcher(pattern_matcher::subject::file_path)) {
     pqrs::json::requires_object(json, "json");
 
     for (const auto& [key, value] : json.items()) {
@@ -44,8 +46,7 @@ public:
           auto s = j.get<std::string>();
 
           try {
-            std::regex r(s);
-            bundle_identifiers_.push_back(r);
+            bundle_identifiers_.emplace_back(bundle_identifier_matcher_, s);
           } catch (std::exception& e) {
             throw pqrs::json::unmarshal_error(fmt::format("{0}: `{1}:{2}`", e.what(), key, pqrs::json::dump_for_error_message(value)));
           }
@@ -60,8 +61,7 @@ public:
           auto s = j.get<std::string>();
 
           try {
-            std::regex r(s);
-            file_paths_.push_back(r);
+            file_paths_.emplace_back(file_path_matcher_, s);
           } catch (std::exception& e) {
             throw pqrs::json::unmarshal_error(fmt::format("{0}: `{1}:{2}`", e.what(), key, pqrs::json::dump_for_error_message(value)));
           }
@@ -81,19 +81,13 @@ public:
 
   virtual bool is_fulfilled(const event_queue::entry& entry,
                             const manipulator_environment& manipulator_environment) const {
-    if (cached_result_ && cached_result_->first == manipulator_environment.get_frontmost_application()) {
-      return cached_result_->second;
-    }
-
     bool result = false;
 
     // Bundle identifiers
 
     if (auto& current_bundle_identifier = manipulator_environment.get_frontmost_application().get_bundle_identifier()) {
       for (const auto& b : bundle_identifiers_) {
-        if (regex_search(std::begin(*current_bundle_identifier),
-                         std::end(*current_bundle_identifier),
-                         b)) {
+        if (b.matches(*current_bundle_identifier)) {
           switch (type_) {
             case type::frontmost_application_if:
               result = true;
@@ -110,9 +104,7 @@ public:
 
     if (auto& current_file_path = manipulator_environment.get_frontmost_application().get_file_path()) {
       for (const auto& f : file_paths_) {
-        if (regex_search(std::begin(*current_file_path),
-                         std::end(*current_file_path),
-                         f)) {
+        if (f.matches(*current_file_path)) {
           switch (type_) {
             case type::frontmost_application_if:
               result = true;
@@ -137,16 +129,21 @@ public:
     }
 
   finish:
-    cached_result_ = std::make_pair(manipulator_environment.get_frontmost_application(), result);
     return result;
   }
 
+  virtual std::optional<dependencies> get_dependencies(void) const {
+    return dependencies{
+        .facets = {manipulator_environment::facet::frontmost_application},
+    };
+  }
+
 private:
   type type_;
-  std::vector<std::regex> bundle_identifiers_;
-  std::vector<std::regex> file_paths_;
-
-  mutable std::optional<std::pair<pqrs::osx::frontmost_application_monitor::application, bool>> cached_result_;
+  gsl::not_null<std::shared_ptr<pattern_matcher>> bundle_identifier_matcher_;
+  gsl::not_null<std::shared_ptr<pattern_matcher>> file_path_matcher_;
+  std::vector<registered_pattern> bundle_identifiers_;
+  std::vector<registered_pattern> file_paths_;
 };
 } // namespace conditions
 } // namespace manipulator
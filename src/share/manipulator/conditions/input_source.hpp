@@ -1,6 +1,7 @@
 #pragma once
 
 #include "base.hpp"
+#include "manipulator/pattern_matcher.hpp"
 #include <string>
 #include <vector>
 
@@ -15,7 +16,10 @@ public:
   };
 
   input_source(const nlohmann::json& json) : base(),
-                                             type_(type::input_source_if) {
+                                             type_(type::input_source_if),
+                                             language_matcher_(get_shared_pattern_matcher(pattern_matcher::subject::language)),
+                                             input_source_id_matcher_(get_shared_pattern_matcher(pattern_matcher::subject::input_source_id)),
+                                             input_mode_id_matcher_(get_shared_pattern_matcher(pattern_matcher::subject::input_mode_id)) {
     pqrs::json::requires_object(json, "json");
 
     for (const auto& [key, value] : json.items()) {
@@ -39,7 +43,8 @@ public:
 
         for (const auto& j : value) {
           try {
-            input_source_specifiers_.emplace_back(j);
+            auto specifier = j.get<pqrs::osx::input_source_selector::specifier>();
+            input_source_specifiers_.push_back(compile_specifier(specifier));
           } catch (pqrs::json::unmarshal_error& e) {
             throw pqrs::json::unmarshal_error(fmt::format("`{0}` entry error: {1}", key, e.what()));
           }
@@ -59,14 +64,10 @@ public:
 
   virtual bool is_fulfilled(const event_queue::entry& entry,
                             const manipulator_environment& manipulator_environment) const {
-    if (cached_result_ && cached_result_->first == manipulator_environment.get_input_source_properties()) {
-      return cached_result_->second;
-    }
-
     bool result = false;
 
     for (const auto& s : input_source_specifiers_) {
-      if (s.test(manipulator_environment.get_input_source_properties())) {
+      if (test(s, manipulator_environment.get_input_source_properties())) {
         switch (type_) {
           case type::input_source_if:
             result = true;
@@ -90,15 +91,71 @@ public:
     }
 
   finish:
-    cached_result_ = std::make_pair(manipulator_environment.get_input_source_properties(), result);
     return result;
   }
 
+  virtual std::optional<dependencies> get_dependencies(void) const {
+    return dependencies{
+        .facets = {manipulator_environment::facet::input_source},
+    };
+  }
+
 private:
-  type type_;
-  std::vector<pqrs::osx::input_source_selector::specifier> input_source_specifiers_;
+  // `pqrs::osx::input_source_selector::specifier` whose patterns are registered to pattern_matcher.
+  struct compiled_specifier final {
+    std::optional<registered_pattern> language;
+    std::optional<registered_pattern> input_source_id;
+    std::optional<registered_pattern> input_mode_id;
+  };
+
+  compiled_specifier compile_specifier(const pqrs::osx::input_source_selector::specifier& specifier) {
+    compiled_specifier result;
+
+    if (auto& s = specifier.get_language_string()) {
+      result.language.emplace(language_matcher_, *s);
+    }
+    if (auto& s = specifier.get_input_source_id_string()) {
+      result.input_source_id.emplace(input_source_id_matcher_, *s);
+    }
+    if (auto& s = specifier.get_input_mode_id_string()) {
+      result.input_mode_id.emplace(input_mode_id_matcher_, *s);
+    }
+
+    return result;
+  }
+
+  // The same as `pqrs::osx::input_source_selector::specifier::test`.
+  bool test(const compiled_specifier& specifier,
+            const pqrs::osx::input_source::properties& properties) const {
+    if (specifier.language) {
+      auto& v = properties.get_first_language();
+      if (!v || !specifier.language->matches(*v)) {
+        return false;
+      }
+    }
+
+    if (specifier.input_source_id) {
+      auto& v = properties.get_input_source_id();
+      if (!v || !specifier.input_source_id->matches(*v)) {
+        return false;
+      }
+    }
 
-  mutable std::optional<std::pair<pqrs::osx::input_source::properties, bool>> cached_result_;
+    if (specifier.input_mode_id) {
+      auto& v = properties.get_input_mode_id();
+      if (!v || !specifier.input_mode_id->matches(*v)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  type type_;
+  gsl::not_null<std::shared_ptr<pattern_matcher>> language_matcher_;
+  gsl::not_null<std::shared_ptr<pattern_matcher>> input_source_id_matcher_;
+  gsl::not_null<std::shared_ptr<pattern_matcher>> input_mode_id_matcher_;
+  std::vector<compiled_specifier> input_source_specifiers_;
 };
 } // namespace conditions
 } // namespace manipulator
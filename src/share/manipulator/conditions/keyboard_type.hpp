@@ -83,6 +83,12 @@ public:
     return false;
   }
 
+  virtual std::optional<dependencies> get_dependencies(void) const {
+    return dependencies{
+        .facets = {manipulator_environment::facet::core_configuration},
+    };
+  }
+
 private:
   type type_;
   std::vector<std::string> keyboard_types_;
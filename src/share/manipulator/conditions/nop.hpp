@@ -17,6 +17,10 @@ public:
                             const manipulator_environment& manipulator_environment) const {
     return true;
   }
+
+  virtual std::optional<dependencies> get_dependencies(void) const {
+    return dependencies{};
+  }
 };
 } // namespace conditions
 } // namespace manipulator
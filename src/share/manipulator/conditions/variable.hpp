@@ -1,6 +1,7 @@
 #pragma once
 
 #include "base.hpp"
+#include "manipulator_environment_variable_name_table.hpp"
 #include <string>
 #include <vector>
 
@@ -15,7 +16,8 @@ public:
   };
 
   variable(const nlohmann::json& json) : base(),
-                                         type_(type::variable_if) {
+                                         type_(type::variable_if),
+                                         name_slot_(0) {
     pqrs::json::requires_object(json, "json");
 
     for (const auto& [key, value] : json.items()) {
@@ -38,6 +40,11 @@ public:
         pqrs::json::requires_string(value, "`name`");
 
         name_ = value.get<std::string>();
+        if (auto slot = get_shared_manipulator_environment_variable_name_table().intern(*name_)) {
+          name_slot_ = *slot;
+        } else {
+          throw pqrs::json::unmarshal_error(fmt::format("too many variable names to add `{0}`", *name_));
+        }
 
       } else if (key == "value") {
         value_ = value.get<manipulator_environment_variable_value>();
@@ -66,15 +73,34 @@ public:
                             const manipulator_environment& manipulator_environment) const {
     switch (type_) {
       case type::variable_if:
-        return manipulator_environment.get_variable(*name_) == *value_;
+        return manipulator_environment.get_variable(name_slot_) == *value_;
       case type::variable_unless:
-        return manipulator_environment.get_variable(*name_) != *value_;
+        return manipulator_environment.get_variable(name_slot_) != *value_;
     }
   }
 
+  type get_type(void) const {
+    return type_;
+  }
+
+  manipulator_environment_variable_name_table::slot get_name_slot(void) const {
+    return name_slot_;
+  }
+
+  const std::optional<manipulator_environment_variable_value>& get_value(void) const {
+    return value_;
+  }
+
+  virtual std::optional<dependencies> get_dependencies(void) const {
+    return dependencies{
+        .facets = {manipulator_environment::facet::variables},
+    };
+  }
+
 private:
   type type_;
   std::optional<std::string> name_;
+  manipulator_environment_variable_name_table::slot name_slot_;
   std::optional<manipulator_environment_variable_value> value_;
 };
 } // namespace conditions
@@ -0,0 +1,92 @@
+#pragma once
+
+// `krbn::manipulator::manipulator_cache` is not thread-safe.
+
+#include "manipulator/manipulators/base.hpp"
+#include <functional>
+#include <gsl/gsl>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace krbn {
+namespace manipulator {
+// Keeps manipulators built from the configuration in order to reuse them on the next configuration update.
+//
+// Manipulators are stored with the content of their source (e.g., complex_modifications_rule) and its hash.
+// If the content is not changed, `find_or_make` returns the stored manipulators instead of building new ones.
+// The hash is used only to find candidates; the content is compared before reusing.
+// Reused manipulators keep their state (e.g., pressed keys, compiled expressions).
+class manipulator_cache final {
+public:
+  using manipulators_t = std::vector<gsl::not_null<std::shared_ptr<manipulators::base>>>;
+
+  manipulator_cache(const manipulator_cache&) = delete;
+
+  manipulator_cache(void)
+      : reused_count_(0),
+        rebuilt_count_(0) {
+  }
+
+  // Call `begin_update`, `find_or_make` for each source, and then `end_update`.
+  void begin_update(void) {
+    next_entries_.clear();
+    reused_count_ = 0;
+    rebuilt_count_ = 0;
+  }
+
+  // Each stored entry is reused at most once in an update,
+  // so sources which have the same content get their own manipulators.
+  const manipulators_t& find_or_make(size_t content_hash,
+                                     const nlohmann::json& content,
+                                     const std::function<manipulators_t(void)>& make) {
+    auto [first, last] = entries_.equal_range(content_hash);
+    for (auto it = first; it != last; ++it) {
+      if (it->second.content == content) {
+        auto next_it = next_entries_.emplace(content_hash, std::move(it->second));
+        entries_.erase(it);
+        ++reused_count_;
+        return next_it->second.manipulators;
+      }
+    }
+
+    auto next_it = next_entries_.emplace(content_hash, entry{content, make()});
+    ++rebuilt_count_;
+    return next_it->second.manipulators;
+  }
+
+  // Entries which are not used in the update are released.
+  void end_update(void) {
+    entries_ = std::move(next_entries_);
+    next_entries_.clear();
+  }
+
+  void clear(void) {
+    entries_.clear();
+    next_entries_.clear();
+  }
+
+  // The number of sources which are reused in the last update.
+  size_t get_reused_count(void) const {
+    return reused_count_;
+  }
+
+  // The number of sources which are built in the last update.
+  size_t get_rebuilt_count(void) const {
+    return rebuilt_count_;
+  }
+
+private:
+  struct entry final {
+    nlohmann::json content;
+    manipulators_t manipulators;
+  };
+
+  std::unordered_multimap<size_t, entry> entries_;
+  std::unordered_multimap<size_t, entry> next_entries_;
+  size_t reused_count_;
+  size_t rebuilt_count_;
+};
+} // namespace manipulator
+} // namespace krbn
@@ -4,6 +4,10 @@
 #include "device_properties_manager.hpp"
 #include "json_writer.hpp"
 #include "logger.hpp"
+#include "manipulator_device_condition_results.hpp"
+#include "manipulator_environment_variable_name_table.hpp"
+#include <array>
+#include <atomic>
 #include <fstream>
 #include <gsl/gsl>
 #include <iostream>
@@ -13,17 +17,34 @@
 #include <pqrs/osx/frontmost_application_monitor/extra/nlohmann_json.hpp>
 #include <pqrs/osx/input_source.hpp>
 #include <pqrs/osx/input_source/extra/nlohmann_json.hpp>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace krbn {
 namespace manipulator {
 class manipulator_environment final {
 public:
+  // Each facet has a generation counter which is incremented when the facet is changed.
+  // Conditions use the generations to determine whether their cached results are still valid.
+  enum class facet {
+    variables,
+    frontmost_application,
+    input_source,
+    devices,
+    core_configuration,
+    end_,
+  };
+
+  using generations = std::array<uint64_t, static_cast<size_t>(facet::end_)>;
+
   manipulator_environment(const manipulator_environment&) = delete;
 
   manipulator_environment(void)
-      : core_configuration_(std::make_shared<core_configuration::core_configuration>()) {
+      : instance_id_(make_instance_id()),
+        core_configuration_(std::make_shared<core_configuration::core_configuration>()) {
     karabiner_machine_identifier_ = constants::get_karabiner_machine_identifier();
+    generations_.fill(0);
   }
 
   nlohmann::json to_json(void) const {
@@ -42,7 +63,7 @@ public:
         {"frontmost_application", frontmost_application_},
         {"input_source", input_source_json},
         {"karabiner_machine_identifier", type_safe::get(karabiner_machine_identifier_)},
-        {"variables", variables_},
+        {"variables", make_variables_json()},
         {"virtual_hid_devices_state", virtual_hid_devices_state_},
     });
   }
@@ -55,6 +76,20 @@ public:
     output_json_file_path_.clear();
   }
 
+  // A unique identifier of this instance.
+  // The generations are meaningful only within the same instance.
+  uint64_t get_instance_id(void) const {
+    return instance_id_;
+  }
+
+  uint64_t get_generation(facet facet) const {
+    return generations_[static_cast<size_t>(facet)];
+  }
+
+  const generations& get_generations(void) const {
+    return generations_;
+  }
+
   const karabiner_machine_identifier& get_karabiner_machine_identifier(void) const {
     return karabiner_machine_identifier_;
   }
@@ -68,17 +103,28 @@ public:
     return device_properties_manager_;
   }
 
-  std::shared_ptr<device_properties> find_device_properties(device_id device_id) const {
+  // The returned pointer is valid until the device is erased or replaced.
+  const device_properties* find_device_properties(device_id device_id) const {
     return device_properties_manager_.find(device_id);
   }
 
   void insert_device_properties(device_id device_id,
                                 gsl::not_null<std::shared_ptr<device_properties>> device_properties) {
     device_properties_manager_.insert(device_id, device_properties);
+    device_condition_results_.erase(device_id);
+    increment_generation(facet::devices);
   }
 
   void erase_device_properties(device_id device_id) {
     device_properties_manager_.erase(device_id);
+    device_condition_results_.erase(device_id);
+    increment_generation(facet::devices);
+  }
+
+  // The cache of `device_if` and `device_unless` results.
+  // It is mutable since conditions fill it while evaluating against a const manipulator_environment.
+  manipulator_device_condition_results& get_device_condition_results(void) const {
+    return device_condition_results_;
   }
 
   const pqrs::osx::frontmost_application_monitor::application& get_frontmost_application(void) const {
@@ -86,7 +132,10 @@ public:
   }
 
   void set_frontmost_application(const pqrs::osx::frontmost_application_monitor::application& value) {
-    frontmost_application_ = value;
+    if (frontmost_application_ != value) {
+      frontmost_application_ = value;
+      increment_generation(facet::frontmost_application);
+    }
     async_save_to_file();
   }
 
@@ -95,27 +144,73 @@ public:
   }
 
   void set_input_source_properties(const pqrs::osx::input_source::properties& value) {
-    input_source_properties_ = value;
+    if (input_source_properties_ != value) {
+      input_source_properties_ = value;
+      increment_generation(facet::input_source);
+    }
     async_save_to_file();
   }
 
+  //
+  // Variables are stored in a flat array indexed by the slot of `manipulator_environment_variable_name_table`.
+  // Use the slot-based methods in the hot path; the name-based methods are for IPC, json and tests.
+  //
+
+  manipulator_environment_variable_value get_variable(manipulator_environment_variable_name_table::slot slot) const {
+    if (slot < variables_.size()) {
+      if (auto& v = variables_[slot]) {
+        return *v;
+      }
+    }
+    return manipulator_environment_variable_value();
+  }
+
   manipulator_environment_variable_value get_variable(const std::string& name) const {
-    auto it = variables_.find(name);
-    if (it != std::end(variables_)) {
-      return it->second;
+    if (auto slot = get_shared_manipulator_environment_variable_name_table().find(name)) {
+      return get_variable(*slot);
     }
     return manipulator_environment_variable_value();
   }
 
+  void set_variable(manipulator_environment_variable_name_table::slot slot, const manipulator_environment_variable_value& value) {
+    if (slot >= variables_.size()) {
+      variables_.resize(slot + 1);
+    }
+
+    auto& v = variables_[slot];
+    if (v != value) {
+      v = value;
+      increment_generation(facet::variables);
+    }
+    async_save_to_file();
+  }
+
   void set_variable(const std::string& name, const manipulator_environment_variable_value& value) {
     // logger::get_logger()->info("set_variable {0} {1}", name, value);
-    variables_[name] = value;
+    if (auto slot = get_shared_manipulator_environment_variable_name_table().intern(name)) {
+      set_variable(*slot, value);
+    } else {
+      async_save_to_file();
+    }
+  }
+
+  void unset_variable(manipulator_environment_variable_name_table::slot slot) {
+    if (slot < variables_.size()) {
+      auto& v = variables_[slot];
+      if (v != std::nullopt) {
+        v = std::nullopt;
+        increment_generation(facet::variables);
+      }
+    }
     async_save_to_file();
   }
 
   void unset_variable(const std::string& name) {
-    variables_.erase(name);
-    async_save_to_file();
+    if (auto slot = get_shared_manipulator_environment_variable_name_table().find(name)) {
+      unset_variable(*slot);
+    } else {
+      async_save_to_file();
+    }
   }
 
   gsl::not_null<std::shared_ptr<const core_configuration::core_configuration>> get_core_configuration(void) const {
@@ -124,6 +219,8 @@ public:
 
   void set_core_configuration(gsl::not_null<std::shared_ptr<const core_configuration::core_configuration>> core_configuration) {
     core_configuration_ = core_configuration;
+    // The generation is always incremented since the configuration may be changed in place.
+    increment_generation(facet::core_configuration);
     async_save_to_file();
   }
 
@@ -133,18 +230,41 @@ public:
   }
 
 private:
+  static uint64_t make_instance_id(void) {
+    static std::atomic<uint64_t> last_instance_id(0);
+    return ++last_instance_id;
+  }
+
+  void increment_generation(facet facet) {
+    ++generations_[static_cast<size_t>(facet)];
+  }
+
+  nlohmann::json make_variables_json(void) const {
+    auto json = nlohmann::json::object();
+    auto& table = get_shared_manipulator_environment_variable_name_table();
+    for (manipulator_environment_variable_name_table::slot slot = 0; slot < variables_.size(); ++slot) {
+      if (auto& v = variables_[slot]) {
+        json[table.get_name(slot)] = *v;
+      }
+    }
+    return json;
+  }
+
   void async_save_to_file(void) const {
     if (!output_json_file_path_.empty()) {
       json_writer::async_save_to_file(to_json(), output_json_file_path_, 0755, 0644);
     }
   }
 
+  uint64_t instance_id_;
+  generations generations_;
   std::string output_json_file_path_;
   karabiner_machine_identifier karabiner_machine_identifier_;
   device_properties_manager device_properties_manager_;
+  mutable manipulator_device_condition_results device_condition_results_;
   pqrs::osx::frontmost_application_monitor::application frontmost_application_;
   pqrs::osx::input_source::properties input_source_properties_;
-  std::unordered_map<std::string, manipulator_environment_variable_value> variables_;
+  std::vector<std::optional<manipulator_environment_variable_value>> variables_;
   gsl::not_null<std::shared_ptr<const core_configuration::core_configuration>> core_configuration_;
   virtual_hid_devices_state virtual_hid_devices_state_;
 };
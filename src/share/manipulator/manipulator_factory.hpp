@@ -6,6 +6,7 @@
 #include "manipulator/manipulators/mouse_basic/mouse_basic.hpp"
 #include "manipulator/manipulators/mouse_motion_to_scroll/mouse_motion_to_scroll.hpp"
 #include "manipulator/manipulators/nop.hpp"
+#include "manipulator/manipulators/remap_table/remap_table.hpp"
 #include "manipulator/types.hpp"
 #include <memory>
 
@@ -35,6 +36,37 @@ inline gsl::not_null<std::shared_ptr<manipulators::base>> make_manipulator(const
     throw pqrs::json::unmarshal_error(fmt::format("unknown type `{0}`", type));
   }
 }
+
+// Make manipulators which change `from` into `to` for each definition. (e.g., simple_modifications)
+//
+// If all definitions are simple 1:1 key mappings, they are merged into a single `remap_table` manipulator
+// which looks up the key directly instead of testing `basic` manipulators one by one.
+// Otherwise, `basic` manipulators are made in order to keep the order of definitions.
+inline std::vector<gsl::not_null<std::shared_ptr<manipulators::base>>> make_remap_manipulators(const std::vector<std::pair<manipulators::basic::from_event_definition, to_event_definitions>>& definitions) {
+  std::vector<gsl::not_null<std::shared_ptr<manipulators::base>>> result;
+
+  if (definitions.empty()) {
+    return result;
+  }
+
+  if (std::all_of(std::begin(definitions),
+                  std::end(definitions),
+                  [](const auto& d) {
+                    return manipulators::remap_table::remap_table::remappable(d.first, d.second);
+                  })) {
+    auto m = std::make_shared<manipulators::remap_table::remap_table>();
+    for (const auto& [from, to] : definitions) {
+      m->insert(from, to);
+    }
+    result.push_back(m);
+    return result;
+  }
+
+  for (const auto& [from, to] : definitions) {
+    result.push_back(std::make_shared<manipulators::basic::basic>(from, to));
+  }
+  return result;
+}
 } // namespace manipulator_factory
 } // namespace manipulator
 } // namespace krbn
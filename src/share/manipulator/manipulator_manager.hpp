@@ -1,6 +1,9 @@
 #pragma once
 
+#include "manipulator/conditions/variable.hpp"
 #include "manipulator/manipulator_factory.hpp"
+#include <unordered_map>
+#include <unordered_set>
 
 namespace krbn {
 namespace manipulator {
@@ -8,7 +11,7 @@ class manipulator_manager final {
 public:
   manipulator_manager(const manipulator_manager&) = delete;
 
-  manipulator_manager(void) {
+  manipulator_manager(void) : from_event_index_(std::make_shared<manipulators::basic::manipulated_original_event::from_event_index>()) {
   }
 
   ~manipulator_manager(void) {
@@ -23,7 +26,9 @@ public:
       {
         std::lock_guard<std::mutex> lock(manipulators_mutex_);
 
+        m->set_from_event_index(from_event_index_);
         manipulators_.push_back(m);
+        index_manipulator(manipulators_.size() - 1);
       }
 
     } catch (const pqrs::json::unmarshal_error& e) {
@@ -37,7 +42,9 @@ public:
   void push_back_manipulator(gsl::not_null<std::shared_ptr<manipulators::base>> ptr) {
     std::lock_guard<std::mutex> lock(manipulators_mutex_);
 
+    ptr->set_from_event_index(from_event_index_);
     manipulators_.push_back(ptr);
+    index_manipulator(manipulators_.size() - 1);
   }
 
   /**
@@ -87,9 +94,13 @@ public:
             case event_queue::event::type::pointing_device_event_from_event_tap: {
               std::lock_guard<std::mutex> lock(manipulators_mutex_);
 
-              for (auto&& m : manipulators_) {
-                m->handle_pointing_device_event_from_event_tap(front_input_event,
-                                                               *output_event_queue);
+              // Only manipulators which receive non-target events handle this event.
+
+              update_candidate_indices(nullptr);
+
+              for (const auto& i : candidate_indices_) {
+                manipulators_[i]->handle_pointing_device_event_from_event_tap(front_input_event,
+                                                                              *output_event_queue);
               }
             } break;
 
@@ -115,27 +126,35 @@ public:
             case event_queue::event::type::system_preferences_properties_changed: {
               bool skip = false;
 
-              if (front_input_event.get_validity() == validity::valid) {
-                std::lock_guard<std::mutex> lock(manipulators_mutex_);
+              std::lock_guard<std::mutex> lock(manipulators_mutex_);
 
-                for (auto&& m : manipulators_) {
-                  if (m->already_manipulated(front_input_event)) {
-                    front_input_event.set_validity(validity::invalid);
-                    skip = true;
-                    break;
-                  }
-                }
+              // Skip if the key_down event is already manipulated. (e.g., by `simultaneous`)
+
+              if (front_input_event.get_validity() == validity::valid &&
+                  front_input_event.get_event_type() == event_type::key_down &&
+                  from_event_index_->contains(manipulators::basic::manipulated_original_event::from_event(front_input_event.get_device_id(),
+                                                                                                         front_input_event.get_event(),
+                                                                                                         front_input_event.get_original_event()))) {
+                front_input_event.set_validity(validity::invalid);
+                skip = true;
               }
 
               if (!skip) {
-                std::lock_guard<std::mutex> lock(manipulators_mutex_);
+                update_gates(output_event_queue->get_manipulator_environment());
+                update_candidate_indices(front_input_event.get_event().get_if<momentary_switch_event>());
+
+                for (const auto& i : candidate_indices_) {
+                  auto& m = manipulators_[i];
 
-                for (auto&& m : manipulators_) {
                   auto r = m->manipulate(front_input_event,
                                          *input_event_queue,
                                          output_event_queue,
                                          now);
 
+                  if (m->needs_non_target_events()) {
+                    insert_stateful_index(i);
+                  }
+
                   switch (r) {
                     case manipulate_result::passed:
                     case manipulate_result::manipulated:
@@ -152,7 +171,8 @@ public:
           }
 
           if (input_event_queue->get_front_event().get_validity() == validity::valid) {
-            output_event_queue->push_back_entry(input_event_queue->get_front_event());
+            // The front event is erased soon, so we move it instead of copying.
+            output_event_queue->push_back_entry(std::move(input_event_queue->get_front_event()));
           }
 
           if (core_configuration->get_global_configuration().get_reorder_same_timestamp_input_events_to_prioritize_modifiers()) {
@@ -172,6 +192,79 @@ public:
     return false;
   }
 
+  // Move events at the front of the input queue to the output queue while no manipulator can handle them.
+  //
+  // This is the fast path for stages which are not used for the events.
+  // (e.g., empty simple_modifications, or keys which are not used in `from`.)
+  // Events are moved without copying, and the output queue is sorted once after the events are moved.
+  void pass_through(std::weak_ptr<event_queue::queue> weak_input_event_queue,
+                    std::weak_ptr<event_queue::queue> weak_output_event_queue,
+                    gsl::not_null<std::shared_ptr<const core_configuration::core_configuration>> core_configuration) {
+    if (auto input_event_queue = weak_input_event_queue.lock()) {
+      if (auto output_event_queue = weak_output_event_queue.lock()) {
+        bool moved = false;
+
+        {
+          std::lock_guard<std::mutex> lock(manipulators_mutex_);
+
+          while (!input_event_queue->empty()) {
+            auto& front_input_event = input_event_queue->get_front_event();
+
+            if (can_handle(front_input_event)) {
+              break;
+            }
+
+            // Reset modifier_flags and pointing_buttons in the same way as `manipulate`.
+            switch (front_input_event.get_event().get_type()) {
+              case event_queue::event::type::device_keys_and_pointing_buttons_are_released:
+                output_event_queue->erase_all_active_modifier_flags_except_lock_and_sticky(front_input_event.get_device_id());
+                output_event_queue->erase_all_active_pointing_buttons_except_lock(front_input_event.get_device_id());
+                break;
+
+              case event_queue::event::type::device_ungrabbed:
+                output_event_queue->erase_all_active_modifier_flags(front_input_event.get_device_id());
+                output_event_queue->erase_all_active_pointing_buttons(front_input_event.get_device_id());
+                break;
+
+              case event_queue::event::type::none:
+              case event_queue::event::type::device_grabbed:
+              case event_queue::event::type::pointing_device_event_from_event_tap:
+              case event_queue::event::type::frontmost_application_changed:
+              case event_queue::event::type::input_source_changed:
+              case event_queue::event::type::set_variable:
+              case event_queue::event::type::virtual_hid_devices_state_changed:
+              case event_queue::event::type::momentary_switch_event:
+              case event_queue::event::type::pointing_motion:
+              case event_queue::event::type::shell_command:
+              case event_queue::event::type::select_input_source:
+              case event_queue::event::type::set_notification_message:
+              case event_queue::event::type::mouse_key:
+              case event_queue::event::type::sticky_modifier:
+              case event_queue::event::type::software_function:
+              case event_queue::event::type::stop_keyboard_repeat:
+              case event_queue::event::type::caps_lock_state_changed:
+              case event_queue::event::type::system_preferences_properties_changed:
+                // Do nothing
+                break;
+            }
+
+            if (front_input_event.get_validity() == validity::valid) {
+              output_event_queue->push_back_entry(std::move(front_input_event));
+            }
+
+            input_event_queue->erase_front_event();
+            moved = true;
+          }
+        }
+
+        if (moved &&
+            core_configuration->get_global_configuration().get_reorder_same_timestamp_input_events_to_prioritize_modifiers()) {
+          output_event_queue->sort_events();
+        }
+      }
+    }
+  }
+
   void invalidate_manipulators(void) {
     {
       std::lock_guard<std::mutex> lock(manipulators_mutex_);
@@ -184,6 +277,42 @@ public:
     remove_invalid_manipulators();
   }
 
+  // Replace all manipulators with `manipulators` at once.
+  // Manipulators which are not included in `manipulators` are invalidated,
+  // and active ones are kept until they become inactive in the same way as `invalidate_manipulators`.
+  // Manipulators which are included in both keep their state.
+  void replace_manipulators(const std::vector<gsl::not_null<std::shared_ptr<manipulators::base>>>& manipulators) {
+    std::lock_guard<std::mutex> lock(manipulators_mutex_);
+
+    std::unordered_set<const manipulators::base*> reused;
+    for (const auto& m : manipulators) {
+      reused.insert(m.get().get());
+    }
+
+    std::erase_if(manipulators_,
+                  [&reused](const auto& it) {
+                    if (reused.contains(it.get().get())) {
+                      // Reused manipulators are moved to the position in `manipulators`.
+                      return true;
+                    }
+
+                    it->set_validity(validity::invalid);
+
+                    // Keep active manipulators.
+                    return !it->active();
+                  });
+
+    for (const auto& m : manipulators) {
+      m->set_from_event_index(from_event_index_);
+    }
+
+    manipulators_.insert(std::end(manipulators_),
+                         std::begin(manipulators),
+                         std::end(manipulators));
+
+    rebuild_index();
+  }
+
   size_t get_manipulators_size(void) {
     std::lock_guard<std::mutex> lock(manipulators_mutex_);
 
@@ -204,16 +333,306 @@ private:
   void remove_invalid_manipulators(void) {
     std::lock_guard<std::mutex> lock(manipulators_mutex_);
 
-    manipulators_.erase(std::remove_if(std::begin(manipulators_),
-                                       std::end(manipulators_),
-                                       [](const auto& it) {
-                                         // Keep active manipulators.
-                                         return it->get_validity() == validity::invalid && !it->active();
-                                       }),
-                        std::end(manipulators_));
+    auto it = std::remove_if(std::begin(manipulators_),
+                             std::end(manipulators_),
+                             [](const auto& it) {
+                               // Keep active manipulators.
+                               return it->get_validity() == validity::invalid && !it->active();
+                             });
+    if (it != std::end(manipulators_)) {
+      manipulators_.erase(it, std::end(manipulators_));
+      rebuild_index();
+    }
+  }
+
+  // Returns true if `manipulate` calls some manipulators for `entry`.
+  // The result is conservative: gates are not evaluated here.
+  bool can_handle(const event_queue::entry& entry) const {
+    switch (entry.get_event().get_type()) {
+      case event_queue::event::type::device_keys_and_pointing_buttons_are_released:
+      case event_queue::event::type::device_ungrabbed:
+        // All manipulators handle these events.
+        return !manipulators_.empty();
+
+      case event_queue::event::type::none:
+      case event_queue::event::type::device_grabbed:
+      case event_queue::event::type::frontmost_application_changed:
+      case event_queue::event::type::input_source_changed:
+      case event_queue::event::type::set_variable:
+      case event_queue::event::type::virtual_hid_devices_state_changed:
+        return false;
+
+      case event_queue::event::type::pointing_device_event_from_event_tap:
+        return !wildcard_indices_.empty() ||
+               has_stateful_manipulators();
+
+      case event_queue::event::type::momentary_switch_event:
+      case event_queue::event::type::pointing_motion:
+      case event_queue::event::type::shell_command:
+      case event_queue::event::type::select_input_source:
+      case event_queue::event::type::set_notification_message:
+      case event_queue::event::type::mouse_key:
+      case event_queue::event::type::sticky_modifier:
+      case event_queue::event::type::software_function:
+      case event_queue::event::type::stop_keyboard_repeat:
+      case event_queue::event::type::caps_lock_state_changed:
+      case event_queue::event::type::system_preferences_properties_changed:
+        if (!wildcard_indices_.empty() ||
+            has_stateful_manipulators()) {
+          return true;
+        }
+
+        // `manipulate` invalidates the key_down event which is already manipulated. (e.g., by `simultaneous`)
+        if (entry.get_validity() == validity::valid &&
+            entry.get_event_type() == event_type::key_down &&
+            from_event_index_->contains(manipulators::basic::manipulated_original_event::from_event(entry.get_device_id(),
+                                                                                                   entry.get_event(),
+                                                                                                   entry.get_original_event()))) {
+          return true;
+        }
+
+        if (auto e = entry.get_event().get_if<momentary_switch_event>()) {
+          return usage_pair_indices_.contains(e->get_usage_pair()) ||
+                 usage_page_indices_.contains(e->get_usage_pair().get_usage_page());
+        }
+        return false;
+    }
+
+    return true;
+  }
+
+  bool has_stateful_manipulators(void) const {
+    return std::any_of(std::begin(stateful_indices_),
+                       std::end(stateful_indices_),
+                       [this](auto i) {
+                         return manipulators_[i]->needs_non_target_events();
+                       });
+  }
+
+  //
+  // Index
+  //
+  // `manipulate` is called only for the following manipulators in order of `manipulators_`:
+  //
+  // - Manipulators which `from` event definitions match the event (`usage_pair_indices_`, `usage_page_indices_`)
+  // - Manipulators which require all events (`wildcard_indices_`)
+  // - Manipulators which have some state and need non-target events (`stateful_indices_`)
+  //
+  // Manipulators in `usage_pair_indices_` and `usage_page_indices_` are grouped into buckets by their gate,
+  // which is the first `variable_if` condition. (e.g., `layer == 1` in layer-style profiles)
+  // Buckets whose gate is closed are skipped at once since their manipulators never fulfill the conditions.
+  //
+  // Note:
+  // Manipulators in `wildcard_indices_` are not gated since some of them do work even if their conditions are not fulfilled.
+  // (e.g., `mouse_motion_to_scroll` resets the counter.)
+  //
+  // The indices in buckets, `wildcard_indices_` and `stateful_indices_` are kept sorted
+  // (manipulators are indexed in order of `manipulators_`),
+  // so `update_candidate_indices` merges them without sorting.
+  //
+
+  struct gate final {
+    manipulator_environment_variable_name_table::slot name_slot;
+    manipulator_environment_variable_value value;
+    bool open;
+  };
+
+  struct bucket final {
+    std::optional<size_t> gate_index;
+    std::vector<size_t> indices;
+  };
+
+  void index_manipulator(size_t index) {
+    auto& m = manipulators_[index];
+
+    if (auto event_definitions = m->make_target_event_definitions()) {
+      auto gate_index = find_or_make_gate(*m);
+
+      for (const auto& d : *event_definitions) {
+        if (auto e = d.get_if<momentary_switch_event>()) {
+          push_back_to_bucket(usage_pair_indices_[e->get_usage_pair()], gate_index, index);
+        } else if (auto any_type = d.get_if<event_definition::any_type>()) {
+          push_back_to_bucket(usage_page_indices_[make_usage_page(*any_type)], gate_index, index);
+        }
+      }
+    } else {
+      wildcard_indices_.push_back(index);
+    }
+
+    if (m->needs_non_target_events()) {
+      insert_stateful_index(index);
+    }
+  }
+
+  void insert_stateful_index(size_t index) {
+    auto it = std::lower_bound(std::begin(stateful_indices_),
+                               std::end(stateful_indices_),
+                               index);
+    if (it == std::end(stateful_indices_) || *it != index) {
+      stateful_indices_.insert(it, index);
+    }
+  }
+
+  std::optional<size_t> find_or_make_gate(const manipulators::base& manipulator) {
+    for (const auto& c : manipulator.get_condition_manager().get_conditions()) {
+      auto v = dynamic_cast<const conditions::variable*>(c.get().get());
+      if (v &&
+          v->get_type() == conditions::variable::type::variable_if &&
+          v->get_value()) {
+        for (size_t i = 0; i < gates_.size(); ++i) {
+          if (gates_[i].name_slot == v->get_name_slot() &&
+              gates_[i].value == *(v->get_value())) {
+            return i;
+          }
+        }
+
+        gates_.push_back({
+            .name_slot = v->get_name_slot(),
+            .value = *(v->get_value()),
+            .open = true,
+        });
+        // Evaluate the new gate at the next `update_gates`.
+        gates_variables_generation_ = std::nullopt;
+
+        return gates_.size() - 1;
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  static void push_back_to_bucket(std::vector<bucket>& buckets,
+                                  std::optional<size_t> gate_index,
+                                  size_t index) {
+    for (auto&& b : buckets) {
+      if (b.gate_index == gate_index) {
+        b.indices.push_back(index);
+        return;
+      }
+    }
+
+    buckets.push_back({
+        .gate_index = gate_index,
+        .indices = {index},
+    });
+  }
+
+  // Gates are evaluated again only when variables are changed.
+  void update_gates(const manipulator_environment& manipulator_environment) {
+    auto generation = std::make_pair(manipulator_environment.get_instance_id(),
+                                     manipulator_environment.get_generation(manipulator_environment::facet::variables));
+    if (gates_variables_generation_ == generation) {
+      return;
+    }
+
+    for (auto&& g : gates_) {
+      g.open = (manipulator_environment.get_variable(g.name_slot) == g.value);
+    }
+
+    gates_variables_generation_ = generation;
+  }
+
+  void rebuild_index(void) {
+    usage_pair_indices_.clear();
+    usage_page_indices_.clear();
+    wildcard_indices_.clear();
+    stateful_indices_.clear();
+    gates_.clear();
+    gates_variables_generation_ = std::nullopt;
+
+    for (size_t i = 0; i < manipulators_.size(); ++i) {
+      index_manipulator(i);
+    }
+  }
+
+  void update_candidate_indices(const momentary_switch_event* e) {
+    candidate_indices_.clear();
+
+    // Remove manipulators which no longer need non-target events (e.g., all keys are released).
+
+    std::erase_if(stateful_indices_,
+                  [this](auto i) {
+                    return !manipulators_[i]->needs_non_target_events();
+                  });
+
+    candidate_indices_.insert(std::end(candidate_indices_),
+                              std::begin(stateful_indices_),
+                              std::end(stateful_indices_));
+    merge_candidate_indices(wildcard_indices_);
+
+    if (e) {
+      auto usage_pair_it = usage_pair_indices_.find(e->get_usage_pair());
+      if (usage_pair_it != std::end(usage_pair_indices_)) {
+        merge_open_buckets(usage_pair_it->second);
+      }
+
+      auto usage_page_it = usage_page_indices_.find(e->get_usage_pair().get_usage_page());
+      if (usage_page_it != std::end(usage_page_indices_)) {
+        merge_open_buckets(usage_page_it->second);
+      }
+    }
+
+    // A manipulator might be in multiple sources (e.g., a stateful manipulator in a bucket).
+    candidate_indices_.erase(std::unique(std::begin(candidate_indices_),
+                                         std::end(candidate_indices_)),
+                             std::end(candidate_indices_));
+  }
+
+  void merge_open_buckets(const std::vector<bucket>& buckets) {
+    for (const auto& b : buckets) {
+      if (b.gate_index && !gates_[*b.gate_index].open) {
+        continue;
+      }
+
+      merge_candidate_indices(b.indices);
+    }
+  }
+
+  // Merge sorted `indices` into `candidate_indices_`.
+  void merge_candidate_indices(const std::vector<size_t>& indices) {
+    if (indices.empty()) {
+      return;
+    }
+
+    merged_indices_.clear();
+    std::merge(std::begin(candidate_indices_),
+               std::end(candidate_indices_),
+               std::begin(indices),
+               std::end(indices),
+               std::back_inserter(merged_indices_));
+    std::swap(candidate_indices_, merged_indices_);
+  }
+
+  static pqrs::hid::usage_page::value_t make_usage_page(event_definition::any_type any_type) {
+    switch (any_type) {
+      case event_definition::any_type::key_code:
+        return pqrs::hid::usage_page::keyboard_or_keypad;
+      case event_definition::any_type::consumer_key_code:
+        return pqrs::hid::usage_page::consumer;
+      case event_definition::any_type::apple_vendor_keyboard_key_code:
+        return pqrs::hid::usage_page::apple_vendor_keyboard;
+      case event_definition::any_type::apple_vendor_top_case_key_code:
+        return pqrs::hid::usage_page::apple_vendor_top_case;
+      case event_definition::any_type::pointing_button:
+        return pqrs::hid::usage_page::button;
+    }
+
+    return pqrs::hid::usage_page::undefined;
   }
 
   std::vector<gsl::not_null<std::shared_ptr<manipulators::base>>> manipulators_;
+  std::unordered_map<pqrs::hid::usage_pair, std::vector<bucket>> usage_pair_indices_;
+  std::unordered_map<pqrs::hid::usage_page::value_t, std::vector<bucket>> usage_page_indices_;
+  std::vector<size_t> wildcard_indices_;
+  std::vector<size_t> stateful_indices_;
+  std::vector<gate> gates_;
+  // (manipulator_environment instance_id, variables generation) which `gates_` are evaluated with.
+  std::optional<std::pair<uint64_t, uint64_t>> gates_variables_generation_;
+  std::vector<size_t> candidate_indices_;
+  // A buffer for `merge_candidate_indices`.
+  std::vector<size_t> merged_indices_;
+  // from_events which are held by manipulators in `manipulators_`.
+  std::shared_ptr<manipulators::basic::manipulated_original_event::from_event_index> from_event_index_;
   mutable std::mutex manipulators_mutex_;
 };
 } // namespace manipulator
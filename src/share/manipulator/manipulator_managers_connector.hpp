@@ -32,6 +32,11 @@ public:
                     gsl::not_null<std::shared_ptr<const core_configuration::core_configuration>> core_configuration) const {
       if (auto manipulator_manager = weak_manipulator_manager_.lock()) {
         while (true) {
+          // Pass through events which no manipulator can handle without per-event manipulation.
+          manipulator_manager->pass_through(weak_input_event_queue_,
+                                            weak_output_event_queue_,
+                                            core_configuration);
+
           auto processed = manipulator_manager->manipulate(weak_input_event_queue_,
                                                            weak_output_event_queue_,
                                                            now,
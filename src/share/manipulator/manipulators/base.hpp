@@ -2,6 +2,7 @@
 
 #include "../condition_manager.hpp"
 #include "../types.hpp"
+#include "basic/manipulated_original_event/from_event_index.hpp"
 #include "event_queue.hpp"
 #include "modifier_flag_manager.hpp"
 
@@ -17,8 +18,6 @@ public:
   virtual ~base(void) {
   }
 
-  virtual bool already_manipulated(const event_queue::entry& front_input_event) = 0;
-
   virtual manipulate_result manipulate(event_queue::entry& front_input_event,
                                        const event_queue::queue& input_event_queue,
                                        std::shared_ptr<event_queue::queue> output_event_queue,
@@ -26,6 +25,19 @@ public:
 
   virtual bool active(void) const = 0;
 
+  // Return true while the manipulator has to receive events which are not its targets.
+  // (e.g., unsetting `alone` of pressed keys, canceling `to_delayed_action`.)
+  virtual bool needs_non_target_events(void) const {
+    return active();
+  }
+
+  // Return event_definitions which this manipulator might manipulate.
+  // `manipulator_manager` uses them to skip manipulators which never handle the event.
+  // std::nullopt means the manipulator has to receive all events.
+  virtual std::optional<std::vector<event_definition>> make_target_event_definitions(void) const {
+    return std::nullopt;
+  }
+
   virtual bool needs_virtual_hid_pointing(void) const = 0;
 
   virtual void handle_device_keys_and_pointing_buttons_are_released_event(const event_queue::entry& front_input_event,
@@ -45,6 +57,35 @@ public:
     validity_ = value;
   }
 
+  // `manipulator_manager` shares a from_event_index among its manipulators.
+  // Manipulators register key_down events which they are holding (e.g., `basic` while the key is pressed),
+  // and `manipulator_manager` skips key_down events in the index since they are already manipulated.
+  void set_from_event_index(std::shared_ptr<basic::manipulated_original_event::from_event_index> value) {
+    if (from_event_index_ == value) {
+      return;
+    }
+
+    auto from_events = make_manipulated_from_events();
+
+    if (from_event_index_) {
+      for (const auto& e : from_events) {
+        from_event_index_->erase(e);
+      }
+    }
+
+    from_event_index_ = value;
+
+    if (from_event_index_) {
+      for (const auto& e : from_events) {
+        from_event_index_->insert(e);
+      }
+    }
+  }
+
+  const condition_manager& get_condition_manager(void) const {
+    return condition_manager_;
+  }
+
   void push_back_condition(std::shared_ptr<manipulator::conditions::base> condition) {
     condition_manager_.push_back_condition(condition);
   }
@@ -108,8 +149,26 @@ public:
   }
 
 protected:
+  // Return from_events which are registered to the from_event_index.
+  virtual std::vector<basic::manipulated_original_event::from_event> make_manipulated_from_events(void) const {
+    return {};
+  }
+
+  void insert_to_from_event_index(const basic::manipulated_original_event::from_event& from_event) {
+    if (from_event_index_) {
+      from_event_index_->insert(from_event);
+    }
+  }
+
+  void erase_from_from_event_index(const basic::manipulated_original_event::from_event& from_event) {
+    if (from_event_index_) {
+      from_event_index_->erase(from_event);
+    }
+  }
+
   validity validity_;
   condition_manager condition_manager_;
+  std::shared_ptr<basic::manipulated_original_event::from_event_index> from_event_index_;
 };
 } // namespace manipulators
 } // namespace manipulator
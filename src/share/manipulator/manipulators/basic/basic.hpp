@@ -142,31 +142,8 @@ public:
 
   virtual ~basic(void) {
     detach_from_dispatcher();
-  }
-
-  virtual bool already_manipulated(const event_queue::entry& front_input_event) {
-    // Skip if the key_down event is already manipulated by `simultaneous`.
-
-    manipulated_original_event::from_event from_event(front_input_event.get_device_id(),
-                                                      front_input_event.get_event(),
-                                                      front_input_event.get_original_event());
-
-    switch (front_input_event.get_event_type()) {
-      case event_type::key_down:
-        for (const auto& e : manipulated_original_events_) {
-          if (e->from_event_exists(from_event)) {
-            return true;
-          }
-        }
-        break;
-
-      case event_type::key_up:
-      case event_type::single:
-        // Do nothing
-        break;
-    }
 
-    return false;
+    set_from_event_index(nullptr);
   }
 
   virtual manipulate_result manipulate(event_queue::entry& front_input_event,
@@ -411,6 +388,11 @@ public:
                           front_input_event.get_event_time_stamp().get_time_stamp(),
                           output_event_queue->get_modifier_flag_manager().make_modifier_flags());
                   manipulated_original_events_.push_back(current_manipulated_original_event);
+
+                  // Register from_events in order to skip them when they reach `manipulate` later. (`simultaneous`)
+                  for (const auto& e : current_manipulated_original_event->get_from_events()) {
+                    insert_to_from_event_index(e);
+                  }
                 }
               }
             }
@@ -422,6 +404,12 @@ public:
 
             // Check original_event in order to determine the correspond key_down is manipulated.
 
+            // The from_event_index holds from_events of all manipulators in the manipulator_manager.
+            // If the from_event is not in the index, no manipulator (including this one) manipulated the key_down.
+            if (from_event_index_ && !from_event_index_->contains(from_event)) {
+              break;
+            }
+
             auto it = std::find_if(std::begin(manipulated_original_events_),
                                    std::end(manipulated_original_events_),
                                    [&](const auto& manipulated_original_event) {
@@ -430,6 +418,7 @@ public:
             if (it != std::end(manipulated_original_events_)) {
               current_manipulated_original_event = *it;
               current_manipulated_original_event->erase_from_event(from_event);
+              erase_from_from_event_index(from_event);
               if (current_manipulated_original_event->get_from_events().empty()) {
                 manipulated_original_events_.erase(it);
               }
@@ -622,6 +611,22 @@ public:
     return !manipulated_original_events_.empty();
   }
 
+  virtual bool needs_non_target_events(void) const {
+    if (active()) {
+      return true;
+    }
+
+    if (to_delayed_action_ && to_delayed_action_->pending()) {
+      return true;
+    }
+
+    return false;
+  }
+
+  virtual std::optional<std::vector<event_definition>> make_target_event_definitions(void) const {
+    return from_.get_event_definitions();
+  }
+
   virtual bool needs_virtual_hid_pointing(void) const {
     for (const auto& events : {to_,
                                to_after_key_up_,
@@ -658,6 +663,12 @@ public:
                                              const event_queue::queue& output_event_queue,
                                              absolute_time_point time_stamp) {
     for (auto&& e : manipulated_original_events_) {
+      for (const auto& fe : e->get_from_events()) {
+        if (fe.get_device_id() == device_id) {
+          erase_from_from_event_index(fe);
+        }
+      }
+
       e->erase_from_events_by_device_id(device_id);
     }
 
@@ -699,6 +710,19 @@ public:
     return to_delayed_action_;
   }
 
+protected:
+  virtual std::vector<manipulated_original_event::from_event> make_manipulated_from_events(void) const {
+    std::vector<manipulated_original_event::from_event> result;
+
+    for (const auto& e : manipulated_original_events_) {
+      for (const auto& fe : e->get_from_events()) {
+        result.push_back(fe);
+      }
+    }
+
+    return result;
+  }
+
 private:
   bool all_from_events_found(const std::unordered_set<manipulated_original_event::from_event>& from_events) const {
     for (const auto& d : from_.get_event_definitions()) {
@@ -0,0 +1,54 @@
+#pragma once
+
+// `krbn::manipulator::manipulators::basic::manipulated_original_event::from_event_index` is not thread-safe.
+// (It is accessed while `manipulator_manager::manipulators_mutex_` is locked.)
+
+#include "from_event.hpp"
+#include <unordered_map>
+
+namespace krbn {
+namespace manipulator {
+namespace manipulators {
+namespace basic {
+namespace manipulated_original_event {
+// The set of from_events which are held by manipulators in a manipulator_manager.
+// It is shared among the manipulators in order to determine whether a key_down event is already manipulated
+// by one lookup instead of asking each manipulator.
+//
+// The same from_event might be held by multiple manipulators, so the number of holders is counted.
+class from_event_index final {
+public:
+  from_event_index(const from_event_index&) = delete;
+
+  from_event_index(void) {
+  }
+
+  void insert(const from_event& from_event) {
+    ++counts_[from_event];
+  }
+
+  void erase(const from_event& from_event) {
+    auto it = counts_.find(from_event);
+    if (it != std::end(counts_)) {
+      if (--(it->second) == 0) {
+        counts_.erase(it);
+      }
+    }
+  }
+
+  bool contains(const from_event& from_event) const {
+    return counts_.find(from_event) != std::end(counts_);
+  }
+
+  size_t size(void) const {
+    return counts_.size();
+  }
+
+private:
+  std::unordered_map<from_event, size_t> counts_;
+};
+} // namespace manipulated_original_event
+} // namespace basic
+} // namespace manipulators
+} // namespace manipulator
+} // namespace krbn
@@ -2,6 +2,7 @@
 
 #include "../../types.hpp"
 #include "event_sender.hpp"
+#include "timer_wheel.hpp"
 #include <unordered_set>
 #include <vector>
 
@@ -12,7 +13,7 @@ namespace basic {
 class to_delayed_action final : public pqrs::dispatcher::extra::dispatcher_client {
 public:
   to_delayed_action(const nlohmann::json& json) : dispatcher_client(),
-                                                  current_delayed_action_id_(0) {
+                                                  delayed_action_timer_(*this) {
     try {
       pqrs::json::requires_object(json, "json");
 
@@ -71,6 +72,7 @@ public:
   }
 
   virtual ~to_delayed_action(void) {
+    delayed_action_timer_.cancel();
     detach_from_dispatcher();
   }
 
@@ -95,24 +97,19 @@ public:
       return;
     }
 
-    ++current_delayed_action_id_;
+    delayed_action_timer_.cancel();
 
     front_input_event_ = front_input_event;
     current_manipulated_original_event_ = current_manipulated_original_event;
     output_event_queue_ = output_event_queue;
 
-    auto delayed_action_id = current_delayed_action_id_;
     auto duration = pqrs::osx::chrono::make_absolute_time_duration(delay_milliseconds);
 
-    enqueue_to_dispatcher(
-        [this, delayed_action_id] {
-          if (current_delayed_action_id_ != delayed_action_id) {
-            return;
-          }
-
+    delayed_action_timer_.arm(
+        pqrs::osx::chrono::make_milliseconds(duration),
+        [this] {
           post_events(to_if_invoked_);
-        },
-        when_now() + pqrs::osx::chrono::make_milliseconds(duration));
+        });
   }
 
   void cancel(const event_queue::entry& front_input_event) {
@@ -120,11 +117,16 @@ public:
       return;
     }
 
-    ++current_delayed_action_id_;
+    delayed_action_timer_.cancel();
 
     post_events(to_if_canceled_);
   }
 
+  // Return true until `to_if_invoked` or `to_if_canceled` is posted.
+  bool pending(void) const {
+    return current_manipulated_original_event_ != nullptr;
+  }
+
   bool needs_virtual_hid_pointing(void) const {
     for (const auto& events : {to_if_invoked_,
                                to_if_canceled_}) {
@@ -198,7 +200,7 @@ private:
   std::optional<event_queue::entry> front_input_event_;
   std::shared_ptr<manipulated_original_event::manipulated_original_event> current_manipulated_original_event_;
   std::weak_ptr<event_queue::queue> output_event_queue_;
-  int current_delayed_action_id_;
+  timer_wheel_one_shot_timer delayed_action_timer_;
 };
 } // namespace basic
 } // namespace manipulators
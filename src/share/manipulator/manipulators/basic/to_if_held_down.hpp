@@ -2,6 +2,7 @@
 
 #include "../../types.hpp"
 #include "event_sender.hpp"
+#include "timer_wheel.hpp"
 #include <pqrs/json.hpp>
 #include <unordered_set>
 #include <vector>
@@ -13,7 +14,7 @@ namespace basic {
 class to_if_held_down final : public pqrs::dispatcher::extra::dispatcher_client {
 public:
   to_if_held_down(const nlohmann::json& json) : dispatcher_client(),
-                                                current_held_down_id_(0) {
+                                                held_down_timer_(*this) {
     try {
       if (json.is_object()) {
         to_.push_back(std::make_shared<to_event_definition>(json));
@@ -34,6 +35,7 @@ public:
   }
 
   virtual ~to_if_held_down(void) {
+    held_down_timer_.cancel();
     detach_from_dispatcher();
   }
 
@@ -45,7 +47,7 @@ public:
              std::weak_ptr<manipulated_original_event::manipulated_original_event> current_manipulated_original_event,
              std::weak_ptr<event_queue::queue> output_event_queue,
              std::chrono::milliseconds threshold_milliseconds) {
-    ++current_held_down_id_;
+    held_down_timer_.cancel();
 
     if (front_input_event.get_event_type() != event_type::key_down) {
       return;
@@ -59,15 +61,11 @@ public:
     current_manipulated_original_event_ = current_manipulated_original_event;
     output_event_queue_ = output_event_queue;
 
-    auto held_down_id = current_held_down_id_;
     auto duration = pqrs::osx::chrono::make_absolute_time_duration(threshold_milliseconds);
 
-    enqueue_to_dispatcher(
-        [this, held_down_id] {
-          if (current_held_down_id_ != held_down_id) {
-            return;
-          }
-
+    held_down_timer_.arm(
+        pqrs::osx::chrono::make_milliseconds(duration),
+        [this] {
           if (front_input_event_) {
             if (auto oeq = output_event_queue_.lock()) {
               if (auto cmoe = current_manipulated_original_event_.lock()) {
@@ -113,8 +111,7 @@ public:
               }
             }
           }
-        },
-        when_now() + pqrs::osx::chrono::make_milliseconds(duration));
+        });
   }
 
   void cancel(const event_queue::entry& front_input_event) {
@@ -122,7 +119,7 @@ public:
       return;
     }
 
-    ++current_held_down_id_;
+    held_down_timer_.cancel();
   }
 
   bool needs_virtual_hid_pointing(void) const {
@@ -138,7 +135,7 @@ private:
   std::optional<event_queue::entry> front_input_event_;
   std::weak_ptr<manipulated_original_event::manipulated_original_event> current_manipulated_original_event_;
   std::weak_ptr<event_queue::queue> output_event_queue_;
-  int current_held_down_id_;
+  timer_wheel_one_shot_timer held_down_timer_;
 };
 } // namespace basic
 } // namespace manipulators
@@ -87,10 +87,6 @@ public:
   virtual ~mouse_basic(void) {
   }
 
-  virtual bool already_manipulated(const event_queue::entry& front_input_event) {
-    return false;
-  }
-
   virtual manipulate_result manipulate(event_queue::entry& front_input_event,
                                        const event_queue::queue& input_event_queue,
                                        std::shared_ptr<event_queue::queue> output_event_queue,
@@ -5,6 +5,7 @@
 #include "counter_direction.hpp"
 #include "counter_entry.hpp"
 #include "options.hpp"
+#include "timer_wheel.hpp"
 #include "types/absolute_time_duration.hpp"
 #include "types/pointing_motion.hpp"
 #include <algorithm>
@@ -45,7 +46,7 @@ public:
         momentum_y_(0),
         momentum_count_(0),
         momentum_wait_(0),
-        timer_(*this) {
+        timer_(*this, weak_dispatcher) {
   }
 
   ~counter(void) {
@@ -430,7 +431,7 @@ private:
   int momentum_count_;
   int momentum_wait_;
 
-  pqrs::dispatcher::extra::timer timer_;
+  timer_wheel_timer timer_;
 };
 } // namespace mouse_motion_to_scroll
 } // namespace manipulators
@@ -0,0 +1,50 @@
+#pragma once
+
+// `krbn::manipulator::manipulators::post_event_to_virtual_devices::hid_report_submitter` is not thread-safe.
+
+#include <memory>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+#include <variant>
+#include <vector>
+
+namespace krbn {
+namespace manipulator {
+namespace manipulators {
+namespace post_event_to_virtual_devices {
+using hid_report = std::variant<pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::keyboard_input,
+                                pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::consumer_input,
+                                pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::apple_vendor_top_case_input,
+                                pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::apple_vendor_keyboard_input,
+                                pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::generic_desktop_input,
+                                pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input>;
+
+// Submits a batch of HID reports to virtual_hid_device_service::client.
+//
+// `queue::post_events` passes the reports which have the same time stamp as one batch.
+// virtual_hid_device_service::client does not provide a batched call,
+// so the reports are posted one by one in order with a single lock of the client.
+// This class is the place to replace it with one call when the client supports it.
+class hid_report_submitter final {
+public:
+  hid_report_submitter(std::weak_ptr<pqrs::karabiner::driverkit::virtual_hid_device_service::client> weak_virtual_hid_device_service_client)
+      : weak_virtual_hid_device_service_client_(weak_virtual_hid_device_service_client) {
+  }
+
+  void submit(const std::vector<hid_report>& hid_reports) const {
+    if (auto client = weak_virtual_hid_device_service_client_.lock()) {
+      for (const auto& r : hid_reports) {
+        std::visit([&client](const auto& report) {
+          client->async_post_report(report);
+        },
+                   r);
+      }
+    }
+  }
+
+private:
+  std::weak_ptr<pqrs::karabiner::driverkit::virtual_hid_device_service::client> weak_virtual_hid_device_service_client_;
+};
+} // namespace post_event_to_virtual_devices
+} // namespace manipulators
+} // namespace manipulator
+} // namespace krbn
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "queue.hpp"
+#include "timer_wheel.hpp"
 #include <pqrs/osx/system_preferences.hpp>
 
 namespace krbn {
@@ -192,7 +193,7 @@ private:
   count_converter y_count_converter_;
   count_converter vertical_wheel_count_converter_;
   count_converter horizontal_wheel_count_converter_;
-  pqrs::dispatcher::extra::timer timer_;
+  timer_wheel_timer timer_;
 };
 } // namespace post_event_to_virtual_devices
 } // namespace manipulators
@@ -33,10 +33,6 @@ public:
     });
   }
 
-  virtual bool already_manipulated(const event_queue::entry& front_input_event) {
-    return false;
-  }
-
   virtual manipulate_result manipulate(event_queue::entry& front_input_event,
                                        const event_queue::queue& input_event_queue,
                                        std::shared_ptr<event_queue::queue> output_event_queue,
@@ -405,6 +401,11 @@ public:
     return queue_.clear();
   }
 
+  // This is called when the configuration is updated, not on each pointing event.
+  void set_coalesce_pointing_inputs(bool value) {
+    queue_.set_coalesce_pointing_inputs(value);
+  }
+
   const key_event_dispatcher& get_key_event_dispatcher(void) const {
     return key_event_dispatcher_;
   }
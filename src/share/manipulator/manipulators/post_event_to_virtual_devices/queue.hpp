@@ -1,8 +1,12 @@
 #pragma once
 
+#include "hid_report_submitter.hpp"
 #include "keyboard_repeat_detector.hpp"
+#include "ring_buffer.hpp"
 #include "types.hpp"
 #include "virtual_hid_device_utility.hpp"
+#include <algorithm>
+#include <limits>
 #include <pqrs/dispatcher.hpp>
 #include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
 #include <variant>
@@ -210,6 +214,29 @@ public:
       return std::nullopt;
     }
 
+    std::optional<hid_report> get_hid_report(void) const {
+      switch (type_) {
+        case type::keyboard_input:
+          return std::get<pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::keyboard_input>(value_);
+        case type::consumer_input:
+          return std::get<pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::consumer_input>(value_);
+        case type::apple_vendor_top_case_input:
+          return std::get<pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::apple_vendor_top_case_input>(value_);
+        case type::apple_vendor_keyboard_input:
+          return std::get<pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::apple_vendor_keyboard_input>(value_);
+        case type::generic_desktop_input:
+          return std::get<pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::generic_desktop_input>(value_);
+        case type::pointing_input:
+          return std::get<pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input>(value_);
+        case type::shell_command:
+        case type::select_input_source:
+        case type::software_function:
+          return std::nullopt;
+      }
+
+      return std::nullopt;
+    }
+
     std::optional<std::string> get_shell_command(void) const {
       if (type_ == type::shell_command) {
         return std::get<std::string>(value_);
@@ -280,16 +307,22 @@ public:
     absolute_time_point time_stamp_;
   };
 
-  queue(void) : dispatcher_client(),
-                last_event_type_(event_type::single),
-                last_event_time_stamp_(0) {
+  queue(void) : queue(pqrs::dispatcher::extra::get_shared_dispatcher()) {
+  }
+
+  queue(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher) : dispatcher_client(weak_dispatcher),
+                                                                       coalesce_pointing_inputs_(false),
+                                                                       flush_timer_id_(0),
+                                                                       scheduled_flush_count_(0),
+                                                                       last_event_type_(event_type::single),
+                                                                       last_event_time_stamp_(0) {
   }
 
   virtual ~queue(void) {
     detach_from_dispatcher();
   }
 
-  const std::vector<event>& get_events(void) const {
+  const ring_buffer<event>& get_events(void) const {
     return events_;
   }
 
@@ -297,6 +330,15 @@ public:
     return keyboard_repeat_detector_;
   }
 
+  bool get_coalesce_pointing_inputs(void) const {
+    return coalesce_pointing_inputs_;
+  }
+
+  // If enabled, `post_events` merges consecutive pointing_input reports which are already due and have the same buttons.
+  void set_coalesce_pointing_inputs(bool value) {
+    coalesce_pointing_inputs_ = value;
+  }
+
   void emplace_back_key_event(const pqrs::hid::usage_pair& usage_pair,
                               event_type event_type,
                               absolute_time_point time_stamp) {
@@ -466,104 +508,255 @@ public:
                          std::weak_ptr<console_user_server_client> weak_console_user_server_client) {
     enqueue_to_dispatcher(
         [this, weak_virtual_hid_device_service_client, weak_console_user_server_client] {
-          auto now = pqrs::osx::chrono::mach_absolute_time_point();
-
-          while (!events_.empty()) {
-            auto& e = events_.front();
-            if (e.get_time_stamp() > now) {
-              // If e.get_time_stamp() is too large, we reduce the delay to 3 seconds.
-
-              absolute_time_duration duration(0);
-              if (now < e.get_time_stamp()) {
-                duration = std::min(e.get_time_stamp() - now,
-                                    pqrs::osx::chrono::make_absolute_time_duration(std::chrono::milliseconds(3000)));
-              }
-
-              enqueue_to_dispatcher(
-                  [this, weak_virtual_hid_device_service_client, weak_console_user_server_client] {
-                    async_post_events(weak_virtual_hid_device_service_client,
-                                      weak_console_user_server_client);
-                  },
-                  when_now() + pqrs::osx::chrono::make_milliseconds(duration));
-
-              return;
-            }
+          post_events_and_arm_flush_timer(weak_virtual_hid_device_service_client,
+                                          weak_console_user_server_client);
+        });
+  }
 
-            if (auto input = e.get_keyboard_input()) {
-              if (auto client = weak_virtual_hid_device_service_client.lock()) {
-                client->async_post_report(*input);
-              }
-            }
-            if (auto input = e.get_consumer_input()) {
-              if (auto client = weak_virtual_hid_device_service_client.lock()) {
-                client->async_post_report(*input);
-              }
-            }
-            if (auto input = e.get_apple_vendor_top_case_input()) {
-              if (auto client = weak_virtual_hid_device_service_client.lock()) {
-                client->async_post_report(*input);
-              }
-            }
-            if (auto input = e.get_apple_vendor_keyboard_input()) {
-              if (auto client = weak_virtual_hid_device_service_client.lock()) {
-                client->async_post_report(*input);
-              }
-            }
-            if (auto input = e.get_generic_desktop_input()) {
-              if (auto client = weak_virtual_hid_device_service_client.lock()) {
-                client->async_post_report(*input);
-              }
-            }
-            if (auto pointing_input = e.get_pointing_input()) {
-              if (auto client = weak_virtual_hid_device_service_client.lock()) {
-                client->async_post_report(*pointing_input);
-              }
-            }
-            if (auto shell_command = e.get_shell_command()) {
-              if (auto client = weak_console_user_server_client.lock()) {
-                client->async_shell_command_execution(*shell_command);
-              }
+  // The number of delayed flushes which have been scheduled by `async_post_events`.
+  size_t get_scheduled_flush_count(void) const {
+    return scheduled_flush_count_;
+  }
+
+  // Post events which time stamps are equal to or earlier than `now`.
+  // Returns the time stamp of the first remaining event.
+  //
+  // HID reports which have the same time stamp are passed to `hid_report_submitter` as one batch.
+  // The batch is submitted before other events (shell_command, select_input_source, software_function)
+  // in order to keep the order of events.
+  //
+  // The submitter and client types are template parameters in order to use stand-ins in tests.
+  template <typename hid_report_submitter_t, typename console_user_server_client_t>
+  std::optional<absolute_time_point> post_events(absolute_time_point now,
+                                                 const hid_report_submitter_t& hid_report_submitter,
+                                                 std::weak_ptr<console_user_server_client_t> weak_console_user_server_client) {
+    if (coalesce_pointing_inputs_) {
+      coalesce_pointing_inputs(now);
+    }
+
+    absolute_time_point hid_reports_time_stamp(0);
+
+    auto submit_hid_reports = [&] {
+      if (!hid_reports_.empty()) {
+        hid_report_submitter.submit(hid_reports_);
+        hid_reports_.clear();
+      }
+    };
+
+    while (!events_.empty()) {
+      auto& e = events_.front();
+      if (e.get_time_stamp() > now) {
+        submit_hid_reports();
+        return e.get_time_stamp();
+      }
+
+      if (auto r = e.get_hid_report()) {
+        if (hid_reports_time_stamp != e.get_time_stamp()) {
+          submit_hid_reports();
+          hid_reports_time_stamp = e.get_time_stamp();
+        }
+        hid_reports_.push_back(*r);
+
+        events_.pop_front();
+        continue;
+      }
+
+      submit_hid_reports();
+
+      if (auto shell_command = e.get_shell_command()) {
+        if (auto client = weak_console_user_server_client.lock()) {
+          client->async_shell_command_execution(*shell_command);
+        }
+      }
+      if (auto input_source_specifiers = e.get_input_source_specifiers()) {
+        if (auto client = weak_console_user_server_client.lock()) {
+          auto specifiers = std::make_shared<std::vector<pqrs::osx::input_source_selector::specifier>>();
+          for (const auto& s : *input_source_specifiers) {
+            pqrs::osx::input_source_selector::specifier specifier;
+
+            if (auto& v = s.get_language_string()) {
+              specifier.set_language(*v);
             }
-            if (auto input_source_specifiers = e.get_input_source_specifiers()) {
-              if (auto client = weak_console_user_server_client.lock()) {
-                auto specifiers = std::make_shared<std::vector<pqrs::osx::input_source_selector::specifier>>();
-                for (const auto& s : *input_source_specifiers) {
-                  pqrs::osx::input_source_selector::specifier specifier;
-
-                  if (auto& v = s.get_language_string()) {
-                    specifier.set_language(*v);
-                  }
-
-                  if (auto& v = s.get_input_source_id_string()) {
-                    specifier.set_input_source_id(*v);
-                  }
-
-                  if (auto& v = s.get_input_mode_id_string()) {
-                    specifier.set_input_mode_id(*v);
-                  }
-
-                  specifiers->push_back(specifier);
-                }
-                client->async_select_input_source(specifiers);
-              }
+
+            if (auto& v = s.get_input_source_id_string()) {
+              specifier.set_input_source_id(*v);
             }
-            if (auto software_function = e.get_software_function()) {
-              if (auto client = weak_console_user_server_client.lock()) {
-                client->async_software_function(*software_function);
-              }
+
+            if (auto& v = s.get_input_mode_id_string()) {
+              specifier.set_input_mode_id(*v);
             }
 
-            events_.erase(std::begin(events_));
+            specifiers->push_back(specifier);
           }
-        });
+          client->async_select_input_source(specifiers);
+        }
+      }
+      if (auto software_function = e.get_software_function()) {
+        if (auto client = weak_console_user_server_client.lock()) {
+          client->async_software_function(*software_function);
+        }
+      }
+
+      events_.pop_front();
+    }
+
+    submit_hid_reports();
+
+    // The armed flush is no longer needed.
+    flush_deadline_ = std::nullopt;
+
+    return std::nullopt;
   }
 
   void clear(void) {
     events_.clear();
     keyboard_repeat_detector_.clear();
+    flush_deadline_ = std::nullopt;
   }
 
 private:
+  // Post due events, and arm the flush timer for the remaining events.
+  //
+  // Only one flush timer is armed at a time.
+  // `async_post_events` is called after every manipulation, so the timer is re-armed only if the next deadline is earlier than the armed one.
+  // (A superseded timer does nothing when it fires.)
+  void post_events_and_arm_flush_timer(std::weak_ptr<pqrs::karabiner::driverkit::virtual_hid_device_service::client> weak_virtual_hid_device_service_client,
+                                       std::weak_ptr<console_user_server_client> weak_console_user_server_client) {
+    auto now = pqrs::osx::chrono::mach_absolute_time_point();
+
+    auto time_stamp = post_events(now,
+                                  hid_report_submitter(weak_virtual_hid_device_service_client),
+                                  weak_console_user_server_client);
+    if (!time_stamp) {
+      return;
+    }
+
+    // If the time stamp is too large, we reduce the delay to 3 seconds.
+
+    auto deadline = std::min(*time_stamp,
+                             now + pqrs::osx::chrono::make_absolute_time_duration(std::chrono::milliseconds(3000)));
+
+    if (flush_deadline_ && *flush_deadline_ <= deadline) {
+      return;
+    }
+
+    flush_deadline_ = deadline;
+    auto id = ++flush_timer_id_;
+    ++scheduled_flush_count_;
+
+    enqueue_to_dispatcher(
+        [this, weak_virtual_hid_device_service_client, weak_console_user_server_client, id] {
+          if (id != flush_timer_id_) {
+            return;
+          }
+
+          flush_deadline_ = std::nullopt;
+
+          post_events_and_arm_flush_timer(weak_virtual_hid_device_service_client,
+                                          weak_console_user_server_client);
+        },
+        when_now() + pqrs::osx::chrono::make_milliseconds(deadline - now));
+  }
+
+  // Merge consecutive pointing_input reports which time stamps are equal to or earlier than `now` and have the same buttons.
+  //
+  // x, y and wheels are summed, and the total is split into multiple reports if it exceeds the range of a report.
+  // Reports are never merged across other events (e.g., keyboard_input, shell_command) or button changes,
+  // so the order of events is kept.
+  // The merged reports have the time stamp of the first report.
+  void coalesce_pointing_inputs(absolute_time_point now) {
+    auto last = std::find_if(std::begin(events_),
+                             std::end(events_),
+                             [now](const auto& e) {
+                               return e.get_time_stamp() > now;
+                             });
+
+    // Find the first reports to be merged in order to leave `events_` untouched if no report is merged.
+    auto first = std::adjacent_find(std::begin(events_),
+                                    last,
+                                    [](const auto& a, const auto& b) {
+                                      auto ra = a.get_pointing_input();
+                                      auto rb = b.get_pointing_input();
+                                      return ra && rb && ra->buttons == rb->buttons;
+                                    });
+    if (first == last) {
+      return;
+    }
+
+    // Rebuild events from `first`.
+
+    ring_buffer<event> events;
+
+    auto it = first;
+    while (it != last) {
+      auto report = it->get_pointing_input();
+      if (!report) {
+        events.push_back(std::move(*it));
+        ++it;
+        continue;
+      }
+
+      auto time_stamp = it->get_time_stamp();
+      int x = static_cast<int8_t>(report->x);
+      int y = static_cast<int8_t>(report->y);
+      int vertical_wheel = static_cast<int8_t>(report->vertical_wheel);
+      int horizontal_wheel = static_cast<int8_t>(report->horizontal_wheel);
+      size_t count = 1;
+
+      for (++it; it != last; ++it) {
+        auto r = it->get_pointing_input();
+        if (!r || r->buttons != report->buttons) {
+          break;
+        }
+
+        x += static_cast<int8_t>(r->x);
+        y += static_cast<int8_t>(r->y);
+        vertical_wheel += static_cast<int8_t>(r->vertical_wheel);
+        horizontal_wheel += static_cast<int8_t>(r->horizontal_wheel);
+        ++count;
+      }
+
+      if (count == 1) {
+        events.emplace_back(*report, time_stamp);
+        continue;
+      }
+
+      // Split the total into reports.
+      do {
+        auto r = *report;
+        r.x = take_pointing_input_value(x);
+        r.y = take_pointing_input_value(y);
+        r.vertical_wheel = take_pointing_input_value(vertical_wheel);
+        r.horizontal_wheel = take_pointing_input_value(horizontal_wheel);
+        events.emplace_back(r, time_stamp);
+      } while (x != 0 ||
+               y != 0 ||
+               vertical_wheel != 0 ||
+               horizontal_wheel != 0);
+    }
+
+    for (; it != std::end(events_); ++it) {
+      events.push_back(std::move(*it));
+    }
+
+    auto size = static_cast<size_t>(first - std::begin(events_));
+    while (events_.size() > size) {
+      events_.pop_back();
+    }
+    for (auto& e : events) {
+      events_.push_back(std::move(e));
+    }
+  }
+
+  // Take a value which fits into a pointing_input field from `value`, and subtract it from `value`.
+  static int8_t take_pointing_input_value(int& value) {
+    auto v = std::clamp(value,
+                        static_cast<int>(-std::numeric_limits<int8_t>::max()),
+                        static_cast<int>(std::numeric_limits<int8_t>::max()));
+    value -= v;
+    return static_cast<int8_t>(v);
+  }
+
   void adjust_time_stamp(absolute_time_point& time_stamp,
                          event_type et,
                          bool is_modifier_key_event = false) {
@@ -603,7 +796,15 @@ private:
     }
   }
 
-  std::vector<event> events_;
+  ring_buffer<event> events_;
+  bool coalesce_pointing_inputs_;
+  // The batch of HID reports in `post_events`. (The capacity is reused.)
+  std::vector<hid_report> hid_reports_;
+
+  // The flush timer
+  std::optional<absolute_time_point> flush_deadline_;
+  uint64_t flush_timer_id_;
+  size_t scheduled_flush_count_;
 
   keyboard_repeat_detector keyboard_repeat_detector_;
 
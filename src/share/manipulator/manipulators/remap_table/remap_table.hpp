@@ -0,0 +1,323 @@
+#pragma once
+
+#include "../../types.hpp"
+#include "../base.hpp"
+#include "../basic/from_event_definition.hpp"
+#include "../basic/manipulated_original_event/from_event.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace krbn {
+namespace manipulator {
+namespace manipulators {
+namespace remap_table {
+// `remap_table` changes a key into another key with a per-usage-page direct lookup table.
+//
+// It is equivalent to a sequence of `basic` manipulators which have the same conditions and
+// a single `from` key with `"modifiers": { "optional": ["any"] }` and a single `to` key without options.
+// (e.g., simple_modifications, fn_function_keys)
+//
+// Keys which are not in the table are passed through.
+class remap_table final : public base {
+public:
+  remap_table(void) : base() {
+  }
+
+  virtual ~remap_table(void) {
+    set_from_event_index(nullptr);
+  }
+
+  // Returns true if a `basic` manipulator which has `from` and `to` can be replaced with a remap_table entry.
+  static bool remappable(const basic::from_event_definition& from,
+                         const to_event_definitions& to) {
+    //
+    // from
+    //
+
+    if (from.get_event_definitions().size() != 1) {
+      return false;
+    }
+
+    auto from_event = from.get_event_definitions().front().get_if<momentary_switch_event>();
+    if (!from_event ||
+        !from_event->valid() ||
+        type_safe::get(from_event->get_usage_pair().get_usage()) >= max_usage) {
+      return false;
+    }
+
+    if (!from.get_from_modifiers_definition().get_mandatory_modifiers().empty() ||
+        !from.get_from_modifiers_definition().get_optional_modifiers().contains(modifier_definition::modifier::any)) {
+      return false;
+    }
+
+    if (!from.get_simultaneous_options()->get_to_after_key_up().empty()) {
+      return false;
+    }
+
+    //
+    // to
+    //
+
+    if (to.size() != 1) {
+      return false;
+    }
+
+    auto& t = to.front();
+
+    if (!t->get_event_definition().get_if<momentary_switch_event>() ||
+        !t->get_modifiers().empty() ||
+        t->get_lazy() ||
+        !t->get_repeat() ||
+        t->get_halt() ||
+        t->get_hold_down_milliseconds() != std::chrono::milliseconds(0) ||
+        !t->get_condition_manager().get_conditions().empty()) {
+      return false;
+    }
+
+    return true;
+  }
+
+  // Add an entry which is made from `remappable` `from` and `to`.
+  // If `from` key already exists, the entry is ignored in order to keep the first one as the `basic` manipulators do.
+  bool insert(const basic::from_event_definition& from,
+              const to_event_definitions& to) {
+    if (!remappable(from, to)) {
+      return false;
+    }
+
+    auto& from_event_definition = from.get_event_definitions().front();
+    auto usage_pair = from_event_definition.get_if<momentary_switch_event>()->get_usage_pair();
+    auto usage = static_cast<size_t>(type_safe::get(usage_pair.get_usage()));
+
+    auto& indices = find_or_make_page(usage_pair.get_usage_page()).indices;
+    if (indices.size() <= usage) {
+      indices.resize(usage + 1, 0);
+    }
+
+    if (indices[usage] != 0) {
+      return false;
+    }
+
+    entries_.push_back({
+        .from = from_event_definition,
+        .to = to.front(),
+        .to_event = *(to.front()->get_event_definition().to_event()),
+    });
+    indices[usage] = entries_.size();
+
+    return true;
+  }
+
+  size_t size(void) const {
+    return entries_.size();
+  }
+
+  virtual manipulate_result manipulate(event_queue::entry& front_input_event,
+                                       const event_queue::queue& input_event_queue,
+                                       std::shared_ptr<event_queue::queue> output_event_queue,
+                                       absolute_time_point now) {
+    if (!output_event_queue) {
+      return manipulate_result::passed;
+    }
+
+    if (front_input_event.get_validity() == validity::invalid) {
+      return manipulate_result::passed;
+    }
+
+    auto e = front_input_event.get_event().get_if<momentary_switch_event>();
+    if (!e) {
+      return manipulate_result::passed;
+    }
+
+    switch (front_input_event.get_event_type()) {
+      case event_type::key_down: {
+        if (validity_ == validity::invalid) {
+          return manipulate_result::passed;
+        }
+
+        auto entry = find_entry(*e);
+        if (!entry) {
+          return manipulate_result::passed;
+        }
+
+        if (!condition_manager_.is_fulfilled(front_input_event,
+                                             output_event_queue->get_manipulator_environment())) {
+          return manipulate_result::passed;
+        }
+
+        front_input_event.set_validity(validity::invalid);
+
+        output_event_queue->emplace_back_entry(front_input_event.get_device_id(),
+                                               front_input_event.get_event_time_stamp(),
+                                               entry->to_event,
+                                               event_type::key_down,
+                                               front_input_event.get_original_event(),
+                                               event_queue::state::manipulated);
+
+        active_events_.push_back({
+            .from_event = make_from_event(front_input_event),
+            .to_event = entry->to_event,
+        });
+        insert_to_from_event_index(active_events_.back().from_event);
+
+        return manipulate_result::manipulated;
+      }
+
+      case event_type::key_up: {
+        // Send key_up even if the manipulator is invalidated while the key is pressed.
+
+        auto it = find_active_event(make_from_event(front_input_event));
+        if (it == std::end(active_events_)) {
+          return manipulate_result::passed;
+        }
+
+        front_input_event.set_validity(validity::invalid);
+
+        output_event_queue->emplace_back_entry(it->from_event.get_device_id(),
+                                               front_input_event.get_event_time_stamp(),
+                                               it->to_event,
+                                               event_type::key_up,
+                                               it->from_event.get_original_event(),
+                                               event_queue::state::manipulated);
+
+        erase_from_from_event_index(it->from_event);
+        active_events_.erase(it);
+
+        return manipulate_result::manipulated;
+      }
+
+      case event_type::single:
+        break;
+    }
+
+    return manipulate_result::passed;
+  }
+
+  virtual bool active(void) const {
+    return !active_events_.empty();
+  }
+
+  virtual std::optional<std::vector<event_definition>> make_target_event_definitions(void) const {
+    std::vector<event_definition> event_definitions;
+
+    for (const auto& e : entries_) {
+      event_definitions.push_back(e.from);
+    }
+
+    return event_definitions;
+  }
+
+  virtual bool needs_virtual_hid_pointing(void) const {
+    return std::any_of(std::begin(entries_),
+                       std::end(entries_),
+                       [](const auto& e) {
+                         return e.to->needs_virtual_hid_pointing();
+                       });
+  }
+
+  virtual void handle_device_keys_and_pointing_buttons_are_released_event(const event_queue::entry& front_input_event,
+                                                                          event_queue::queue& output_event_queue) {
+  }
+
+  virtual void handle_device_ungrabbed_event(device_id device_id,
+                                             const event_queue::queue& output_event_queue,
+                                             absolute_time_point time_stamp) {
+    std::erase_if(active_events_,
+                  [&](const auto& e) {
+                    if (e.from_event.get_device_id() == device_id) {
+                      erase_from_from_event_index(e.from_event);
+                      return true;
+                    }
+                    return false;
+                  });
+  }
+
+  virtual void handle_pointing_device_event_from_event_tap(const event_queue::entry& front_input_event,
+                                                           event_queue::queue& output_event_queue) {
+  }
+
+protected:
+  virtual std::vector<basic::manipulated_original_event::from_event> make_manipulated_from_events(void) const {
+    std::vector<basic::manipulated_original_event::from_event> result;
+
+    for (const auto& e : active_events_) {
+      result.push_back(e.from_event);
+    }
+
+    return result;
+  }
+
+private:
+  // Usages which are equal or greater than `max_usage` are not stored in the table.
+  static constexpr size_t max_usage = 0x1000;
+
+  struct entry final {
+    event_definition from;
+    gsl::not_null<std::shared_ptr<to_event_definition>> to;
+    event_queue::event to_event;
+  };
+
+  struct page final {
+    pqrs::hid::usage_page::value_t usage_page;
+    // `indices[usage]` is the index of `entries_` + 1. (0 means the usage is not mapped.)
+    std::vector<size_t> indices;
+  };
+
+  struct active_event final {
+    basic::manipulated_original_event::from_event from_event;
+    event_queue::event to_event;
+  };
+
+  static basic::manipulated_original_event::from_event make_from_event(const event_queue::entry& entry) {
+    return basic::manipulated_original_event::from_event(entry.get_device_id(),
+                                                         entry.get_event(),
+                                                         entry.get_original_event());
+  }
+
+  page& find_or_make_page(pqrs::hid::usage_page::value_t usage_page) {
+    for (auto&& p : pages_) {
+      if (p.usage_page == usage_page) {
+        return p;
+      }
+    }
+
+    pages_.push_back({
+        .usage_page = usage_page,
+        .indices = {},
+    });
+    return pages_.back();
+  }
+
+  const entry* find_entry(const momentary_switch_event& e) const {
+    auto usage_pair = e.get_usage_pair();
+
+    // The number of pages is small (usually 1-3), so a linear search is enough.
+    for (const auto& p : pages_) {
+      if (p.usage_page == usage_pair.get_usage_page()) {
+        auto usage = static_cast<size_t>(type_safe::get(usage_pair.get_usage()));
+        if (usage < p.indices.size() && p.indices[usage] != 0) {
+          return &entries_[p.indices[usage] - 1];
+        }
+        return nullptr;
+      }
+    }
+
+    return nullptr;
+  }
+
+  std::vector<active_event>::iterator find_active_event(const basic::manipulated_original_event::from_event& from_event) {
+    return std::find_if(std::begin(active_events_),
+                        std::end(active_events_),
+                        [&](const auto& e) {
+                          return e.from_event == from_event;
+                        });
+  }
+
+  std::vector<entry> entries_;
+  std::vector<page> pages_;
+  std::vector<active_event> active_events_;
+};
+} // namespace remap_table
+} // namespace manipulators
+} // namespace manipulator
+} // namespace krbn
@@ -0,0 +1,346 @@
+#pragma once
+
+// `krbn::manipulator::pattern_matcher` can be used safely in a multi-threaded environment.
+
+#include <algorithm>
+#include <array>
+#include <gsl/gsl>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace krbn {
+namespace manipulator {
+
+// A matcher which evaluates the regex patterns of all conditions at once.
+//
+// - Patterns are registered once and shared among conditions. (The same pattern gets the same id.)
+//   Patterns are reference counted and removed when the last condition which uses them is destroyed.
+// - Literal patterns (e.g., `^com\.apple\.Terminal$`) are matched without std::regex.
+//   Exact literals are combined into a hash table, so they are resolved by a single lookup.
+// - The match results of all patterns are computed when the subject is changed, and conditions read the cached results.
+class pattern_matcher final {
+public:
+  using pattern_id = size_t;
+
+  enum class subject {
+    bundle_identifier,
+    file_path,
+    language,
+    input_source_id,
+    input_mode_id,
+    end_,
+  };
+
+  pattern_matcher(const pattern_matcher&) = delete;
+
+  pattern_matcher(void) {
+  }
+
+  // Throws std::regex_error if the pattern is invalid.
+  // Each call has to be paired with `unregister_pattern`. (Use `registered_pattern` to do it automatically.)
+  pattern_id register_pattern(const std::string& pattern) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = pattern_ids_.find(pattern);
+    if (it != std::end(pattern_ids_)) {
+      ++(patterns_[it->second].reference_count);
+      return it->second;
+    }
+
+    struct pattern p;
+    p.source = pattern;
+    p.reference_count = 1;
+    if (auto l = make_literal(pattern)) {
+      p.literal = *l;
+    } else {
+      p.regex = std::regex(pattern);
+    }
+
+    // Reuse the slot of an unregistered pattern in order to keep `patterns_` as small as the live patterns.
+    pattern_id id = patterns_.size();
+    if (!free_ids_.empty()) {
+      id = free_ids_.back();
+      free_ids_.pop_back();
+      patterns_[id] = std::move(p);
+    } else {
+      patterns_.push_back(std::move(p));
+    }
+
+    if (patterns_[id].literal &&
+        patterns_[id].literal->type == literal_type::exact) {
+      exact_literals_[patterns_[id].literal->value].push_back(id);
+    }
+
+    pattern_ids_[pattern] = id;
+
+    // Invalidate the results since they do not contain the new pattern.
+    last_subject_ = std::nullopt;
+
+    return id;
+  }
+
+  void unregister_pattern(pattern_id id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (id >= patterns_.size() ||
+        patterns_[id].reference_count == 0) {
+      return;
+    }
+
+    auto& p = patterns_[id];
+    if (--(p.reference_count) > 0) {
+      return;
+    }
+
+    if (p.literal &&
+        p.literal->type == literal_type::exact) {
+      auto it = exact_literals_.find(p.literal->value);
+      if (it != std::end(exact_literals_)) {
+        std::erase(it->second, id);
+        if (it->second.empty()) {
+          exact_literals_.erase(it);
+        }
+      }
+    }
+
+    pattern_ids_.erase(p.source);
+
+    p = pattern();
+    free_ids_.push_back(id);
+  }
+
+  // Returns the same result as `std::regex_search(subject, std::regex(pattern))`.
+  bool matches(pattern_id id, const std::string& subject) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (last_subject_ != subject) {
+      update_results(subject);
+      last_subject_ = subject;
+    }
+
+    if (id < results_.size()) {
+      return results_[id];
+    }
+
+    return false;
+  }
+
+  // Returns the number of registered patterns.
+  size_t size(void) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return patterns_.size() - free_ids_.size();
+  }
+
+  // Returns the number of patterns which are matched without std::regex.
+  size_t literal_size(void) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return std::count_if(std::begin(patterns_),
+                         std::end(patterns_),
+                         [](const auto& p) {
+                           return p.literal != std::nullopt;
+                         });
+  }
+
+private:
+  enum class literal_type {
+    exact,    // ^literal$
+    prefix,   // ^literal
+    suffix,   // literal$
+    contains, // literal
+  };
+
+  struct literal_pattern final {
+    literal_type type;
+    std::string value;
+  };
+
+  // Unregistered slots have `reference_count == 0` and neither `literal` nor `regex`.
+  struct pattern final {
+    std::string source;
+    size_t reference_count = 0;
+    std::optional<literal_pattern> literal;
+    std::optional<std::regex> regex;
+  };
+
+  // Returns std::nullopt if the pattern contains regex features other than anchors and escaped characters.
+  // Only escaped special characters are treated as literals, since std::regex implementations may differ on other escapes. (e.g., `\/`, `\-`)
+  static std::optional<literal_pattern> make_literal(const std::string& pattern) {
+    std::string_view body(pattern);
+
+    bool begin_anchor = false;
+    bool end_anchor = false;
+
+    if (body.starts_with('^')) {
+      begin_anchor = true;
+      body.remove_prefix(1);
+    }
+
+    if (body.ends_with('$') &&
+        !(body.size() >= 2 && body[body.size() - 2] == '\\')) {
+      end_anchor = true;
+      body.remove_suffix(1);
+    }
+
+    std::string value;
+    for (size_t i = 0; i < body.size(); ++i) {
+      auto c = body[i];
+
+      if (c == '\\') {
+        if (i + 1 >= body.size()) {
+          return std::nullopt;
+        }
+
+        // `\d`, `\w`, `\b` etc. are not literals.
+        auto next = body[i + 1];
+        if (!is_special_character(next)) {
+          return std::nullopt;
+        }
+
+        value.push_back(next);
+        ++i;
+        continue;
+      }
+
+      if (is_special_character(c)) {
+        return std::nullopt;
+      }
+
+      value.push_back(c);
+    }
+
+    if (begin_anchor && end_anchor) {
+      return literal_pattern{literal_type::exact, value};
+    } else if (begin_anchor) {
+      return literal_pattern{literal_type::prefix, value};
+    } else if (end_anchor) {
+      return literal_pattern{literal_type::suffix, value};
+    } else {
+      return literal_pattern{literal_type::contains, value};
+    }
+  }
+
+  static bool is_special_character(char c) {
+    switch (c) {
+      case '^':
+      case '$':
+      case '\\':
+      case '.':
+      case '*':
+      case '+':
+      case '?':
+      case '(':
+      case ')':
+      case '[':
+      case ']':
+      case '{':
+      case '}':
+      case '|':
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  void update_results(const std::string& subject) {
+    results_.assign(patterns_.size(), false);
+
+    // Exact literals
+
+    auto it = exact_literals_.find(subject);
+    if (it != std::end(exact_literals_)) {
+      for (const auto& id : it->second) {
+        results_[id] = true;
+      }
+    }
+
+    // Others
+
+    for (pattern_id id = 0; id < patterns_.size(); ++id) {
+      const auto& p = patterns_[id];
+
+      if (p.literal) {
+        switch (p.literal->type) {
+          case literal_type::exact:
+            // Already handled
+            break;
+          case literal_type::prefix:
+            results_[id] = subject.starts_with(p.literal->value);
+            break;
+          case literal_type::suffix:
+            results_[id] = subject.ends_with(p.literal->value);
+            break;
+          case literal_type::contains:
+            results_[id] = (subject.find(p.literal->value) != std::string::npos);
+            break;
+        }
+      } else if (p.regex) {
+        results_[id] = std::regex_search(std::begin(subject),
+                                         std::end(subject),
+                                         *p.regex);
+      }
+    }
+  }
+
+  std::vector<pattern> patterns_;
+  std::vector<pattern_id> free_ids_;
+  std::unordered_map<std::string, pattern_id> pattern_ids_;
+  std::unordered_map<std::string, std::vector<pattern_id>> exact_literals_;
+
+  std::optional<std::string> last_subject_;
+  std::vector<bool> results_;
+
+  mutable std::mutex mutex_;
+};
+
+// A pattern which is registered to `matcher` while this object is alive.
+class registered_pattern final {
+public:
+  // Throws std::regex_error if the pattern is invalid.
+  registered_pattern(gsl::not_null<std::shared_ptr<pattern_matcher>> matcher,
+                     const std::string& pattern) : matcher_(matcher),
+                                                   id_(matcher->register_pattern(pattern)) {
+  }
+
+  registered_pattern(const registered_pattern&) = delete;
+
+  registered_pattern(registered_pattern&& other) : matcher_(std::move(other.matcher_)),
+                                                   id_(other.id_) {
+  }
+
+  ~registered_pattern(void) {
+    if (matcher_) {
+      matcher_->unregister_pattern(id_);
+    }
+  }
+
+  bool matches(const std::string& subject) const {
+    return matcher_->matches(id_, subject);
+  }
+
+private:
+  std::shared_ptr<pattern_matcher> matcher_;
+  pattern_matcher::pattern_id id_;
+};
+
+inline gsl::not_null<std::shared_ptr<pattern_matcher>> get_shared_pattern_matcher(pattern_matcher::subject subject) {
+  static auto matchers = [] {
+    std::array<std::shared_ptr<pattern_matcher>, static_cast<size_t>(pattern_matcher::subject::end_)> result;
+    for (auto& m : result) {
+      m = std::make_shared<pattern_matcher>();
+    }
+    return result;
+  }();
+
+  return matchers[static_cast<size_t>(subject)];
+}
+
+} // namespace manipulator
+} // namespace krbn
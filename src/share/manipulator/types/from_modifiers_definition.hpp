@@ -1,6 +1,7 @@
 #pragma once
 
 #include "modifier_definition.hpp"
+#include <bit>
 #include <pqrs/json.hpp>
 #include <set>
 #include <unordered_set>
@@ -10,6 +11,7 @@ namespace manipulator {
 class from_modifiers_definition final {
 public:
   from_modifiers_definition(void) {
+    update_bitmasks();
   }
 
   virtual ~from_modifiers_definition(void) {
@@ -21,6 +23,7 @@ public:
 
   void set_mandatory_modifiers(const std::set<modifier_definition::modifier>& value) {
     mandatory_modifiers_ = value;
+    update_bitmasks();
   }
 
   const std::set<modifier_definition::modifier>& get_optional_modifiers(void) const {
@@ -29,66 +32,39 @@ public:
 
   void set_optional_modifiers(const std::set<modifier_definition::modifier>& value) {
     optional_modifiers_ = value;
+    update_bitmasks();
   }
 
   std::shared_ptr<std::unordered_set<modifier_flag>> test_modifiers(const modifier_flag_manager& modifier_flag_manager) const {
-    auto modifier_flags = std::make_shared<std::unordered_set<modifier_flag>>();
+    auto pressed_modifier_flags = modifier_flag_manager.get_pressed_modifier_flags() & ~make_modifier_flag_bitmask(modifier_flag::zero);
 
     // If mandatory_modifiers_ contains modifier::any, return all active modifier_flags.
 
-    if (mandatory_modifiers_.find(modifier_definition::modifier::any) != std::end(mandatory_modifiers_)) {
-      for (auto i = static_cast<uint32_t>(modifier_flag::zero) + 1; i != static_cast<uint32_t>(modifier_flag::end_); ++i) {
-        auto flag = modifier_flag(i);
-        if (modifier_flag_manager.is_pressed(flag)) {
-          modifier_flags->insert(flag);
-        }
-      }
-      return modifier_flags;
+    if (mandatory_any_) {
+      return make_modifier_flags(pressed_modifier_flags);
     }
 
     // Check modifier_flag state.
 
-    for (int i = 0; i < static_cast<int>(modifier_definition::modifier::end_); ++i) {
-      auto m = modifier_definition::modifier(i);
+    modifier_flag_bitmask matched_modifier_flags = 0;
 
-      if (mandatory_modifiers_.find(m) != std::end(mandatory_modifiers_)) {
-        auto pair = test_modifier(modifier_flag_manager, m);
-        if (!pair.first) {
-          return nullptr;
-        }
-        if (pair.second != modifier_flag::zero) {
-          modifier_flags->insert(pair.second);
-        }
+    for (const auto& group : mandatory_modifier_flag_groups_) {
+      auto bits = pressed_modifier_flags & group;
+      if (bits == 0) {
+        return nullptr;
       }
+
+      // Take the first flag as test_modifier does. (e.g., left_shift is preferred to right_shift.)
+      matched_modifier_flags |= make_modifier_flag_bitmask(modifier_flag(std::countr_zero(bits)));
     }
 
     // If optional_modifiers_ does not contain modifier::any, we have to check modifier flags strictly.
 
-    if (optional_modifiers_.find(modifier_definition::modifier::any) == std::end(optional_modifiers_)) {
-      std::unordered_set<modifier_flag> extra_modifier_flags;
-      for (auto m = static_cast<uint32_t>(modifier_flag::zero) + 1; m != static_cast<uint32_t>(modifier_flag::end_); ++m) {
-        extra_modifier_flags.insert(modifier_flag(m));
-      }
-
-      for (int i = 0; i < static_cast<int>(modifier_definition::modifier::end_); ++i) {
-        auto m = modifier_definition::modifier(i);
-
-        if (mandatory_modifiers_.find(m) != std::end(mandatory_modifiers_) ||
-            optional_modifiers_.find(m) != std::end(optional_modifiers_)) {
-          for (const auto& flag : modifier_definition::get_modifier_flags(m)) {
-            extra_modifier_flags.erase(flag);
-          }
-        }
-      }
-
-      for (const auto& flag : extra_modifier_flags) {
-        if (modifier_flag_manager.is_pressed(flag)) {
-          return nullptr;
-        }
-      }
+    if (pressed_modifier_flags & extra_modifier_flags_) {
+      return nullptr;
     }
 
-    return modifier_flags;
+    return make_modifier_flags(matched_modifier_flags);
   }
 
   static std::pair<bool, modifier_flag> test_modifier(const modifier_flag_manager& modifier_flag_manager,
@@ -110,8 +86,55 @@ public:
   }
 
 private:
+  static std::shared_ptr<std::unordered_set<modifier_flag>> make_modifier_flags(modifier_flag_bitmask bits) {
+    auto modifier_flags = std::make_shared<std::unordered_set<modifier_flag>>();
+
+    for (; bits != 0; bits &= bits - 1) {
+      modifier_flags->insert(modifier_flag(std::countr_zero(bits)));
+    }
+
+    return modifier_flags;
+  }
+
+  void update_bitmasks(void) {
+    mandatory_any_ = mandatory_modifiers_.contains(modifier_definition::modifier::any);
+
+    mandatory_modifier_flag_groups_.clear();
+    for (const auto& m : mandatory_modifiers_) {
+      if (m == modifier_definition::modifier::any) {
+        continue;
+      }
+
+      modifier_flag_bitmask group = 0;
+      for (const auto& flag : modifier_definition::get_modifier_flags(m)) {
+        group |= make_modifier_flag_bitmask(flag);
+      }
+      mandatory_modifier_flag_groups_.push_back(group);
+    }
+
+    extra_modifier_flags_ = 0;
+    if (!optional_modifiers_.contains(modifier_definition::modifier::any)) {
+      for (auto m = static_cast<uint32_t>(modifier_flag::zero) + 1; m != static_cast<uint32_t>(modifier_flag::end_); ++m) {
+        extra_modifier_flags_ |= make_modifier_flag_bitmask(modifier_flag(m));
+      }
+
+      for (const auto& modifiers : {mandatory_modifiers_, optional_modifiers_}) {
+        for (const auto& m : modifiers) {
+          for (const auto& flag : modifier_definition::get_modifier_flags(m)) {
+            extra_modifier_flags_ &= ~make_modifier_flag_bitmask(flag);
+          }
+        }
+      }
+    }
+  }
+
   std::set<modifier_definition::modifier> mandatory_modifiers_;
   std::set<modifier_definition::modifier> optional_modifiers_;
+
+  // Bitmasks which are made from mandatory_modifiers_ and optional_modifiers_.
+  bool mandatory_any_;
+  std::vector<modifier_flag_bitmask> mandatory_modifier_flag_groups_;
+  modifier_flag_bitmask extra_modifier_flags_;
 };
 
 inline void from_json(const nlohmann::json& json, from_modifiers_definition& value) {
@@ -0,0 +1,151 @@
+#pragma once
+
+// `krbn::manipulator_device_condition_id_table` can be used safely in a multi-threaded environment.
+// `krbn::manipulator_device_condition_results` is not thread-safe.
+
+#include "types/device_id.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace krbn {
+// Assigns a dense id to each device condition (`device_if`, `device_unless`).
+// The id is used as the bit index in `manipulator_device_condition_results`.
+//
+// Ids of destroyed conditions are reused in order to keep the bitmaps small.
+// The epoch is incremented when an id is released, so that results cached for the previous owner of the id are discarded.
+class manipulator_device_condition_id_table final {
+public:
+  using id = size_t;
+
+  manipulator_device_condition_id_table(const manipulator_device_condition_id_table&) = delete;
+
+  manipulator_device_condition_id_table(void) : next_id_(0),
+                                                epoch_(0) {
+  }
+
+  id acquire(void) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!free_ids_.empty()) {
+      auto i = free_ids_.back();
+      free_ids_.pop_back();
+      return i;
+    }
+
+    return next_id_++;
+  }
+
+  void release(id id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    ++epoch_;
+    free_ids_.push_back(id);
+  }
+
+  uint64_t get_epoch(void) const {
+    return epoch_;
+  }
+
+private:
+  std::vector<id> free_ids_;
+  id next_id_;
+  std::atomic<uint64_t> epoch_;
+  std::mutex mutex_;
+};
+
+inline manipulator_device_condition_id_table& get_shared_manipulator_device_condition_id_table(void) {
+  // The initialization of a function-local static variable is thread-safe.
+  static manipulator_device_condition_id_table table;
+
+  return table;
+}
+
+// Per-device bitmaps of device condition results, indexed by the condition id.
+//
+// Cached device conditions depend only on the device properties,
+// so each result is evaluated once per device and then looked up in O(1).
+// The owner (manipulator_environment) erases the device bitmap when the device is grabbed or ungrabbed.
+class manipulator_device_condition_results final {
+public:
+  manipulator_device_condition_results(const manipulator_device_condition_results&) = delete;
+
+  manipulator_device_condition_results(void) : epoch_(0) {
+  }
+
+  std::optional<bool> find(device_id device_id,
+                           manipulator_device_condition_id_table::id condition_id) {
+    validate_epoch();
+
+    auto it = bitmaps_.find(device_id);
+    if (it == std::end(bitmaps_)) {
+      return std::nullopt;
+    }
+
+    auto word = condition_id / 64;
+    auto mask = uint64_t(1) << (condition_id % 64);
+
+    if (word >= it->second.evaluated.size() ||
+        !(it->second.evaluated[word] & mask)) {
+      return std::nullopt;
+    }
+
+    return (it->second.fulfilled[word] & mask) != 0;
+  }
+
+  void set(device_id device_id,
+           manipulator_device_condition_id_table::id condition_id,
+           bool fulfilled) {
+    validate_epoch();
+
+    auto& b = bitmaps_[device_id];
+
+    auto word = condition_id / 64;
+    auto mask = uint64_t(1) << (condition_id % 64);
+
+    if (word >= b.evaluated.size()) {
+      b.evaluated.resize(word + 1, 0);
+      b.fulfilled.resize(word + 1, 0);
+    }
+
+    b.evaluated[word] |= mask;
+    if (fulfilled) {
+      b.fulfilled[word] |= mask;
+    } else {
+      b.fulfilled[word] &= ~mask;
+    }
+  }
+
+  void erase(device_id device_id) {
+    bitmaps_.erase(device_id);
+  }
+
+  void clear(void) {
+    bitmaps_.clear();
+  }
+
+  size_t size(void) const {
+    return bitmaps_.size();
+  }
+
+private:
+  struct bitmap final {
+    std::vector<uint64_t> evaluated;
+    std::vector<uint64_t> fulfilled;
+  };
+
+  void validate_epoch(void) {
+    auto e = get_shared_manipulator_device_condition_id_table().get_epoch();
+    if (epoch_ != e) {
+      epoch_ = e;
+      bitmaps_.clear();
+    }
+  }
+
+  std::unordered_map<device_id, bitmap> bitmaps_;
+  uint64_t epoch_;
+};
+} // namespace krbn
@@ -0,0 +1,91 @@
+#pragma once
+
+// `krbn::manipulator_environment_variable_name_table` can be used safely in a multi-threaded environment.
+
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace krbn {
+// Interns variable names into integer slots.
+// Names are interned when the configuration is loaded, and the hot path (conditions::variable, set_variable events)
+// accesses the values by the slot without hashing the name.
+//
+// A slot is never released; the same name always gets the same slot in the process.
+// Since names also arrive from clients (e.g., `set_variables` operation), the number of names is limited by `max_size`
+// in order to keep the table (and variables in manipulator_environment) from growing without bound.
+class manipulator_environment_variable_name_table final {
+public:
+  using slot = size_t;
+
+  manipulator_environment_variable_name_table(const manipulator_environment_variable_name_table&) = delete;
+
+  manipulator_environment_variable_name_table(size_t max_size = 16384) : max_size_(max_size) {
+  }
+
+  // Returns std::nullopt if `name` is not interned yet and the table is full.
+  std::optional<slot> intern(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = slots_.find(name);
+    if (it != std::end(slots_)) {
+      return it->second;
+    }
+
+    if (names_.size() >= max_size_) {
+      return std::nullopt;
+    }
+
+    auto s = names_.size();
+    names_.push_back(name);
+    slots_[name] = s;
+    return s;
+  }
+
+  std::optional<slot> find(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = slots_.find(name);
+    if (it != std::end(slots_)) {
+      return it->second;
+    }
+
+    return std::nullopt;
+  }
+
+  std::string get_name(slot slot) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (slot < names_.size()) {
+      return names_[slot];
+    }
+
+    return "";
+  }
+
+  size_t size(void) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return names_.size();
+  }
+
+  size_t get_max_size(void) const {
+    return max_size_;
+  }
+
+private:
+  const size_t max_size_;
+  std::deque<std::string> names_;
+  std::unordered_map<std::string, slot> slots_;
+  mutable std::mutex mutex_;
+};
+
+inline manipulator_environment_variable_name_table& get_shared_manipulator_environment_variable_name_table(void) {
+  // The initialization of a function-local static variable is thread-safe.
+  static manipulator_environment_variable_name_table table;
+
+  return table;
+}
+} // namespace krbn
@@ -1,8 +1,12 @@
 #pragma once
 
 #include "types.hpp"
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <thread>
+#include <tuple>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -14,168 +18,169 @@ public:
 
   modifier_flag_manager(const modifier_flag_manager&) = delete;
 
-  modifier_flag_manager(void) {
+  modifier_flag_manager(void)
+      : active_modifier_flags_size_(0),
+        pressed_modifier_flags_(0) {
   }
 
   void push_back_active_modifier_flag(const active_modifier_flag& flag) {
+    auto device_id = flag.get_device_id();
+    auto modifier_flag = flag.get_modifier_flag();
+    auto c = get_counters(device_id, modifier_flag);
+
     switch (flag.get_type()) {
       case active_modifier_flag::type::increase:
       case active_modifier_flag::type::decrease:
+        c.increase += flag.get_count();
+        break;
+
       case active_modifier_flag::type::increase_sticky:
       case active_modifier_flag::type::decrease_sticky:
-        active_modifier_flags_.push_back(flag);
-        erase_pairs();
+        c.sticky += flag.get_count();
         break;
 
       case active_modifier_flag::type::increase_lock:
+        // Same type entries are not accumulated. (increase_lock + increase_lock == increase_lock)
+        c.lock = std::min(c.lock + 1, 1);
+        break;
+
       case active_modifier_flag::type::decrease_lock:
+        c.lock = std::max(c.lock - 1, -1);
+        break;
+
       case active_modifier_flag::type::increase_led_lock:
-        // Remove same type entries.
-        active_modifier_flags_.erase(std::remove_if(std::begin(active_modifier_flags_),
-                                                    std::end(active_modifier_flags_),
-                                                    [&](auto& f) {
-                                                      return f == flag;
-                                                    }),
-                                     std::end(active_modifier_flags_));
-
-        active_modifier_flags_.push_back(flag);
-        erase_pairs();
+        c.led_lock = 1;
         break;
 
       case active_modifier_flag::type::decrease_led_lock:
-        // Remove all type::increase_led_lock.
-        active_modifier_flags_.erase(std::remove_if(std::begin(active_modifier_flags_),
-                                                    std::end(active_modifier_flags_),
-                                                    [&](auto& f) {
-                                                      return f.is_paired(flag);
-                                                    }),
-                                     std::end(active_modifier_flags_));
+        // Remove type::increase_led_lock.
+        c.led_lock = 0;
         break;
     }
+
+    set_counters(device_id, modifier_flag, c);
   }
 
   void erase_all_active_modifier_flags(device_id device_id) {
-    active_modifier_flags_.erase(std::remove_if(std::begin(active_modifier_flags_),
-                                                std::end(active_modifier_flags_),
-                                                [&](const active_modifier_flag& f) {
-                                                  return f.get_device_id() == device_id;
-                                                }),
-                                 std::end(active_modifier_flags_));
+    auto it = device_counters_.find(device_id);
+    if (it != std::end(device_counters_)) {
+      for (size_t i = 0; i < flag_count; ++i) {
+        set_counters(device_id, modifier_flag(i), counters{});
+      }
+      device_counters_.erase(device_id);
+    }
   }
 
   void erase_all_active_modifier_flags_except_lock_and_sticky(device_id device_id) {
-    active_modifier_flags_.erase(std::remove_if(std::begin(active_modifier_flags_),
-                                                std::end(active_modifier_flags_),
-                                                [&](const active_modifier_flag& f) {
-                                                  return f.get_device_id() == device_id && !f.any_lock() && !f.sticky();
-                                                }),
-                                 std::end(active_modifier_flags_));
+    auto it = device_counters_.find(device_id);
+    if (it != std::end(device_counters_)) {
+      for (size_t i = 0; i < flag_count; ++i) {
+        auto c = it->second[i];
+        c.increase = 0;
+        set_counters(device_id, modifier_flag(i), c);
+      }
+    }
   }
 
   void erase_caps_lock_sticky_modifier_flags(void) {
-    active_modifier_flags_.erase(std::remove_if(std::begin(active_modifier_flags_),
-                                                std::end(active_modifier_flags_),
-                                                [&](const active_modifier_flag& f) {
-                                                  return f.get_modifier_flag() == modifier_flag::caps_lock && f.sticky();
-                                                }),
-                                 std::end(active_modifier_flags_));
+    for (const auto& [device_id, array] : device_counters_) {
+      auto c = array[static_cast<size_t>(modifier_flag::caps_lock)];
+      c.sticky = 0;
+      set_counters(device_id, modifier_flag::caps_lock, c);
+    }
   }
 
   void erase_all_sticky_modifier_flags(void) {
-    active_modifier_flags_.erase(std::remove_if(std::begin(active_modifier_flags_),
-                                                std::end(active_modifier_flags_),
-                                                [&](const active_modifier_flag& f) {
-                                                  return f.sticky();
-                                                }),
-                                 std::end(active_modifier_flags_));
+    for (const auto& [device_id, array] : device_counters_) {
+      for (size_t i = 0; i < flag_count; ++i) {
+        auto c = array[i];
+        c.sticky = 0;
+        set_counters(device_id, modifier_flag(i), c);
+      }
+    }
   }
 
   void reset(void) {
-    active_modifier_flags_.clear();
+    device_counters_.clear();
+    flag_states_.fill(flag_state{});
+    active_modifier_flags_size_ = 0;
+    pressed_modifier_flags_ = 0;
   }
 
   bool is_pressed(modifier_flag modifier_flag) const {
-    int count = 0;
-    size_t size = 0;
-
-    int led_count = 0;
-
-    for (const auto& f : active_modifier_flags_) {
-      if (f.get_modifier_flag() == modifier_flag) {
-        if (f.led_lock()) {
-          led_count += f.get_count();
-        } else {
-          count += f.get_count();
-          ++size;
+    return (pressed_modifier_flags_ & make_modifier_flag_bitmask(modifier_flag)) != 0;
+  }
+
+  modifier_flag_bitmask get_pressed_modifier_flags(void) const {
+    return pressed_modifier_flags_;
+  }
+
+  // Returns active flags ordered by device_id, modifier_flag and type.
+  // Paired flags (e.g., increase and decrease) are not included since they are canceled each other.
+  std::vector<active_modifier_flag> get_active_modifier_flags(void) const {
+    std::vector<active_modifier_flag> result;
+
+    std::vector<device_id> device_ids;
+    for (const auto& [device_id, array] : device_counters_) {
+      device_ids.push_back(device_id);
+    }
+    std::sort(std::begin(device_ids), std::end(device_ids));
+
+    for (const auto& device_id : device_ids) {
+      const auto& array = device_counters_.at(device_id);
+      for (size_t i = 0; i < flag_count; ++i) {
+        const auto& c = array[i];
+        for (const auto& [count, increase_type, decrease_type] : {
+                 std::make_tuple(c.increase, active_modifier_flag::type::increase, active_modifier_flag::type::decrease),
+                 std::make_tuple(c.lock, active_modifier_flag::type::increase_lock, active_modifier_flag::type::decrease_lock),
+                 std::make_tuple(c.led_lock, active_modifier_flag::type::increase_led_lock, active_modifier_flag::type::decrease_led_lock),
+                 std::make_tuple(c.sticky, active_modifier_flag::type::increase_sticky, active_modifier_flag::type::decrease_sticky),
+             }) {
+          for (int n = 0; n < std::abs(count); ++n) {
+            result.push_back(active_modifier_flag(count > 0 ? increase_type : decrease_type,
+                                                  modifier_flag(i),
+                                                  device_id));
+          }
         }
       }
     }
 
-    if (size == 0) {
-      // Use led lock if other flags do not exist.
-      return led_count > 0;
-    } else {
-      // Ignore led lock if other flags exist.
-      return count > 0;
-    }
-  }
-
-  const std::vector<active_modifier_flag>& get_active_modifier_flags(void) const {
-    return active_modifier_flags_;
+    return result;
   }
 
   size_t active_modifier_flags_size(void) const {
-    return active_modifier_flags_.size();
+    return active_modifier_flags_size_;
   }
 
   size_t led_lock_size(modifier_flag modifier_flag) const {
-    return std::count_if(std::begin(active_modifier_flags_),
-                         std::end(active_modifier_flags_),
-                         [&](const active_modifier_flag& f) {
-                           return f.get_modifier_flag() == modifier_flag && f.led_lock();
-                         });
+    return flag_states_[static_cast<size_t>(modifier_flag)].led_lock_size;
   }
 
   size_t sticky_size(modifier_flag modifier_flag) const {
-    return std::count_if(std::begin(active_modifier_flags_),
-                         std::end(active_modifier_flags_),
-                         [&](const active_modifier_flag& f) {
-                           return f.get_modifier_flag() == modifier_flag && f.sticky();
-                         });
+    return flag_states_[static_cast<size_t>(modifier_flag)].sticky_size;
   }
 
   bool is_sticky_active(modifier_flag modifier_flag) const {
-    auto count = std::accumulate(std::begin(active_modifier_flags_),
-                                 std::end(active_modifier_flags_),
-                                 0,
-                                 [&](const auto& count, const auto& f) {
-                                   if (f.get_modifier_flag() == modifier_flag && f.sticky()) {
-                                     return count + f.get_count();
-                                   }
-                                   return count;
-                                 });
-    return count > 0;
+    return flag_states_[static_cast<size_t>(modifier_flag)].sticky_count > 0;
   }
 
   pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::modifiers make_hid_report_modifiers(void) const {
     pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::modifiers modifiers;
 
-    std::array<modifier_flag, 8> modifier_flags{
-        modifier_flag::left_control,
-        modifier_flag::left_shift,
-        modifier_flag::left_option,
-        modifier_flag::left_command,
-        modifier_flag::right_control,
-        modifier_flag::right_shift,
-        modifier_flag::right_option,
-        modifier_flag::right_command,
-    };
-    for (const auto& m : modifier_flags) {
-      if (is_pressed(m)) {
-        if (auto r = make_hid_report_modifier(m)) {
-          modifiers.insert(*r);
+    static const auto hid_report_modifier_flags = [] {
+      modifier_flag_bitmask mask = 0;
+      for (size_t i = 0; i < flag_count; ++i) {
+        if (make_hid_report_modifier(modifier_flag(i))) {
+          mask |= make_modifier_flag_bitmask(modifier_flag(i));
         }
       }
+      return mask;
+    }();
+
+    for (auto bits = pressed_modifier_flags_ & hid_report_modifier_flags; bits != 0; bits &= bits - 1) {
+      if (auto r = make_hid_report_modifier(modifier_flag(std::countr_zero(bits)))) {
+        modifiers.insert(*r);
+      }
     }
 
     return modifiers;
@@ -184,43 +189,94 @@ public:
   std::unordered_set<modifier_flag> make_modifier_flags(void) const {
     std::unordered_set<modifier_flag> modifier_flags;
 
-    for (const auto& m : {
-             modifier_flag::caps_lock,
-             modifier_flag::left_control,
-             modifier_flag::left_shift,
-             modifier_flag::left_option,
-             modifier_flag::left_command,
-             modifier_flag::right_control,
-             modifier_flag::right_shift,
-             modifier_flag::right_option,
-             modifier_flag::right_command,
-             modifier_flag::fn,
-         }) {
-      if (is_pressed(m)) {
-        modifier_flags.insert(m);
-      }
+    for (auto bits = pressed_modifier_flags_; bits != 0; bits &= bits - 1) {
+      modifier_flags.insert(modifier_flag(std::countr_zero(bits)));
     }
 
     return modifier_flags;
   }
 
 private:
-  void erase_pairs(void) {
-    for (size_t i1 = 0; i1 < active_modifier_flags_.size(); ++i1) {
-      for (size_t i2 = i1 + 1; i2 < active_modifier_flags_.size(); ++i2) {
-        if (active_modifier_flags_[i1].is_paired(active_modifier_flags_[i2])) {
-          active_modifier_flags_.erase(std::begin(active_modifier_flags_) + i2);
-          active_modifier_flags_.erase(std::begin(active_modifier_flags_) + i1);
-          if (i1 > 0) {
-            --i1;
-          }
-          break;
-        }
-      }
+  static constexpr size_t flag_count = static_cast<size_t>(modifier_flag::end_);
+
+  // The sum of active_modifier_flag::get_count() per (device_id, modifier_flag, type).
+  // Since paired flags are canceled, all entries which have the same key have the same sign.
+  // So the absolute value is the number of entries.
+  struct counters final {
+    int increase = 0;
+    int lock = 0;     // -1, 0 or 1
+    int led_lock = 0; // 0 or 1 (led_lock is always stored in device_id(0))
+    int sticky = 0;
+
+    size_t size(void) const {
+      return std::abs(increase) + std::abs(lock) + std::abs(led_lock) + std::abs(sticky);
+    }
+  };
+
+  // The aggregated values of all devices per modifier_flag.
+  struct flag_state final {
+    int count = 0;   // The sum of counts except led_lock.
+    size_t size = 0; // The number of entries except led_lock.
+    int led_lock_count = 0;
+    size_t led_lock_size = 0;
+    int sticky_count = 0;
+    size_t sticky_size = 0;
+  };
+
+  counters get_counters(device_id device_id, modifier_flag modifier_flag) const {
+    auto it = device_counters_.find(device_id);
+    if (it != std::end(device_counters_)) {
+      return it->second[static_cast<size_t>(modifier_flag)];
+    }
+    return counters{};
+  }
+
+  void set_counters(device_id device_id, modifier_flag modifier_flag, const counters& value) {
+    auto index = static_cast<size_t>(modifier_flag);
+    if (index >= flag_count) {
+      return;
+    }
+
+    auto& c = device_counters_[device_id][index];
+    auto& s = flag_states_[index];
+
+    s.count += (value.increase + value.lock + value.sticky) - (c.increase + c.lock + c.sticky);
+    s.size += std::abs(value.increase) + std::abs(value.lock) + std::abs(value.sticky);
+    s.size -= std::abs(c.increase) + std::abs(c.lock) + std::abs(c.sticky);
+    s.led_lock_count += value.led_lock - c.led_lock;
+    s.led_lock_size += std::abs(value.led_lock);
+    s.led_lock_size -= std::abs(c.led_lock);
+    s.sticky_count += value.sticky - c.sticky;
+    s.sticky_size += std::abs(value.sticky);
+    s.sticky_size -= std::abs(c.sticky);
+
+    active_modifier_flags_size_ += value.size();
+    active_modifier_flags_size_ -= c.size();
+
+    c = value;
+
+    // Update pressed_modifier_flags_.
+
+    bool pressed = false;
+    if (s.size == 0) {
+      // Use led lock if other flags do not exist.
+      pressed = s.led_lock_count > 0;
+    } else {
+      // Ignore led lock if other flags exist.
+      pressed = s.count > 0;
+    }
+
+    if (pressed) {
+      pressed_modifier_flags_ |= make_modifier_flag_bitmask(modifier_flag);
+    } else {
+      pressed_modifier_flags_ &= ~make_modifier_flag_bitmask(modifier_flag);
     }
   }
 
-  std::vector<active_modifier_flag> active_modifier_flags_;
+  std::unordered_map<device_id, std::array<counters, flag_count>> device_counters_;
+  std::array<flag_state, flag_count> flag_states_;
+  size_t active_modifier_flags_size_;
+  modifier_flag_bitmask pressed_modifier_flags_;
 };
 
 inline std::ostream& operator<<(std::ostream& stream, const modifier_flag_manager::active_modifier_flag& value) {
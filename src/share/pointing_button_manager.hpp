@@ -1,8 +1,12 @@
 #pragma once
 
 #include "types.hpp"
+#include "usage_pair_bitset.hpp"
+#include <algorithm>
+#include <bit>
 #include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
 #include <thread>
+#include <utility>
 #include <vector>
 
 namespace krbn {
@@ -66,34 +70,54 @@ public:
   };
 
   void push_back_active_pointing_button(const active_pointing_button& button) {
-    if (button.get_usage_pair().get_usage() == pqrs::hid::usage::undefined) {
+    const auto& usage_pair = button.get_usage_pair();
+
+    if (usage_pair.get_usage() == pqrs::hid::usage::undefined) {
       return;
     }
 
     switch (button.get_type()) {
       case active_pointing_button::type::increase:
-        active_pointing_buttons_.push_back(button);
+        find_or_create_device_buttons(button.get_device_id()).insert(usage_pair);
+        pressed_buttons_.insert(usage_pair);
         break;
 
       case active_pointing_button::type::decrease:
         // Erase all paired entries to avoid button lock when same type::increase button pushed twice.
-        active_pointing_buttons_.erase(std::remove_if(std::begin(active_pointing_buttons_),
-                                                      std::end(active_pointing_buttons_),
-                                                      [&](auto& b) {
-                                                        return b.is_paired(button);
-                                                      }),
-                                       std::end(active_pointing_buttons_));
+        // (The paired entries of all devices are erased since active_pointing_button::is_paired ignores device_id.)
+        for (auto& [device_id, buttons] : device_buttons_) {
+          buttons.erase(usage_pair);
+        }
+        pressed_buttons_.erase(usage_pair);
         break;
     }
   }
 
   void erase_all_active_pointing_buttons(device_id device_id) {
-    active_pointing_buttons_.erase(std::remove_if(std::begin(active_pointing_buttons_),
-                                                  std::end(active_pointing_buttons_),
-                                                  [&](const active_pointing_button& b) {
-                                                    return b.get_device_id() == device_id;
-                                                  }),
-                                   std::end(active_pointing_buttons_));
+    auto it = std::find_if(std::begin(device_buttons_),
+                           std::end(device_buttons_),
+                           [&](const auto& pair) {
+                             return pair.first == device_id;
+                           });
+    if (it == std::end(device_buttons_) ||
+        it->second.empty()) {
+      return;
+    }
+
+    // Release buttons which are not pressed in other devices.
+    it->second.for_each([&](const auto& usage_pair) {
+      auto pressed = std::any_of(std::begin(device_buttons_),
+                                 std::end(device_buttons_),
+                                 [&](const auto& pair) {
+                                   return pair.first != device_id && pair.second.contains(usage_pair);
+                                 });
+      if (!pressed) {
+        pressed_buttons_.erase(usage_pair);
+      }
+    });
+
+    // Keep the entry in order to avoid reallocation when the device sends events again.
+    it->second.clear();
   }
 
   void erase_all_active_pointing_buttons_except_lock(device_id device_id) {
@@ -101,39 +125,41 @@ public:
   }
 
   void reset(void) {
-    active_pointing_buttons_.clear();
+    device_buttons_.clear();
+    pressed_buttons_.clear();
   }
 
   bool is_pressed(const pqrs::hid::usage_pair& usage_pair) const {
-    int count = 0;
-
-    for (const auto& f : active_pointing_buttons_) {
-      if (f.get_usage_pair() == usage_pair) {
-        count += f.get_count();
-      }
-    }
-
-    return count > 0;
+    return pressed_buttons_.contains(usage_pair);
   }
 
   pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::buttons make_hid_report_buttons(void) const {
     pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::buttons buttons;
 
-    pqrs::hid::usage_pair usage_pair(pqrs::hid::usage_page::button,
-                                     pqrs::hid::usage::button::button_1);
-    while (usage_pair.get_usage() <= pqrs::hid::usage::button::button_32) {
-      if (is_pressed(usage_pair)) {
-        buttons.insert(type_safe::get(usage_pair.get_usage()));
-      }
-
-      usage_pair.set_usage(
-          pqrs::hid::usage::value_t(type_safe::get(usage_pair.get_usage()) + 1));
+    // button_1 ... button_32
+    auto bits = pressed_buttons_.get_bits(pqrs::hid::usage_page::button, 0) & 0x1fffffffe;
+    for (; bits != 0; bits &= bits - 1) {
+      buttons.insert(std::countr_zero(bits));
     }
 
     return buttons;
   }
 
 private:
-  std::vector<active_pointing_button> active_pointing_buttons_;
+  usage_pair_bitset& find_or_create_device_buttons(device_id device_id) {
+    for (auto& [id, buttons] : device_buttons_) {
+      if (id == device_id) {
+        return buttons;
+      }
+    }
+
+    device_buttons_.emplace_back(device_id, usage_pair_bitset());
+    return device_buttons_.back().second;
+  }
+
+  // Pressed buttons per device. (The number of devices is small, so a vector is used instead of a map.)
+  std::vector<std::pair<device_id, usage_pair_bitset>> device_buttons_;
+  // The union of device_buttons_.
+  usage_pair_bitset pressed_buttons_;
 };
 } // namespace krbn
@@ -1,33 +1,27 @@
 #pragma once
 
-// `krbn::pressed_keys_manager` can be used safely in a multi-threaded environment.
+// `krbn::pressed_keys_manager` is not thread-safe.
+// (It is updated only in the hid queue callback of `device_grabber_details::entry`, which is called in the dispatcher thread.)
 
 #include "types.hpp"
-#include <unordered_set>
+#include "usage_pair_bitset.hpp"
 
 namespace krbn {
 class pressed_keys_manager {
 public:
   void insert(const momentary_switch_event& value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    entries_.insert(value);
+    entries_.insert(value.get_usage_pair());
   }
 
   void erase(const momentary_switch_event& value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    entries_.erase(value);
+    entries_.erase(value.get_usage_pair());
   }
 
   bool empty(void) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     return entries_.empty();
   }
 
 private:
-  std::unordered_set<momentary_switch_event> entries_;
-  mutable std::mutex mutex_;
+  usage_pair_bitset entries_;
 };
 } // namespace krbn
@@ -0,0 +1,256 @@
+#pragma once
+
+// `krbn::ring_buffer` is not thread-safe.
+
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <vector>
+
+namespace krbn {
+// A growable ring buffer which provides O(1) push_back and pop_front.
+// The elements are accessible in insertion order by random access iterators.
+template <typename T>
+class ring_buffer final {
+public:
+  template <typename buffer_type, typename element_type>
+  class basic_iterator final {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::remove_const_t<element_type>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = element_type*;
+    using reference = element_type&;
+
+    basic_iterator(void) : buffer_(nullptr),
+                           index_(0) {
+    }
+
+    basic_iterator(buffer_type* buffer, size_t index) : buffer_(buffer),
+                                                        index_(index) {
+    }
+
+    reference operator*(void) const {
+      return (*buffer_)[index_];
+    }
+
+    pointer operator->(void) const {
+      return &((*buffer_)[index_]);
+    }
+
+    reference operator[](difference_type n) const {
+      return (*buffer_)[index_ + n];
+    }
+
+    basic_iterator& operator++(void) {
+      ++index_;
+      return *this;
+    }
+
+    basic_iterator operator++(int) {
+      auto result = *this;
+      ++index_;
+      return result;
+    }
+
+    basic_iterator& operator--(void) {
+      --index_;
+      return *this;
+    }
+
+    basic_iterator operator--(int) {
+      auto result = *this;
+      --index_;
+      return result;
+    }
+
+    basic_iterator& operator+=(difference_type n) {
+      index_ += n;
+      return *this;
+    }
+
+    basic_iterator& operator-=(difference_type n) {
+      index_ -= n;
+      return *this;
+    }
+
+    basic_iterator operator+(difference_type n) const {
+      return basic_iterator(buffer_, index_ + n);
+    }
+
+    friend basic_iterator operator+(difference_type n, const basic_iterator& it) {
+      return it + n;
+    }
+
+    basic_iterator operator-(difference_type n) const {
+      return basic_iterator(buffer_, index_ - n);
+    }
+
+    difference_type operator-(const basic_iterator& other) const {
+      return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+    }
+
+    bool operator==(const basic_iterator& other) const {
+      return buffer_ == other.buffer_ && index_ == other.index_;
+    }
+
+    auto operator<=>(const basic_iterator& other) const {
+      return index_ <=> other.index_;
+    }
+
+  private:
+    buffer_type* buffer_;
+    size_t index_;
+  };
+
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using iterator = basic_iterator<ring_buffer, T>;
+  using const_iterator = basic_iterator<const ring_buffer, const T>;
+
+  ring_buffer(void) : head_(0),
+                      size_(0) {
+  }
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    if (size_ == slots_.size()) {
+      grow();
+    }
+
+    auto& slot = slots_[physical_index(size_)];
+    slot.emplace(std::forward<Args>(args)...);
+    ++size_;
+
+    return *slot;
+  }
+
+  void push_back(const T& value) {
+    emplace_back(value);
+  }
+
+  void push_back(T&& value) {
+    emplace_back(std::move(value));
+  }
+
+  void pop_front(void) {
+    if (size_ == 0) {
+      return;
+    }
+
+    slots_[head_].reset();
+    head_ = (head_ + 1) & (slots_.size() - 1);
+    --size_;
+
+    if (size_ == 0) {
+      head_ = 0;
+    }
+  }
+
+  void pop_back(void) {
+    if (size_ == 0) {
+      return;
+    }
+
+    slots_[physical_index(size_ - 1)].reset();
+    --size_;
+
+    if (size_ == 0) {
+      head_ = 0;
+    }
+  }
+
+  void clear(void) {
+    for (size_t i = 0; i < size_; ++i) {
+      slots_[physical_index(i)].reset();
+    }
+
+    head_ = 0;
+    size_ = 0;
+  }
+
+  bool empty(void) const {
+    return size_ == 0;
+  }
+
+  size_t size(void) const {
+    return size_;
+  }
+
+  size_t capacity(void) const {
+    return slots_.size();
+  }
+
+  const T& operator[](size_t index) const {
+    return *(slots_[physical_index(index)]);
+  }
+
+  T& operator[](size_t index) {
+    return const_cast<T&>(static_cast<const ring_buffer&>(*this)[index]);
+  }
+
+  const T& front(void) const {
+    return (*this)[0];
+  }
+
+  T& front(void) {
+    return (*this)[0];
+  }
+
+  const T& back(void) const {
+    return (*this)[size_ - 1];
+  }
+
+  T& back(void) {
+    return (*this)[size_ - 1];
+  }
+
+  iterator begin(void) {
+    return iterator(this, 0);
+  }
+
+  iterator end(void) {
+    return iterator(this, size_);
+  }
+
+  const_iterator begin(void) const {
+    return const_iterator(this, 0);
+  }
+
+  const_iterator end(void) const {
+    return const_iterator(this, size_);
+  }
+
+  bool operator==(const ring_buffer& other) const {
+    return std::equal(begin(), end(), other.begin(), other.end());
+  }
+
+  bool operator==(const std::vector<T>& other) const {
+    return std::equal(begin(), end(), std::begin(other), std::end(other));
+  }
+
+private:
+  // The capacity is always a power of two.
+  size_t physical_index(size_t index) const {
+    return (head_ + index) & (slots_.size() - 1);
+  }
+
+  void grow(void) {
+    std::vector<std::optional<T>> slots(std::max(slots_.size() * 2, static_cast<size_t>(16)));
+
+    for (size_t i = 0; i < size_; ++i) {
+      slots[i] = std::move(slots_[physical_index(i)]);
+    }
+
+    slots_ = std::move(slots);
+    head_ = 0;
+  }
+
+  std::vector<std::optional<T>> slots_;
+  size_t head_;
+  size_t size_;
+};
+} // namespace krbn
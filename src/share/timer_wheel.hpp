@@ -0,0 +1,827 @@
+#pragma once
+
+// `krbn::timer_wheel` can be used safely in a multi-threaded environment.
+// `krbn::timer_wheel_timer` can be used safely in a multi-threaded environment.
+// `krbn::timer_wheel_one_shot_timer` is not thread-safe.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <pqrs/dispatcher.hpp>
+#include <vector>
+
+namespace krbn {
+// A hierarchical timer wheel which holds the deadlines of time-based manipulators
+// (to_if_held_down, to_delayed_action, mouse keys, mouse_motion_to_scroll, game pad sticks).
+//
+// - Timers are armed and canceled in O(1).
+// - Only one task is enqueued to the dispatcher for the nearest deadline, and timers which share the deadline are fired in the task.
+// - No task is enqueued while no timer is armed.
+// - The current time is taken from the time source of the dispatcher,
+//   so the wheel follows `pqrs::dispatcher::pseudo_time_source` in tests.
+//
+// The tick is 1 millisecond (the resolution of `pqrs::dispatcher::time_point`).
+// The wheel has 4 levels of 64 slots (about 4.6 hours), and more distant deadlines are kept in the overflow list.
+class timer_wheel final : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  // 0 is never used as a timer id.
+  using timer_id = uint64_t;
+
+  timer_wheel(const timer_wheel&) = delete;
+
+  timer_wheel(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher = pqrs::dispatcher::extra::get_shared_dispatcher())
+      : dispatcher_client(weak_dispatcher),
+        current_tick_(0),
+        size_(0),
+        last_sequence_(0),
+        free_node_(npos),
+        running_timer_id_(0),
+        wakeup_count_(0) {
+    masks_.fill(0);
+  }
+
+  virtual ~timer_wheel(void) {
+    detach_from_dispatcher();
+  }
+
+  // `function` is called in the dispatcher thread.
+  timer_id arm(pqrs::dispatcher::time_point when,
+               std::function<void(void)> function) {
+    timer_id id = 0;
+    std::optional<pqrs::dispatcher::time_point> task_when;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      sync_current_tick(make_tick(when_now()));
+
+      auto index = allocate_node();
+      auto& n = nodes_[index];
+      n.tick = make_tick(when);
+      n.sequence = ++last_sequence_;
+      n.function = std::move(function);
+      place(index);
+
+      ++size_;
+
+      id = make_timer_id(index, n.generation);
+      task_when = update_task_when(std::nullopt);
+    }
+
+    enqueue_task(task_when);
+
+    return id;
+  }
+
+  // If the function of the timer is running in another thread, `cancel` waits until the function is finished.
+  void cancel(timer_id id) {
+    if (id == 0) {
+      return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    auto index = static_cast<uint32_t>(id & 0xffffffff);
+    auto generation = static_cast<uint32_t>(id >> 32);
+    if (index < nodes_.size() &&
+        nodes_[index].generation == generation &&
+        nodes_[index].location != node_location::free) {
+      if (nodes_[index].location != node_location::firing) {
+        unlink(index);
+      }
+      release_node(index);
+    }
+
+    if (running_timer_id_ == id && !dispatcher_thread()) {
+      running_timer_id_cv_.wait(lock, [this, id] {
+        return running_timer_id_ != id;
+      });
+    }
+  }
+
+  // The number of armed timers.
+  size_t size(void) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return size_;
+  }
+
+  std::optional<pqrs::dispatcher::time_point> get_next_deadline(void) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (auto t = next_deadline_tick()) {
+      return make_time_point(*t);
+    }
+    return std::nullopt;
+  }
+
+  // The number of tasks which are executed in the dispatcher.
+  size_t get_wakeup_count(void) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return wakeup_count_;
+  }
+
+private:
+  static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+  static constexpr size_t levels = 4;
+  static constexpr int slot_bits = 6;
+  static constexpr size_t slot_count = size_t(1) << slot_bits;
+  static constexpr int64_t slot_mask = slot_count - 1;
+  static constexpr int overflow_shift = slot_bits * (levels - 1);
+
+  enum class node_location : uint8_t {
+    free,
+    slot,
+    overflow,
+    expired,
+    firing,
+  };
+
+  struct node final {
+    int64_t tick = 0;
+    uint64_t sequence = 0;
+    std::function<void(void)> function;
+    uint32_t generation = 1;
+    uint32_t prev = npos;
+    uint32_t next = npos;
+    node_location location = node_location::free;
+    uint8_t level = 0;
+    uint8_t slot = 0;
+  };
+
+  struct list final {
+    uint32_t head = npos;
+    uint32_t tail = npos;
+
+    bool empty(void) const {
+      return head == npos;
+    }
+  };
+
+  static int64_t make_tick(pqrs::dispatcher::time_point time_point) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time_point.time_since_epoch()).count();
+  }
+
+  static pqrs::dispatcher::time_point make_time_point(int64_t tick) {
+    return pqrs::dispatcher::time_point(std::chrono::milliseconds(tick));
+  }
+
+  static timer_id make_timer_id(uint32_t index, uint32_t generation) {
+    return (static_cast<uint64_t>(generation) << 32) | index;
+  }
+
+  //
+  // Nodes and lists
+  //
+
+  uint32_t allocate_node(void) {
+    if (free_node_ != npos) {
+      auto index = free_node_;
+      free_node_ = nodes_[index].next;
+      return index;
+    }
+
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+  }
+
+  void release_node(uint32_t index) {
+    auto& n = nodes_[index];
+    n.function = nullptr;
+    n.location = node_location::free;
+    n.prev = npos;
+    n.next = free_node_;
+    if (++n.generation == 0) {
+      n.generation = 1;
+    }
+    free_node_ = index;
+
+    --size_;
+  }
+
+  list& get_list(const node& n) {
+    switch (n.location) {
+      case node_location::slot:
+        return slots_[n.level][n.slot];
+      case node_location::overflow:
+        return overflow_;
+      case node_location::expired:
+      case node_location::free:
+      case node_location::firing:
+        break;
+    }
+    return expired_;
+  }
+
+  void push_back(list& l, uint32_t index) {
+    auto& n = nodes_[index];
+    n.prev = l.tail;
+    n.next = npos;
+    if (l.tail != npos) {
+      nodes_[l.tail].next = index;
+    } else {
+      l.head = index;
+    }
+    l.tail = index;
+  }
+
+  void unlink(uint32_t index) {
+    auto& n = nodes_[index];
+    auto& l = get_list(n);
+
+    if (n.prev != npos) {
+      nodes_[n.prev].next = n.next;
+    } else {
+      l.head = n.next;
+    }
+    if (n.next != npos) {
+      nodes_[n.next].prev = n.prev;
+    } else {
+      l.tail = n.prev;
+    }
+
+    if (n.location == node_location::slot && l.empty()) {
+      masks_[n.level] &= ~(uint64_t(1) << n.slot);
+    }
+
+    n.prev = npos;
+    n.next = npos;
+  }
+
+  // Detaches all nodes from `l` and returns the first node.
+  // The nodes are still linked by `next`.
+  uint32_t take(list& l) {
+    auto head = l.head;
+    l = list();
+    return head;
+  }
+
+  template <typename Function>
+  void for_each_node(uint32_t head, Function function) {
+    for (auto index = head; index != npos;) {
+      // `function` may update `next`.
+      auto next = nodes_[index].next;
+      function(index);
+      index = next;
+    }
+  }
+
+  void place(uint32_t index) {
+    auto& n = nodes_[index];
+
+    if (n.tick <= current_tick_) {
+      n.location = node_location::expired;
+      push_back(expired_, index);
+      return;
+    }
+
+    auto delta = n.tick - current_tick_;
+    for (size_t level = 0; level < levels; ++level) {
+      if (delta < (int64_t(1) << (slot_bits * (level + 1)))) {
+        auto slot = (n.tick >> (slot_bits * level)) & slot_mask;
+        n.location = node_location::slot;
+        n.level = static_cast<uint8_t>(level);
+        n.slot = static_cast<uint8_t>(slot);
+        push_back(slots_[level][slot], index);
+        masks_[level] |= uint64_t(1) << slot;
+        return;
+      }
+    }
+
+    n.location = node_location::overflow;
+    push_back(overflow_, index);
+  }
+
+  //
+  // Ticks
+  //
+
+  void sync_current_tick(int64_t now) {
+    if (size_ == 0) {
+      current_tick_ = now;
+      return;
+    }
+
+    if (now < current_tick_) {
+      // The time source went backwards (e.g., pqrs::dispatcher::pseudo_time_source is reset).
+      // Place all timers again from the new current tick.
+
+      std::vector<uint32_t> indices;
+      for (auto& l : slots_) {
+        for (auto& s : l) {
+          for_each_node(take(s), [&](auto index) {
+            indices.push_back(index);
+          });
+        }
+      }
+      for_each_node(take(overflow_), [&](auto index) {
+        indices.push_back(index);
+      });
+      for_each_node(take(expired_), [&](auto index) {
+        indices.push_back(index);
+      });
+
+      masks_.fill(0);
+      current_tick_ = now;
+
+      for (const auto& index : indices) {
+        place(index);
+      }
+    }
+  }
+
+  // Returns the next tick which expires slots or cascades timers to lower levels.
+  std::optional<int64_t> next_event_tick(void) const {
+    std::optional<int64_t> result;
+
+    for (size_t level = 0; level < levels; ++level) {
+      if (masks_[level] == 0) {
+        continue;
+      }
+
+      auto shift = slot_bits * level;
+      auto block = (current_tick_ >> shift) + 1;
+      auto i = std::countr_zero(std::rotr(masks_[level], static_cast<int>(block & slot_mask)));
+      auto t = (block + i) << shift;
+      if (!result || t < *result) {
+        result = t;
+      }
+    }
+
+    if (!overflow_.empty()) {
+      auto t = ((current_tick_ >> overflow_shift) + 1) << overflow_shift;
+      if (!result || t < *result) {
+        result = t;
+      }
+    }
+
+    return result;
+  }
+
+  std::optional<int64_t> min_tick(uint32_t head) const {
+    std::optional<int64_t> result;
+    for (auto index = head; index != npos; index = nodes_[index].next) {
+      if (!result || nodes_[index].tick < *result) {
+        result = nodes_[index].tick;
+      }
+    }
+    return result;
+  }
+
+  // Returns the nearest deadline of the armed timers.
+  std::optional<int64_t> next_deadline_tick(void) const {
+    if (!expired_.empty()) {
+      return min_tick(expired_.head);
+    }
+
+    std::optional<int64_t> result;
+
+    for (size_t level = 0; level < levels; ++level) {
+      if (masks_[level] == 0) {
+        continue;
+      }
+
+      // The first visited slot holds the nearest deadlines in the level.
+      auto shift = slot_bits * level;
+      auto block = (current_tick_ >> shift) + 1;
+      auto slot = (block + std::countr_zero(std::rotr(masks_[level], static_cast<int>(block & slot_mask)))) & slot_mask;
+      auto t = min_tick(slots_[level][slot].head);
+      if (t && (!result || *t < *result)) {
+        result = t;
+      }
+    }
+
+    if (auto t = min_tick(overflow_.head)) {
+      if (!result || *t < *result) {
+        result = t;
+      }
+    }
+
+    return result;
+  }
+
+  void cascade(list& l) {
+    for_each_node(take(l), [this](auto index) {
+      place(index);
+    });
+  }
+
+  void process_tick(int64_t tick) {
+    if ((tick & ((int64_t(1) << overflow_shift) - 1)) == 0) {
+      cascade(overflow_);
+    }
+
+    for (size_t level = levels - 1; level > 0; --level) {
+      auto shift = slot_bits * level;
+      if ((tick & ((int64_t(1) << shift) - 1)) == 0) {
+        auto slot = (tick >> shift) & slot_mask;
+        masks_[level] &= ~(uint64_t(1) << slot);
+        cascade(slots_[level][slot]);
+      }
+    }
+
+    auto slot = tick & slot_mask;
+    masks_[0] &= ~(uint64_t(1) << slot);
+    cascade(slots_[0][slot]);
+  }
+
+  // Moves timers whose deadlines are `now` or earlier into `expired_`.
+  void advance(int64_t now) {
+    while (current_tick_ < now) {
+      auto t = next_event_tick();
+      if (!t || *t > now) {
+        current_tick_ = now;
+        return;
+      }
+
+      current_tick_ = *t;
+      process_tick(*t);
+    }
+  }
+
+  //
+  // Dispatcher
+  //
+
+  // Returns `when` of a new task if the task is needed.
+  std::optional<pqrs::dispatcher::time_point> update_task_when(std::optional<int64_t> now) {
+    auto t = next_deadline_tick();
+    if (!t) {
+      return std::nullopt;
+    }
+
+    auto when = make_time_point(*t);
+
+    // Overdue timers (e.g., the time source is advanced over multiple deadlines) are fired in a task
+    // which is placed before tasks at the deadline, as if they were enqueued when the timers were armed.
+    if (now && *t <= *now) {
+      when = std::max(pqrs::dispatcher::dispatcher::when_immediately(),
+                      when - pqrs::dispatcher::duration(1));
+    }
+
+    if (task_when_ && *task_when_ <= when) {
+      return std::nullopt;
+    }
+
+    task_when_ = when;
+    return when;
+  }
+
+  void enqueue_task(std::optional<pqrs::dispatcher::time_point> when) {
+    if (when) {
+      enqueue_to_dispatcher(
+          [this, when] {
+            run(*when);
+          },
+          *when);
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  void run(pqrs::dispatcher::time_point when) {
+    std::vector<uint32_t> batch;
+    int64_t now = 0;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      ++wakeup_count_;
+
+      if (task_when_ == when) {
+        task_when_ = std::nullopt;
+      }
+
+      now = make_tick(when_now());
+      sync_current_tick(now);
+      advance(now);
+
+      // Fire timers which share the nearest deadline.
+
+      if (auto t = min_tick(expired_.head)) {
+        for_each_node(expired_.head, [&](auto index) {
+          if (nodes_[index].tick == *t) {
+            unlink(index);
+            nodes_[index].location = node_location::firing;
+            batch.push_back(index);
+          }
+        });
+
+        std::sort(std::begin(batch),
+                  std::end(batch),
+                  [this](auto a, auto b) {
+                    return nodes_[a].sequence < nodes_[b].sequence;
+                  });
+      }
+    }
+
+    for (const auto& index : batch) {
+      std::function<void(void)> function;
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // The timer might be canceled by another function in the batch.
+        if (nodes_[index].location != node_location::firing) {
+          continue;
+        }
+
+        function = std::move(nodes_[index].function);
+        running_timer_id_ = make_timer_id(index, nodes_[index].generation);
+        release_node(index);
+      }
+
+      function();
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        running_timer_id_ = 0;
+      }
+      running_timer_id_cv_.notify_all();
+    }
+
+    std::optional<pqrs::dispatcher::time_point> task_when;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      task_when = update_task_when(now);
+    }
+
+    enqueue_task(task_when);
+  }
+
+  int64_t current_tick_;
+  std::vector<node> nodes_;
+  std::array<std::array<list, slot_count>, levels> slots_;
+  std::array<uint64_t, levels> masks_;
+  list overflow_;
+  list expired_;
+  size_t size_;
+  uint64_t last_sequence_;
+  uint32_t free_node_;
+  std::optional<pqrs::dispatcher::time_point> task_when_;
+
+  timer_id running_timer_id_;
+  std::condition_variable running_timer_id_cv_;
+
+  size_t wakeup_count_;
+
+  mutable std::mutex mutex_;
+};
+
+//
+// The shared timer wheel
+//
+
+namespace impl {
+inline std::mutex& get_shared_timer_wheel_mutex(void) {
+  static std::mutex mutex;
+  return mutex;
+}
+
+inline std::shared_ptr<timer_wheel>& get_shared_timer_wheel_pointer(void) {
+  static std::shared_ptr<timer_wheel> p;
+  return p;
+}
+} // namespace impl
+
+// The shared timer wheel is attached to the shared dispatcher.
+// Call it after `pqrs::dispatcher::extra::initialize_shared_dispatcher`.
+inline void initialize_shared_timer_wheel(void) {
+  std::lock_guard<std::mutex> lock(impl::get_shared_timer_wheel_mutex());
+
+  auto& p = impl::get_shared_timer_wheel_pointer();
+  if (!p) {
+    p = std::make_shared<timer_wheel>();
+  }
+}
+
+inline void terminate_shared_timer_wheel(void) {
+  std::shared_ptr<timer_wheel> p;
+
+  {
+    std::lock_guard<std::mutex> lock(impl::get_shared_timer_wheel_mutex());
+
+    p = impl::get_shared_timer_wheel_pointer();
+    impl::get_shared_timer_wheel_pointer() = nullptr;
+  }
+
+  // Release the wheel outside the lock since the running timer might refer the shared timer wheel.
+  p = nullptr;
+}
+
+inline std::shared_ptr<timer_wheel> get_shared_timer_wheel(void) {
+  std::lock_guard<std::mutex> lock(impl::get_shared_timer_wheel_mutex());
+
+  return impl::get_shared_timer_wheel_pointer();
+}
+
+// Returns the timer wheel for timers of a dispatcher_client which is attached to `weak_dispatcher`.
+// The shared timer wheel is used if `weak_dispatcher` is the shared dispatcher and the shared timer wheel is initialized.
+// Otherwise (e.g., a dispatcher in tests), a new timer wheel on `weak_dispatcher` is returned.
+inline std::shared_ptr<timer_wheel> make_timer_wheel_for_dispatcher(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher) {
+  if (auto d = weak_dispatcher.lock()) {
+    if (d == pqrs::dispatcher::extra::get_shared_dispatcher()) {
+      if (auto w = get_shared_timer_wheel()) {
+        return w;
+      }
+    }
+    return std::make_shared<timer_wheel>(d);
+  }
+  return nullptr;
+}
+
+// `timer_wheel_timer` is a replacement of `pqrs::dispatcher::extra::timer` which waits the interval on the timer wheel.
+// The usage is same as `pqrs::dispatcher::extra::timer`.
+// (We must not destroy a timer before dispatcher_client is detached.)
+//
+// `weak_dispatcher` must be the dispatcher of `dispatcher_client`.
+// The timer wheel is chosen by `make_timer_wheel_for_dispatcher`.
+class timer_wheel_timer final {
+public:
+  timer_wheel_timer(pqrs::dispatcher::extra::dispatcher_client& dispatcher_client,
+                    std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher = pqrs::dispatcher::extra::get_shared_dispatcher())
+      : dispatcher_client_(dispatcher_client),
+        timer_wheel_(make_timer_wheel_for_dispatcher(weak_dispatcher)),
+        current_function_id_(0),
+        interval_(0),
+        timer_id_(0),
+        enabled_(false) {
+  }
+
+  ~timer_wheel_timer(void) {
+    if (dispatcher_client_.attached()) {
+      // Do not release timer before `dispatcher_client_` is detached.
+      abort();
+    }
+
+    cancel_timer();
+  }
+
+  // First, `function` is called once, and then `function` is called every interval specified by `interval`.
+  void start(std::function<void(void)> function,
+             pqrs::dispatcher::duration interval) {
+    enabled_ = true;
+
+    dispatcher_client_.enqueue_to_dispatcher([this, function, interval] {
+      ++current_function_id_;
+      function_ = function;
+      interval_ = interval;
+
+      call_function(current_function_id_);
+    });
+  }
+
+  void stop(void) {
+    enabled_ = false;
+
+    dispatcher_client_.enqueue_to_dispatcher([this] {
+      ++current_function_id_;
+      function_ = nullptr;
+      interval_ = pqrs::dispatcher::duration(0);
+
+      cancel_timer();
+    });
+  }
+
+  bool enabled(void) const {
+    return enabled_;
+  }
+
+  // Update the interval.
+  // Any `function` call reserved before calling this method will be canceled, and the `function` will be called after `interval` duration.
+  //
+  // Special cases:.
+  // - If `interval` == duration(0), this method works same as `stop`.
+  // - If `interval` is same as the current interval, this method does nothing.
+  void set_interval(pqrs::dispatcher::duration interval) {
+    if (interval == pqrs::dispatcher::duration(0)) {
+      stop();
+    } else if (interval != interval_) {
+      dispatcher_client_.enqueue_to_dispatcher([this, interval] {
+        ++current_function_id_;
+        interval_ = interval;
+
+        enqueue(current_function_id_);
+      });
+    }
+  }
+
+private:
+  // This method is executed in the dispatcher thread.
+  void call_function(int function_id) {
+    if (current_function_id_ != function_id) {
+      return;
+    }
+
+    if (function_) {
+      // We should capture function_ to call proper function even if function_ is updated in `start` or `stop` method.
+      auto f = function_;
+
+      // The `function_` call must be wrapped in enqueue_to_dispatcher in order to avoid heap-use-after-free when the timer itself is destroyed in `function_`.
+      dispatcher_client_.enqueue_to_dispatcher([f] {
+        f();
+      });
+    }
+
+    enqueue(function_id);
+  }
+
+  // This method is executed in the dispatcher thread.
+  void enqueue(int function_id) {
+    cancel_timer();
+
+    if (timer_wheel_) {
+      // The function of the timer wheel is called in the dispatcher thread,
+      // so `call_function` is called directly unless `dispatcher_client_` is detached.
+      timer_id_ = timer_wheel_->arm(dispatcher_client_.when_now() + interval_,
+                                    [this, function_id] {
+                                      if (dispatcher_client_.attached()) {
+                                        call_function(function_id);
+                                      }
+                                    });
+    }
+  }
+
+  void cancel_timer(void) {
+    if (timer_id_ != 0) {
+      if (timer_wheel_) {
+        timer_wheel_->cancel(timer_id_);
+      }
+      timer_id_ = 0;
+    }
+  }
+
+  pqrs::dispatcher::extra::dispatcher_client& dispatcher_client_;
+  std::shared_ptr<timer_wheel> timer_wheel_;
+  int current_function_id_;
+  std::function<void(void)> function_;
+  pqrs::dispatcher::duration interval_;
+  timer_wheel::timer_id timer_id_;
+
+  std::atomic<bool> enabled_;
+};
+
+// `timer_wheel_one_shot_timer` calls a function once at the specified time on the timer wheel.
+// The timer wheel is chosen in the same way as `timer_wheel_timer`.
+// (We must not destroy a timer before dispatcher_client is detached.)
+//
+// `arm` and `cancel` must be called in the dispatcher thread except `cancel` in the destructor of the owner.
+class timer_wheel_one_shot_timer final {
+public:
+  timer_wheel_one_shot_timer(pqrs::dispatcher::extra::dispatcher_client& dispatcher_client,
+                             std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher = pqrs::dispatcher::extra::get_shared_dispatcher())
+      : dispatcher_client_(dispatcher_client),
+        timer_wheel_(make_timer_wheel_for_dispatcher(weak_dispatcher)),
+        timer_id_(0) {
+  }
+
+  ~timer_wheel_one_shot_timer(void) {
+    if (dispatcher_client_.attached()) {
+      // Do not release timer before `dispatcher_client_` is detached.
+      abort();
+    }
+
+    cancel();
+  }
+
+  // Cancel the armed function and call `function` after `duration`.
+  void arm(pqrs::dispatcher::duration duration,
+           std::function<void(void)> function) {
+    cancel();
+
+    if (timer_wheel_) {
+      timer_id_ = timer_wheel_->arm(dispatcher_client_.when_now() + duration,
+                                    [this, function] {
+                                      if (dispatcher_client_.attached()) {
+                                        function();
+                                      }
+                                    });
+    }
+  }
+
+  // If the function is running in another thread, `cancel` waits until the function is finished.
+  void cancel(void) {
+    if (timer_id_ != 0) {
+      if (timer_wheel_) {
+        timer_wheel_->cancel(timer_id_);
+      }
+      timer_id_ = 0;
+    }
+  }
+
+private:
+  pqrs::dispatcher::extra::dispatcher_client& dispatcher_client_;
+  std::shared_ptr<timer_wheel> timer_wheel_;
+  timer_wheel::timer_id timer_id_;
+};
+} // namespace krbn
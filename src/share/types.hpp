@@ -7,6 +7,7 @@
 #include "types/device_state.hpp"
 #include "types/event_type.hpp"
 #include "types/grabbable_state.hpp"
+#include "types/hid_usage_class.hpp"
 #include "types/karabiner_machine_identifier.hpp"
 #include "types/led_state.hpp"
 #include "types/location_id.hpp"
@@ -0,0 +1,219 @@
+#pragma once
+
+#include "modifier_flag.hpp"
+#include "momentary_switch_event_details/apple_vendor_keyboard_key_code.hpp"
+#include "momentary_switch_event_details/apple_vendor_top_case_key_code.hpp"
+#include "momentary_switch_event_details/consumer_key_code.hpp"
+#include "momentary_switch_event_details/generic_desktop.hpp"
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <pqrs/hid.hpp>
+
+namespace krbn {
+enum class hid_usage_kind : uint8_t {
+  none,
+  momentary_switch,
+  pointing_motion_x,
+  pointing_motion_y,
+  pointing_motion_vertical_wheel,
+  pointing_motion_horizontal_wheel,
+  caps_lock_led,
+  hat_switch,
+};
+
+// The classification of a HID usage.
+// `modifier` is `modifier_flag::zero` if the usage is not a modifier key.
+struct hid_usage_class final {
+  hid_usage_kind kind = hid_usage_kind::none;
+  krbn::modifier_flag modifier = krbn::modifier_flag::zero;
+};
+
+namespace hid_usage_class_details {
+// Per usage page tables indexed by usage.
+// They are built at compile time from the momentary_switch_event_details name_value_pairs.
+
+template <typename T>
+constexpr size_t make_table_size(const T& name_value_pairs,
+                                 std::initializer_list<pqrs::hid::usage::value_t> extra_usages) {
+  int32_t max = 0;
+  for (const auto& pair : name_value_pairs) {
+    max = std::max(max, type_safe::get(pair.second));
+  }
+  for (const auto& usage : extra_usages) {
+    max = std::max(max, type_safe::get(usage));
+  }
+  return static_cast<size_t>(max) + 1;
+}
+
+template <size_t N, typename T>
+constexpr std::array<hid_usage_class, N> make_table(const T& name_value_pairs) {
+  std::array<hid_usage_class, N> table{};
+  for (const auto& pair : name_value_pairs) {
+    table[type_safe::get(pair.second)].kind = hid_usage_kind::momentary_switch;
+  }
+  return table;
+}
+
+template <size_t N>
+constexpr void set_kind_if_none(std::array<hid_usage_class, N>& table,
+                                pqrs::hid::usage::value_t usage,
+                                hid_usage_kind kind) {
+  // momentary_switch takes precedence over other kinds.
+  if (table[type_safe::get(usage)].kind == hid_usage_kind::none) {
+    table[type_safe::get(usage)].kind = kind;
+  }
+}
+
+template <size_t N>
+constexpr void set_modifier(std::array<hid_usage_class, N>& table,
+                            pqrs::hid::usage::value_t usage,
+                            krbn::modifier_flag modifier) {
+  table[type_safe::get(usage)].modifier = modifier;
+}
+
+//
+// keyboard_or_keypad
+//
+// Usages in [keyboard_a, reserved) are momentary switches.
+// Usages beyond the table are handled in `classify_hid_usage`.
+//
+
+constexpr size_t keyboard_or_keypad_table_size = 0x100;
+
+constexpr auto keyboard_or_keypad_table = [] {
+  std::array<hid_usage_class, keyboard_or_keypad_table_size> table{};
+  for (auto u = type_safe::get(pqrs::hid::usage::keyboard_or_keypad::keyboard_a); u < static_cast<int32_t>(table.size()); ++u) {
+    table[u].kind = hid_usage_kind::momentary_switch;
+  }
+
+  set_modifier(table, pqrs::hid::usage::keyboard_or_keypad::keyboard_left_control, krbn::modifier_flag::left_control);
+  set_modifier(table, pqrs::hid::usage::keyboard_or_keypad::keyboard_left_shift, krbn::modifier_flag::left_shift);
+  set_modifier(table, pqrs::hid::usage::keyboard_or_keypad::keyboard_left_alt, krbn::modifier_flag::left_option);
+  set_modifier(table, pqrs::hid::usage::keyboard_or_keypad::keyboard_left_gui, krbn::modifier_flag::left_command);
+  set_modifier(table, pqrs::hid::usage::keyboard_or_keypad::keyboard_right_control, krbn::modifier_flag::right_control);
+  set_modifier(table, pqrs::hid::usage::keyboard_or_keypad::keyboard_right_shift, krbn::modifier_flag::right_shift);
+  set_modifier(table, pqrs::hid::usage::keyboard_or_keypad::keyboard_right_alt, krbn::modifier_flag::right_option);
+  set_modifier(table, pqrs::hid::usage::keyboard_or_keypad::keyboard_right_gui, krbn::modifier_flag::right_command);
+
+  return table;
+}();
+
+//
+// consumer
+//
+
+constexpr auto consumer_table = [] {
+  auto table = make_table<make_table_size(momentary_switch_event_details::consumer_key_code::name_value_pairs,
+                                          {pqrs::hid::usage::consumer::ac_pan})>(momentary_switch_event_details::consumer_key_code::name_value_pairs);
+
+  set_kind_if_none(table, pqrs::hid::usage::consumer::ac_pan, hid_usage_kind::pointing_motion_horizontal_wheel);
+
+  return table;
+}();
+
+//
+// apple_vendor_keyboard
+//
+
+constexpr auto apple_vendor_keyboard_table = [] {
+  auto table = make_table<make_table_size(momentary_switch_event_details::apple_vendor_keyboard_key_code::name_value_pairs,
+                                          {pqrs::hid::usage::apple_vendor_keyboard::function})>(momentary_switch_event_details::apple_vendor_keyboard_key_code::name_value_pairs);
+
+  set_modifier(table, pqrs::hid::usage::apple_vendor_keyboard::function, krbn::modifier_flag::fn);
+
+  return table;
+}();
+
+//
+// apple_vendor_top_case
+//
+
+constexpr auto apple_vendor_top_case_table = [] {
+  auto table = make_table<make_table_size(momentary_switch_event_details::apple_vendor_top_case_key_code::name_value_pairs,
+                                          {pqrs::hid::usage::apple_vendor_top_case::keyboard_fn})>(momentary_switch_event_details::apple_vendor_top_case_key_code::name_value_pairs);
+
+  set_modifier(table, pqrs::hid::usage::apple_vendor_top_case::keyboard_fn, krbn::modifier_flag::fn);
+
+  return table;
+}();
+
+//
+// generic_desktop
+//
+
+constexpr auto generic_desktop_table = [] {
+  auto table = make_table<make_table_size(momentary_switch_event_details::generic_desktop::name_value_pairs,
+                                          {
+                                              pqrs::hid::usage::generic_desktop::x,
+                                              pqrs::hid::usage::generic_desktop::y,
+                                              pqrs::hid::usage::generic_desktop::wheel,
+                                              pqrs::hid::usage::generic_desktop::hat_switch,
+                                          })>(momentary_switch_event_details::generic_desktop::name_value_pairs);
+
+  set_kind_if_none(table, pqrs::hid::usage::generic_desktop::x, hid_usage_kind::pointing_motion_x);
+  set_kind_if_none(table, pqrs::hid::usage::generic_desktop::y, hid_usage_kind::pointing_motion_y);
+  set_kind_if_none(table, pqrs::hid::usage::generic_desktop::wheel, hid_usage_kind::pointing_motion_vertical_wheel);
+  set_kind_if_none(table, pqrs::hid::usage::generic_desktop::hat_switch, hid_usage_kind::hat_switch);
+
+  return table;
+}();
+
+//
+// leds
+//
+
+constexpr auto leds_table = [] {
+  std::array<hid_usage_class, type_safe::get(pqrs::hid::usage::led::caps_lock) + 1> table{};
+
+  set_kind_if_none(table, pqrs::hid::usage::led::caps_lock, hid_usage_kind::caps_lock_led);
+
+  return table;
+}();
+
+template <size_t N>
+constexpr hid_usage_class find(const std::array<hid_usage_class, N>& table,
+                               pqrs::hid::usage::value_t usage) {
+  auto u = type_safe::get(usage);
+  if (0 <= u && u < static_cast<int32_t>(N)) {
+    return table[u];
+  }
+  return hid_usage_class();
+}
+} // namespace hid_usage_class_details
+
+// Classify a HID usage by one table lookup.
+// This is called for every HID value in `event_queue::utility::make_entries`.
+constexpr hid_usage_class classify_hid_usage(pqrs::hid::usage_page::value_t usage_page,
+                                             pqrs::hid::usage::value_t usage) {
+  switch (type_safe::get(usage_page)) {
+    case type_safe::get(pqrs::hid::usage_page::keyboard_or_keypad):
+      if (type_safe::get(usage) >= static_cast<int32_t>(hid_usage_class_details::keyboard_or_keypad_table_size) &&
+          type_safe::get(usage) < type_safe::get(pqrs::hid::usage::keyboard_or_keypad::reserved)) {
+        return hid_usage_class{hid_usage_kind::momentary_switch};
+      }
+      return hid_usage_class_details::find(hid_usage_class_details::keyboard_or_keypad_table, usage);
+
+    case type_safe::get(pqrs::hid::usage_page::consumer):
+      return hid_usage_class_details::find(hid_usage_class_details::consumer_table, usage);
+
+    case type_safe::get(pqrs::hid::usage_page::apple_vendor_keyboard):
+      return hid_usage_class_details::find(hid_usage_class_details::apple_vendor_keyboard_table, usage);
+
+    case type_safe::get(pqrs::hid::usage_page::apple_vendor_top_case):
+      return hid_usage_class_details::find(hid_usage_class_details::apple_vendor_top_case_table, usage);
+
+    case type_safe::get(pqrs::hid::usage_page::generic_desktop):
+      return hid_usage_class_details::find(hid_usage_class_details::generic_desktop_table, usage);
+
+    case type_safe::get(pqrs::hid::usage_page::leds):
+      return hid_usage_class_details::find(hid_usage_class_details::leds_table, usage);
+
+    case type_safe::get(pqrs::hid::usage_page::button):
+      // All usages in the button page are pointing buttons.
+      return hid_usage_class{hid_usage_kind::momentary_switch};
+  }
+
+  return hid_usage_class();
+}
+} // namespace krbn
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "manipulator_environment_variable_name_table.hpp"
 #include "manipulator_environment_variable_value.hpp"
 
 namespace krbn {
@@ -19,6 +20,7 @@ public:
                                                 std::optional<manipulator_environment_variable_value> key_up_value,
                                                 type type = type::set)
       : name_(name),
+        name_slot_(make_name_slot(name)),
         value_(value),
         key_up_value_(key_up_value),
         type_(type) {
@@ -30,6 +32,12 @@ public:
 
   void set_name(std::optional<std::string> value) {
     name_ = value;
+    name_slot_ = make_name_slot(value);
+  }
+
+  // The interned slot of `name` in `manipulator_environment_variable_name_table`.
+  std::optional<manipulator_environment_variable_name_table::slot> get_name_slot(void) const {
+    return name_slot_;
   }
 
   std::optional<manipulator_environment_variable_value> get_value(void) const {
@@ -68,7 +76,15 @@ public:
   }
 
 private:
+  static std::optional<manipulator_environment_variable_name_table::slot> make_name_slot(const std::optional<std::string>& name) {
+    if (name) {
+      return get_shared_manipulator_environment_variable_name_table().intern(*name);
+    }
+    return std::nullopt;
+  }
+
   std::optional<std::string> name_;
+  std::optional<manipulator_environment_variable_name_table::slot> name_slot_;
   std::optional<manipulator_environment_variable_value> value_;
   std::optional<manipulator_environment_variable_value> key_up_value_;
   type type_;
@@ -20,6 +20,15 @@ enum class modifier_flag : uint32_t {
   end_,
 };
 
+// A set of modifier_flag represented as `1 << modifier_flag`.
+using modifier_flag_bitmask = uint32_t;
+
+static_assert(static_cast<uint32_t>(modifier_flag::end_) <= sizeof(modifier_flag_bitmask) * 8);
+
+constexpr modifier_flag_bitmask make_modifier_flag_bitmask(modifier_flag modifier_flag) {
+  return modifier_flag_bitmask(1) << static_cast<uint32_t>(modifier_flag);
+}
+
 inline std::optional<pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::modifier> make_hid_report_modifier(modifier_flag modifier_flag) {
   namespace hid_report = pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report;
 
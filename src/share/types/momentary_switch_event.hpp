@@ -1,5 +1,6 @@
 #pragma once
 
+#include "hid_usage_class.hpp"
 #include "momentary_switch_event_details/apple_vendor_keyboard_key_code.hpp"
 #include "momentary_switch_event_details/apple_vendor_top_case_key_code.hpp"
 #include "momentary_switch_event_details/consumer_key_code.hpp"
@@ -17,27 +18,31 @@ class momentary_switch_event final {
 public:
   static bool target(pqrs::hid::usage_page::value_t usage_page,
                      pqrs::hid::usage::value_t usage) {
-    return momentary_switch_event_details::key_code::target(usage_page, usage) ||
-           momentary_switch_event_details::consumer_key_code::target(usage_page, usage) ||
-           momentary_switch_event_details::apple_vendor_keyboard_key_code::target(usage_page, usage) ||
-           momentary_switch_event_details::apple_vendor_top_case_key_code::target(usage_page, usage) ||
-           momentary_switch_event_details::pointing_button::target(usage_page, usage) ||
-           momentary_switch_event_details::generic_desktop::target(usage_page, usage);
+    return classify_hid_usage(usage_page, usage).kind == hid_usage_kind::momentary_switch;
   }
 
-  momentary_switch_event(void) {
+  momentary_switch_event(void) : modifier_flag_(krbn::modifier_flag::zero) {
   }
 
   momentary_switch_event(pqrs::hid::usage_page::value_t usage_page,
                          pqrs::hid::usage::value_t usage)
-      : usage_pair_(usage_page, usage) {
+      : usage_pair_(usage_page, usage),
+        modifier_flag_(classify_hid_usage(usage_page, usage).modifier) {
   }
 
   explicit momentary_switch_event(const pqrs::hid::usage_pair& usage_pair)
       : momentary_switch_event(usage_pair.get_usage_page(), usage_pair.get_usage()) {
   }
 
-  explicit momentary_switch_event(const krbn::modifier_flag& modifier_flag) {
+  // Construct with the result of `classify_hid_usage` in order to avoid looking up the usage again.
+  momentary_switch_event(pqrs::hid::usage_page::value_t usage_page,
+                         pqrs::hid::usage::value_t usage,
+                         const hid_usage_class& usage_class)
+      : usage_pair_(usage_page, usage),
+        modifier_flag_(usage_class.modifier) {
+  }
+
+  explicit momentary_switch_event(const krbn::modifier_flag& modifier_flag) : modifier_flag_(krbn::modifier_flag::zero) {
     switch (modifier_flag) {
       case modifier_flag::zero:
         break;
@@ -84,6 +89,8 @@ public:
       case modifier_flag::end_:
         break;
     }
+
+    update_modifier_flag();
   }
 
   const pqrs::hid::usage_pair& get_usage_pair(void) const {
@@ -92,43 +99,16 @@ public:
 
   momentary_switch_event& set_usage_pair(const pqrs::hid::usage_pair& usage_pair) {
     usage_pair_ = usage_pair;
+    update_modifier_flag();
 
     return *this;
   }
 
   std::optional<krbn::modifier_flag> make_modifier_flag(void) const {
-    auto usage_page = usage_pair_.get_usage_page();
-    auto usage = usage_pair_.get_usage();
-
-    if (usage_page == pqrs::hid::usage_page::keyboard_or_keypad) {
-      if (usage == pqrs::hid::usage::keyboard_or_keypad::keyboard_left_control) {
-        return krbn::modifier_flag::left_control;
-      } else if (usage == pqrs::hid::usage::keyboard_or_keypad::keyboard_left_shift) {
-        return krbn::modifier_flag::left_shift;
-      } else if (usage == pqrs::hid::usage::keyboard_or_keypad::keyboard_left_alt) {
-        return krbn::modifier_flag::left_option;
-      } else if (usage == pqrs::hid::usage::keyboard_or_keypad::keyboard_left_gui) {
-        return krbn::modifier_flag::left_command;
-      } else if (usage == pqrs::hid::usage::keyboard_or_keypad::keyboard_right_control) {
-        return krbn::modifier_flag::right_control;
-      } else if (usage == pqrs::hid::usage::keyboard_or_keypad::keyboard_right_shift) {
-        return krbn::modifier_flag::right_shift;
-      } else if (usage == pqrs::hid::usage::keyboard_or_keypad::keyboard_right_alt) {
-        return krbn::modifier_flag::right_option;
-      } else if (usage == pqrs::hid::usage::keyboard_or_keypad::keyboard_right_gui) {
-        return krbn::modifier_flag::right_command;
-      }
-    } else if (usage_page == pqrs::hid::usage_page::apple_vendor_keyboard) {
-      if (usage == pqrs::hid::usage::apple_vendor_keyboard::function) {
-        return krbn::modifier_flag::fn;
-      }
-    } else if (usage_page == pqrs::hid::usage_page::apple_vendor_top_case) {
-      if (usage == pqrs::hid::usage::apple_vendor_top_case::keyboard_fn) {
-        return krbn::modifier_flag::fn;
-      }
+    if (modifier_flag_ == krbn::modifier_flag::zero) {
+      return std::nullopt;
     }
-
-    return std::nullopt;
+    return modifier_flag_;
   }
 
   bool valid(void) const {
@@ -137,7 +117,7 @@ public:
   }
 
   bool modifier_flag(void) const {
-    return make_modifier_flag() != std::nullopt;
+    return modifier_flag_ != krbn::modifier_flag::zero;
   }
 
   bool caps_lock(void) const {
@@ -173,7 +153,17 @@ public:
   auto operator<=>(const momentary_switch_event&) const = default;
 
 private:
+  void update_modifier_flag(void) {
+    modifier_flag_ = classify_hid_usage(usage_pair_.get_usage_page(),
+                                        usage_pair_.get_usage())
+                         .modifier;
+  }
+
   pqrs::hid::usage_pair usage_pair_;
+
+  // The modifier flag is cached since it is referred on every event.
+  // (modifier_flag::zero if the event is not a modifier key.)
+  krbn::modifier_flag modifier_flag_;
 };
 
 inline void to_json(nlohmann::json& json, const momentary_switch_event& value) {
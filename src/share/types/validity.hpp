@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstdint>
+
 namespace krbn {
-enum class validity {
+enum class validity : uint8_t {
   invalid,
   valid,
 };
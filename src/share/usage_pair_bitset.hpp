@@ -0,0 +1,180 @@
+#pragma once
+
+// `krbn::usage_pair_bitset` is not thread-safe.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <pqrs/hid.hpp>
+#include <vector>
+
+namespace krbn {
+// A set of usage_pair which is backed by fixed-size bitsets.
+//
+// The usage spaces of momentary switch events (keys, consumer keys, buttons, etc.) are small and bounded,
+// so they are stored in bitsets without heap allocations.
+// Other usage pairs are stored in a fallback vector to keep std::set semantics.
+class usage_pair_bitset final {
+public:
+  usage_pair_bitset(void)
+      : size_(0) {
+    words_.fill(0);
+  }
+
+  // Returns true if the value is newly inserted.
+  bool insert(const pqrs::hid::usage_pair& value) {
+    if (auto index = make_index(value)) {
+      auto& word = words_[*index / 64];
+      auto bit = uint64_t(1) << (*index % 64);
+      if (word & bit) {
+        return false;
+      }
+      word |= bit;
+      ++size_;
+      return true;
+    }
+
+    if (std::find(std::begin(others_), std::end(others_), value) != std::end(others_)) {
+      return false;
+    }
+    others_.push_back(value);
+    ++size_;
+    return true;
+  }
+
+  // Returns true if the value is erased.
+  bool erase(const pqrs::hid::usage_pair& value) {
+    if (auto index = make_index(value)) {
+      auto& word = words_[*index / 64];
+      auto bit = uint64_t(1) << (*index % 64);
+      if (!(word & bit)) {
+        return false;
+      }
+      word &= ~bit;
+      --size_;
+      return true;
+    }
+
+    auto it = std::find(std::begin(others_), std::end(others_), value);
+    if (it == std::end(others_)) {
+      return false;
+    }
+    others_.erase(it);
+    --size_;
+    return true;
+  }
+
+  bool contains(const pqrs::hid::usage_pair& value) const {
+    if (auto index = make_index(value)) {
+      return words_[*index / 64] & (uint64_t(1) << (*index % 64));
+    }
+
+    return std::find(std::begin(others_), std::end(others_), value) != std::end(others_);
+  }
+
+  bool empty(void) const {
+    return size_ == 0;
+  }
+
+  size_t size(void) const {
+    return size_;
+  }
+
+  void clear(void) {
+    words_.fill(0);
+    others_.clear();
+    size_ = 0;
+  }
+
+  // Returns the bits of 64 usages from `first_usage` in `usage_page`.
+  // (e.g., `get_bits(usage_page::button, 0)` returns button_1 as bit 1, button_2 as bit 2, ...)
+  // `first_usage` must be a multiple of 64.
+  uint64_t get_bits(pqrs::hid::usage_page::value_t usage_page, size_t first_usage) const {
+    if (auto p = find_page(usage_page)) {
+      if (first_usage % 64 == 0 && first_usage < p->size) {
+        return words_[(p->offset + first_usage) / 64];
+      }
+    }
+
+    return 0;
+  }
+
+  template <typename Function>
+  void for_each(Function function) const {
+    for (size_t w = 0; w < words_.size(); ++w) {
+      for (auto bits = words_[w]; bits != 0; bits &= bits - 1) {
+        function(make_usage_pair(w * 64 + std::countr_zero(bits)));
+      }
+    }
+
+    for (const auto& v : others_) {
+      function(v);
+    }
+  }
+
+private:
+  struct page final {
+    pqrs::hid::usage_page::value_t usage_page;
+    size_t offset;
+    size_t size;
+  };
+
+  static constexpr std::array<page, 6> pages{{
+      {pqrs::hid::usage_page::keyboard_or_keypad, 0, 256},
+      {pqrs::hid::usage_page::button, 256, 256},
+      {pqrs::hid::usage_page::generic_desktop, 512, 256},
+      {pqrs::hid::usage_page::apple_vendor_keyboard, 768, 256},
+      {pqrs::hid::usage_page::apple_vendor_top_case, 1024, 256},
+      {pqrs::hid::usage_page::consumer, 1280, 1024},
+  }};
+
+  static constexpr size_t bit_count = 2304;
+
+  static std::optional<size_t> make_index(const pqrs::hid::usage_pair& value) {
+    if (auto p = find_page(value.get_usage_page())) {
+      auto usage = static_cast<size_t>(type_safe::get(value.get_usage()));
+      if (usage < p->size) {
+        return p->offset + usage;
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  static const page* find_page(pqrs::hid::usage_page::value_t usage_page) {
+    switch (type_safe::get(usage_page)) {
+      case type_safe::get(pqrs::hid::usage_page::keyboard_or_keypad):
+        return &pages[0];
+      case type_safe::get(pqrs::hid::usage_page::button):
+        return &pages[1];
+      case type_safe::get(pqrs::hid::usage_page::generic_desktop):
+        return &pages[2];
+      case type_safe::get(pqrs::hid::usage_page::apple_vendor_keyboard):
+        return &pages[3];
+      case type_safe::get(pqrs::hid::usage_page::apple_vendor_top_case):
+        return &pages[4];
+      case type_safe::get(pqrs::hid::usage_page::consumer):
+        return &pages[5];
+    }
+
+    return nullptr;
+  }
+
+  static pqrs::hid::usage_pair make_usage_pair(size_t index) {
+    for (const auto& p : pages) {
+      if (p.offset <= index && index < p.offset + p.size) {
+        return pqrs::hid::usage_pair(p.usage_page,
+                                     pqrs::hid::usage::value_t(index - p.offset));
+      }
+    }
+
+    return pqrs::hid::usage_pair();
+  }
+
+  std::array<uint64_t, bit_count / 64> words_;
+  std::vector<pqrs::hid::usage_pair> others_;
+  size_t size_;
+};
+} // namespace krbn
@@ -84,4 +84,56 @@ void run_complex_modifications_rule_test(void) {
       expect(expected_json == rule.to_json());
     }
   };
+
+  "complex_modifications_rule.get_content_hash"_test = [] {
+    auto json = R"(
+
+{
+  "description": "content_hash",
+  "manipulators": [
+    {
+      "from": { "key_code": "f12" },
+      "to": [{ "key_code": "mission_control" }],
+      "type": "basic"
+    }
+  ]
+}
+
+)"_json;
+
+    auto make_content_hash = [](const nlohmann::json& json,
+                                gsl::not_null<std::shared_ptr<const krbn::core_configuration::details::complex_modifications_parameters>> parameters) {
+      krbn::core_configuration::details::complex_modifications_rule rule(json,
+                                                                         parameters,
+                                                                         krbn::core_configuration::error_handling::strict);
+      return rule.get_content_hash();
+    };
+
+    auto parameters = std::make_shared<krbn::core_configuration::details::complex_modifications_parameters>();
+    auto h = make_content_hash(json, parameters);
+
+    // Same content
+    expect(h == make_content_hash(json, parameters));
+
+    // `enabled` is ignored
+    {
+      auto j = json;
+      j["enabled"] = false;
+      expect(h == make_content_hash(j, parameters));
+    }
+
+    // Changed manipulators
+    {
+      auto j = json;
+      j["manipulators"][0]["to"][0]["key_code"] = "launchpad";
+      expect(h != make_content_hash(j, parameters));
+    }
+
+    // Changed parameters
+    {
+      auto p = std::make_shared<krbn::core_configuration::details::complex_modifications_parameters>();
+      p->set_basic_to_if_alone_timeout_milliseconds(500);
+      expect(h != make_content_hash(json, p));
+    }
+  };
 }
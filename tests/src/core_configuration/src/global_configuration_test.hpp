@@ -20,6 +20,7 @@ void run_global_configuration_test(void) {
       expect(global_configuration.get_unsafe_ui() == false);
       expect(global_configuration.get_filter_useless_events_from_specific_devices() == true);
       expect(global_configuration.get_reorder_same_timestamp_input_events_to_prioritize_modifiers() == true);
+      expect(global_configuration.get_coalesce_pointing_input_reports() == false);
     }
 
     // load values from json
@@ -34,6 +35,7 @@ void run_global_configuration_test(void) {
           {"unsafe_ui", true},
           {"filter_useless_events_from_specific_devices", false},
           {"reorder_same_timestamp_input_events_to_prioritize_modifiers", false},
+          {"coalesce_pointing_input_reports", true},
       };
       krbn::core_configuration::details::global_configuration global_configuration(json,
                                                                                    krbn::core_configuration::error_handling::strict);
@@ -46,6 +48,7 @@ void run_global_configuration_test(void) {
       expect(global_configuration.get_unsafe_ui() == true);
       expect(global_configuration.get_filter_useless_events_from_specific_devices() == false);
       expect(global_configuration.get_reorder_same_timestamp_input_events_to_prioritize_modifiers() == false);
+      expect(global_configuration.get_coalesce_pointing_input_reports() == true);
 
       //
       // Set default values
@@ -60,6 +63,7 @@ void run_global_configuration_test(void) {
       global_configuration.set_unsafe_ui(false);
       global_configuration.set_filter_useless_events_from_specific_devices(true);
       global_configuration.set_reorder_same_timestamp_input_events_to_prioritize_modifiers(true);
+      global_configuration.set_coalesce_pointing_input_reports(false);
       nlohmann::json j(global_configuration);
       expect(j.empty());
     }
@@ -75,6 +79,7 @@ void run_global_configuration_test(void) {
           {"unsafe_ui", nlohmann::json::object()},
           {"filter_useless_events_from_specific_devices", nlohmann::json::object()},
           {"reorder_same_timestamp_input_events_to_prioritize_modifiers", nlohmann::json::object()},
+          {"coalesce_pointing_input_reports", nlohmann::json::object()},
       };
       krbn::core_configuration::details::global_configuration global_configuration(json,
                                                                                    krbn::core_configuration::error_handling::loose);
@@ -87,6 +92,7 @@ void run_global_configuration_test(void) {
       expect(global_configuration.get_unsafe_ui() == false);
       expect(global_configuration.get_filter_useless_events_from_specific_devices() == true);
       expect(global_configuration.get_reorder_same_timestamp_input_events_to_prioritize_modifiers() == true);
+      expect(global_configuration.get_coalesce_pointing_input_reports() == false);
     }
   };
 }
@@ -19,7 +19,7 @@ int main(void) {
 
     {
       auto dp = manager.find(krbn::device_id(1));
-      expect(dp.get() != nullptr);
+      expect(dp != nullptr);
       expect(dp->get_device_id() == krbn::device_id(1));
     }
 
@@ -27,7 +27,7 @@ int main(void) {
 
     {
       auto dp = manager.find(krbn::device_id(2));
-      expect(dp.get() != nullptr);
+      expect(dp != nullptr);
       expect(dp->get_device_id() == krbn::device_id(2));
     }
 
@@ -35,7 +35,7 @@ int main(void) {
 
     {
       auto dp = manager.find(krbn::device_id(3));
-      expect(dp.get() != nullptr);
+      expect(dp != nullptr);
       expect(dp->get_device_id() == krbn::device_id(3));
     }
 
@@ -43,7 +43,7 @@ int main(void) {
 
     {
       auto dp = manager.find(krbn::device_id(4));
-      expect(dp.get() == nullptr);
+      expect(dp == nullptr);
     }
 
     // erase iokit_device_id(2)
@@ -51,7 +51,28 @@ int main(void) {
     {
       manager.erase(krbn::device_id(2));
       auto dp = manager.find(krbn::device_id(2));
-      expect(dp.get() == nullptr);
+      expect(dp == nullptr);
+    }
+
+    // dense index
+
+    {
+      expect(manager.find_index(krbn::device_id(1)) == 0);
+      expect(manager.find_index(krbn::device_id(2)) == std::nullopt);
+      expect(manager.find_index(krbn::device_id(3)) == 2);
+
+      // The index of the erased device is reused.
+      manager.insert(krbn::device_id(4),
+                     krbn::device_properties::make_device_properties(krbn::device_id(4), nullptr));
+      expect(manager.find_index(krbn::device_id(4)) == 1);
+      expect(manager.get_device_properties().size() == 3);
+
+      // Re-inserting the same device keeps the index.
+      manager.insert(krbn::device_id(4),
+                     krbn::device_properties::make_device_properties(krbn::device_id(4), nullptr));
+      expect(manager.find_index(krbn::device_id(4)) == 1);
+      expect(manager.find(krbn::device_id(4))->get_device_id() == krbn::device_id(4));
+      expect(manager.get_device_properties().size() == 3);
     }
 
     // clear
@@ -59,7 +80,7 @@ int main(void) {
     {
       manager.clear();
       auto dp = manager.find(krbn::device_id(1));
-      expect(dp.get() == nullptr);
+      expect(dp == nullptr);
     }
   };
 
@@ -0,0 +1,148 @@
+#include "../../share/benchmark_helper.hpp"
+#include "event_queue.hpp"
+
+namespace {
+template <typename T>
+void print_layout(const std::string& name) {
+  std::cout << name << ": sizeof " << sizeof(T) << ", alignof " << alignof(T) << std::endl;
+}
+
+// A synthetic stream of mixed HID values (keys, modifiers, pointing motion, buttons, consumer keys, leds and unhandled usages).
+std::vector<pqrs::osx::iokit_hid_value> make_mixed_hid_values(size_t size) {
+  std::vector<pqrs::hid::usage_pair> usage_pairs{
+      {pqrs::hid::usage_page::keyboard_or_keypad, pqrs::hid::usage::keyboard_or_keypad::keyboard_a},
+      {pqrs::hid::usage_page::keyboard_or_keypad, pqrs::hid::usage::keyboard_or_keypad::keyboard_left_shift},
+      {pqrs::hid::usage_page::generic_desktop, pqrs::hid::usage::generic_desktop::x},
+      {pqrs::hid::usage_page::generic_desktop, pqrs::hid::usage::generic_desktop::y},
+      {pqrs::hid::usage_page::generic_desktop, pqrs::hid::usage::generic_desktop::wheel},
+      {pqrs::hid::usage_page::consumer, pqrs::hid::usage::consumer::ac_pan},
+      {pqrs::hid::usage_page::button, pqrs::hid::usage::button::button_1},
+      {pqrs::hid::usage_page::consumer, pqrs::hid::usage::consumer::mute},
+      {pqrs::hid::usage_page::apple_vendor_top_case, pqrs::hid::usage::apple_vendor_top_case::keyboard_fn},
+      {pqrs::hid::usage_page::leds, pqrs::hid::usage::led::caps_lock},
+      {pqrs::hid::usage_page::keyboard_or_keypad, pqrs::hid::usage::keyboard_or_keypad::error_undefined},
+      {pqrs::hid::usage_page::generic_desktop, pqrs::hid::usage::generic_desktop::z},
+  };
+
+  std::vector<pqrs::osx::iokit_hid_value> hid_values;
+  for (size_t i = 0; i < size; ++i) {
+    const auto& pair = usage_pairs[i % usage_pairs.size()];
+    hid_values.emplace_back(pqrs::osx::iokit_hid_value(krbn::absolute_time_point(100 + i),
+                                                       (i / usage_pairs.size()) % 2,
+                                                       pair.get_usage_page(),
+                                                       pair.get_usage(),
+                                                       std::nullopt, // logical_max
+                                                       std::nullopt  // logical_min
+                                                       ));
+  }
+  return hid_values;
+}
+} // namespace
+
+int main(void) {
+  //
+  // Layout
+  //
+
+  print_layout<krbn::event_queue::event_time_stamp>("event_queue::event_time_stamp");
+  print_layout<krbn::event_queue::event>("event_queue::event");
+  print_layout<krbn::event_queue::entry>("event_queue::entry");
+
+  //
+  // push_back_entry throughput
+  //
+
+  {
+    krbn::event_queue::event a_event(krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                                   pqrs::hid::usage::keyboard_or_keypad::keyboard_a));
+
+    krbn::event_queue::entry entry(krbn::device_id(1),
+                                   krbn::event_queue::event_time_stamp(krbn::absolute_time_point(100)),
+                                   a_event,
+                                   krbn::event_type::key_down,
+                                   a_event,
+                                   krbn::event_queue::state::original);
+
+    krbn::event_queue::queue event_queue;
+
+    auto duration = krbn::unit_testing::benchmark_helper::measure(1000, [&] {
+      for (int i = 0; i < 1000; ++i) {
+        event_queue.push_back_entry(entry);
+      }
+      event_queue.clear_events();
+    });
+
+    krbn::unit_testing::benchmark_helper::print("event_queue::queue::push_back_entry (key event)",
+                                                duration / 1000);
+  }
+
+  {
+    auto shell_command_event = krbn::event_queue::event::make_shell_command_event("open -a 'Activity Monitor.app'");
+
+    krbn::event_queue::entry entry(krbn::device_id(1),
+                                   krbn::event_queue::event_time_stamp(krbn::absolute_time_point(100)),
+                                   shell_command_event,
+                                   krbn::event_type::key_down,
+                                   shell_command_event,
+                                   krbn::event_queue::state::original);
+
+    krbn::event_queue::queue event_queue;
+
+    auto duration = krbn::unit_testing::benchmark_helper::measure(1000, [&] {
+      for (int i = 0; i < 1000; ++i) {
+        event_queue.push_back_entry(entry);
+      }
+      event_queue.clear_events();
+    });
+
+    krbn::unit_testing::benchmark_helper::print("event_queue::queue::push_back_entry (shell_command event)",
+                                                duration / 1000);
+  }
+
+  //
+  // HID value classification
+  //
+
+  {
+    auto hid_values = make_mixed_hid_values(1000);
+
+    size_t momentary_switch_count = 0;
+    size_t modifier_count = 0;
+
+    auto duration = krbn::unit_testing::benchmark_helper::measure(1000, [&] {
+      for (const auto& v : hid_values) {
+        auto usage_class = krbn::classify_hid_usage(*(v.get_usage_page()), *(v.get_usage()));
+        if (usage_class.kind == krbn::hid_usage_kind::momentary_switch) {
+          ++momentary_switch_count;
+        }
+        if (usage_class.modifier != krbn::modifier_flag::zero) {
+          ++modifier_count;
+        }
+      }
+    });
+
+    krbn::unit_testing::benchmark_helper::print("classify_hid_usage (mixed HID values)",
+                                                duration / hid_values.size());
+
+    std::cout << "  momentary_switch: " << momentary_switch_count << ", modifier: " << modifier_count << std::endl;
+  }
+
+  {
+    auto hid_values = make_mixed_hid_values(1000);
+    auto device_properties = krbn::device_properties::make_device_properties(krbn::device_id(1),
+                                                                             nullptr);
+    krbn::event_queue::entries_pool pool;
+
+    auto duration = krbn::unit_testing::benchmark_helper::measure(1000, [&] {
+      krbn::event_queue::utility::make_entries(pool,
+                                               device_properties,
+                                               hid_values,
+                                               {});
+    });
+
+    krbn::unit_testing::benchmark_helper::print("event_queue::utility::make_entries (mixed HID values)",
+                                                duration / hid_values.size());
+  }
+
+  return 0;
+}
@@ -1,5 +1,6 @@
 #include "test.hpp"
 #include <boost/ut.hpp>
+#include <random>
 
 namespace {
 krbn::event_queue::event a_event(
@@ -429,6 +430,77 @@ void run_event_queue_test(void) {
     }
   };
 
+  "sort_events (compare with the full scan algorithm)"_test = [] {
+    // The previous implementation which scans all entries at each call.
+    auto full_scan_sort = [](std::vector<krbn::event_queue::entry>& events) {
+      if (events.empty()) {
+        return;
+      }
+
+      for (size_t i = 0; i < events.size() - 1;) {
+        if (krbn::event_queue::queue::needs_swap(events[i], events[i + 1])) {
+          std::swap(events[i], events[i + 1]);
+          if (i > 0) {
+            --i;
+          }
+          continue;
+        }
+        ++i;
+      }
+    };
+
+    std::vector<krbn::event_queue::event> events{
+        a_event,
+        b_event,
+        left_control_event,
+        left_shift_event,
+        right_shift_event,
+        device_keys_and_pointing_buttons_are_released_event,
+    };
+
+    std::mt19937 engine(0);
+
+    for (int trial = 0; trial < 200; ++trial) {
+      krbn::event_queue::queue event_queue;
+      std::vector<krbn::event_queue::entry> expected;
+      uint64_t time_stamp = 100;
+
+      for (int step = 0; step < 50; ++step) {
+        auto push_count = engine() % 8;
+        for (uint32_t i = 0; i < push_count; ++i) {
+          if (engine() % 3 == 0) {
+            time_stamp += 100;
+          }
+
+          auto& e = events[engine() % events.size()];
+          auto event_type = (e.get_type() == krbn::event_queue::event::type::momentary_switch_event
+                                 ? (engine() % 2 ? krbn::event_type::key_down : krbn::event_type::key_up)
+                                 : krbn::event_type::single);
+
+          krbn::event_queue::entry entry(krbn::device_id(1),
+                                         krbn::event_queue::event_time_stamp(krbn::absolute_time_point(time_stamp)),
+                                         e,
+                                         event_type,
+                                         e,
+                                         krbn::event_queue::state::original);
+          event_queue.push_back_entry(entry);
+          expected.push_back(entry);
+        }
+
+        event_queue.sort_events();
+        full_scan_sort(expected);
+
+        expect(event_queue.get_entries() == expected) << "trial:" << trial << " step:" << step;
+
+        auto erase_count = engine() % 4;
+        for (uint32_t i = 0; i < erase_count && !expected.empty(); ++i) {
+          event_queue.erase_front_event();
+          expected.erase(std::begin(expected));
+        }
+      }
+    }
+  };
+
   "needs_swap"_test = [] {
     krbn::event_queue::entry spacebar_down(krbn::device_id(1),
                                            krbn::event_queue::event_time_stamp(
@@ -540,6 +612,153 @@ void run_event_queue_test(void) {
     }
   };
 
+  "drain"_test = [] {
+    {
+      krbn::event_queue::queue event_queue;
+
+      const int count = 100000;
+
+      for (int i = 0; i < count; ++i) {
+        ENQUEUE_EVENT(event_queue, 1, i, a_event, key_down, a_event);
+      }
+
+      expect(event_queue.get_entries().size() == static_cast<size_t>(count));
+
+      for (int i = 0; i < count; ++i) {
+        expect(event_queue.get_front_event().get_event_time_stamp().get_time_stamp() == krbn::absolute_time_point(i)) << "i:" << i;
+        event_queue.erase_front_event();
+      }
+
+      expect(event_queue.empty());
+      expect(event_queue.get_time_stamp_delay() == krbn::absolute_time_duration(0));
+    }
+
+    // Push and erase alternately in order to wrap around the buffer.
+
+    {
+      krbn::event_queue::queue event_queue;
+
+      int front = 0;
+      int back = 0;
+
+      for (int i = 0; i < 1000; ++i) {
+        for (int j = 0; j < 100; ++j) {
+          ENQUEUE_EVENT(event_queue, 1, back, a_event, key_down, a_event);
+          ++back;
+        }
+
+        for (int j = 0; j < 99; ++j) {
+          expect(event_queue.get_front_event().get_event_time_stamp().get_time_stamp() == krbn::absolute_time_point(front));
+          event_queue.erase_front_event();
+          ++front;
+        }
+
+        expect(event_queue.get_entries().size() == static_cast<size_t>(back - front));
+      }
+
+      int expected_time_stamp = front;
+      for (const auto& e : event_queue.get_entries()) {
+        expect(e.get_event_time_stamp().get_time_stamp() == krbn::absolute_time_point(expected_time_stamp));
+        ++expected_time_stamp;
+      }
+      expect(expected_time_stamp == back);
+
+      while (!event_queue.empty()) {
+        event_queue.erase_front_event();
+      }
+      expect(event_queue.get_time_stamp_delay() == krbn::absolute_time_duration(0));
+    }
+  };
+
+  "coalesce_pointing_motions"_test = [] {
+    auto motion = [](int x, int y, int vertical_wheel, int horizontal_wheel) {
+      return krbn::event_queue::event(krbn::pointing_motion(x, y, vertical_wheel, horizontal_wheel));
+    };
+
+    auto make_totals = [](const krbn::event_queue::queue& event_queue, krbn::device_id device_id) {
+      krbn::pointing_motion totals;
+      for (const auto& e : event_queue.get_entries()) {
+        if (e.get_device_id() == device_id) {
+          if (auto m = e.get_event().get_pointing_motion()) {
+            totals.set_x(totals.get_x() + m->get_x());
+            totals.set_y(totals.get_y() + m->get_y());
+            totals.set_vertical_wheel(totals.get_vertical_wheel() + m->get_vertical_wheel());
+            totals.set_horizontal_wheel(totals.get_horizontal_wheel() + m->get_horizontal_wheel());
+          }
+        }
+      }
+      return totals;
+    };
+
+    krbn::event_queue::queue event_queue;
+
+    // Move the head of the ring buffer.
+    ENQUEUE_EVENT(event_queue, 1, 0, a_event, key_down, a_event);
+    event_queue.erase_front_event();
+
+    for (int i = 0; i < 10; ++i) {
+      auto e = motion(1, 2, 0, 0);
+      ENQUEUE_EVENT(event_queue, 1, 100 + i, e, single, e);
+      if (i == 4) {
+        // Another device
+        auto e2 = motion(3, 0, 0, 0);
+        ENQUEUE_EVENT(event_queue, 2, 100 + i, e2, single, e2);
+      }
+    }
+
+    ENQUEUE_EVENT(event_queue, 1, 200, a_event, key_down, a_event);
+
+    // Large values are not merged.
+    for (int i = 0; i < 5; ++i) {
+      auto e = motion(100, 0, 0, 0);
+      ENQUEUE_EVENT(event_queue, 1, 300 + i, e, single, e);
+    }
+
+    ENQUEUE_EVENT(event_queue, 1, 400, button2_event, key_down, button2_event);
+
+    for (int i = 0; i < 3; ++i) {
+      auto e = motion(0, 0, 1, -1);
+      ENQUEUE_EVENT(event_queue, 1, 500 + i, e, single, e);
+    }
+
+    auto totals1 = make_totals(event_queue, krbn::device_id(1));
+    auto totals2 = make_totals(event_queue, krbn::device_id(2));
+
+    expect(event_queue.get_entries().size() == 21_ul);
+    expect(event_queue.coalesce_pointing_motions() == 11_ul);
+    expect(event_queue.get_entries().size() == 10_ul);
+
+    expect(make_totals(event_queue, krbn::device_id(1)) == totals1);
+    expect(make_totals(event_queue, krbn::device_id(2)) == totals2);
+
+    std::vector<krbn::event_queue::entry> expected;
+    PUSH_BACK_ENTRY(expected, 1, 100, motion(10, 20, 0, 0), single, motion(10, 20, 0, 0));
+    PUSH_BACK_ENTRY(expected, 2, 104, motion(3, 0, 0, 0), single, motion(3, 0, 0, 0));
+    PUSH_BACK_ENTRY(expected, 1, 200, a_event, key_down, a_event);
+    for (int i = 0; i < 5; ++i) {
+      PUSH_BACK_ENTRY(expected, 1, 300 + i, motion(100, 0, 0, 0), single, motion(100, 0, 0, 0));
+    }
+    PUSH_BACK_ENTRY(expected, 1, 400, button2_event, key_down, button2_event);
+    PUSH_BACK_ENTRY(expected, 1, 500, motion(0, 0, 3, -3), single, motion(0, 0, 3, -3));
+    expect(event_queue.get_entries() == expected);
+
+    // Nothing is merged twice.
+
+    expect(event_queue.coalesce_pointing_motions() == 0_ul);
+    expect(event_queue.get_entries() == expected);
+
+    // The queue works after coalescing.
+
+    ENQUEUE_EVENT(event_queue, 1, 600, left_shift_event, key_down, left_shift_event);
+    ENQUEUE_EVENT(event_queue, 1, 600, left_shift_event, key_up, left_shift_event);
+    event_queue.sort_events();
+    expect(event_queue.get_entries().size() == 12_ul);
+
+    while (!event_queue.empty()) {
+      event_queue.erase_front_event();
+    }
+  };
+
   "hash"_test = [] {
     using event = krbn::event_queue::event;
     expect(std::hash<event>{}(a_event) !=
@@ -531,4 +531,116 @@ void run_event_queue_utility_test(void) {
       expect(pressed_keys_manager->empty());
     }
   };
+
+  "utility::update_pressed_keys_manager"_test = [] {
+    krbn::event_queue::event a_event(
+        krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                     pqrs::hid::usage::keyboard_or_keypad::keyboard_a));
+    krbn::event_queue::event b_event(
+        krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                     pqrs::hid::usage::keyboard_or_keypad::keyboard_b));
+
+    auto entries = std::make_shared<std::vector<krbn::event_queue::not_null_const_entry_ptr_t>>();
+    krbn::pressed_keys_manager pressed_keys_manager;
+
+    PUSH_BACK_ENTRY_PTR((*entries), 1, 100, a_event, key_down, a_event);
+    PUSH_BACK_ENTRY_PTR((*entries), 1, 200, b_event, key_down, b_event);
+    PUSH_BACK_ENTRY_PTR((*entries), 2, 300, b_event, key_up, b_event);
+    PUSH_BACK_ENTRY_PTR((*entries), 1, 400, a_event, key_up, a_event);
+
+    krbn::event_queue::utility::update_pressed_keys_manager(entries,
+                                                            krbn::device_id(1),
+                                                            pressed_keys_manager);
+
+    expect(entries->size() == 4_ul);
+    expect(!pressed_keys_manager.empty());
+
+    entries->clear();
+    PUSH_BACK_ENTRY_PTR((*entries), 1, 500, b_event, key_up, b_event);
+
+    krbn::event_queue::utility::update_pressed_keys_manager(entries,
+                                                            krbn::device_id(1),
+                                                            pressed_keys_manager);
+
+    expect(entries->size() == 1_ul);
+    expect(pressed_keys_manager.empty());
+  };
+
+  "utility::make_entries (entries_pool)"_test = [] {
+    std::vector<pqrs::osx::iokit_hid_value> hid_values;
+
+    hid_values.emplace_back(pqrs::osx::iokit_hid_value(krbn::absolute_time_point(1000),
+                                                       1,
+                                                       pqrs::hid::usage_page::keyboard_or_keypad,
+                                                       pqrs::hid::usage::keyboard_or_keypad::keyboard_a,
+                                                       std::nullopt, // logical_max
+                                                       std::nullopt  // logical_min
+                                                       ));
+    hid_values.emplace_back(pqrs::osx::iokit_hid_value(krbn::absolute_time_point(2000),
+                                                       0,
+                                                       pqrs::hid::usage_page::keyboard_or_keypad,
+                                                       pqrs::hid::usage::keyboard_or_keypad::keyboard_a,
+                                                       std::nullopt, // logical_max
+                                                       std::nullopt  // logical_min
+                                                       ));
+    hid_values.emplace_back(pqrs::osx::iokit_hid_value(krbn::absolute_time_point(3000),
+                                                       10,
+                                                       pqrs::hid::usage_page::generic_desktop,
+                                                       pqrs::hid::usage::generic_desktop::x,
+                                                       std::nullopt, // logical_max
+                                                       std::nullopt  // logical_min
+                                                       ));
+
+    auto device_properties = krbn::device_properties::make_device_properties(krbn::device_id(1),
+                                                                             nullptr);
+    auto pressed_keys_manager = std::make_shared<krbn::pressed_keys_manager>();
+    krbn::event_queue::entries_pool pool;
+
+    for (int i = 0; i < 1000; ++i) {
+      auto entries = krbn::event_queue::utility::make_entries(pool,
+                                                              device_properties,
+                                                              hid_values,
+                                                              {});
+      auto result = krbn::event_queue::utility::insert_device_keys_and_pointing_buttons_are_released_event(pool,
+                                                                                                           entries,
+                                                                                                           krbn::device_id(1),
+                                                                                                           pressed_keys_manager);
+
+      expect(entries->size() == 3_ul);
+
+      expect(result->size() == 4_ul);
+      expect((*result)[0]->get_event_type() == krbn::event_type::key_down);
+      expect((*result)[0]->get_event_time_stamp().get_time_stamp() == krbn::absolute_time_point(1000));
+      expect((*result)[1]->get_event_type() == krbn::event_type::key_up);
+      expect((*result)[2]->get_event().get_type() == krbn::event_queue::event::type::device_keys_and_pointing_buttons_are_released);
+      expect((*result)[3]->get_event().get_type() == krbn::event_queue::event::type::pointing_motion);
+    }
+
+    // Objects are allocated only in the first iteration.
+    expect(pool.get_entries_allocation_count() == 2_ul);
+    expect(pool.get_entries_reuse_count() == 1998_ul);
+    expect(pool.get_entry_allocation_count() == 4_ul);
+    expect(pool.get_entry_reuse_count() == 3996_ul);
+
+    {
+      // Objects which are still referenced are not reused.
+
+      auto entries1 = krbn::event_queue::utility::make_entries(pool,
+                                                               device_properties,
+                                                               hid_values,
+                                                               {});
+      auto entries2 = krbn::event_queue::utility::make_entries(pool,
+                                                               device_properties,
+                                                               hid_values,
+                                                               {});
+
+      expect(entries1.get() != entries2.get());
+      expect((*entries1)[0].get() != (*entries2)[0].get());
+      expect((*entries1)[0]->get_event_time_stamp().get_time_stamp() == krbn::absolute_time_point(1000));
+      expect((*entries2)[0]->get_event_time_stamp().get_time_stamp() == krbn::absolute_time_point(1000));
+
+      expect(pool.get_entries_allocation_count() == 2_ul);
+      expect(pool.get_entry_allocation_count() == 6_ul);
+    }
+  };
 }
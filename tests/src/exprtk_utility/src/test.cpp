@@ -113,5 +113,38 @@ sin(radian) * m;
     expect(6.28_d == expression->value());
   };
 
+  "get_variable_names"_test = [] {
+    auto expression = krbn::exprtk_utility::compile("var m := 3; pi * m * x + y + x");
+    expect(std::vector<std::string>{"x", "y"} == expression->get_variable_names());
+  };
+
+  "shared_variables"_test = [] {
+    auto shared_variables = std::make_shared<krbn::exprtk_utility::shared_variables>();
+    auto expression1 = krbn::exprtk_utility::compile("x * 2", shared_variables);
+    auto expression2 = krbn::exprtk_utility::compile("if (example_string like 'h*') { x; } else { -x; }", shared_variables);
+
+    expect(0.0_d == expression1->value());
+    expect(-0.0_d == expression2->value());
+
+    // A single write is observed by all expressions.
+    expect(true == shared_variables->set_variable("x", 21.0));
+    expect(42.0_d == expression1->value());
+    expect(-21.0_d == expression2->value());
+
+    expect(true == shared_variables->set_variable("example_string", "hello"));
+    expect(21.0_d == expression2->value());
+
+    // The same value
+    expect(false == shared_variables->set_variable("x", 21.0));
+
+    // A new expression observes the current value.
+    auto expression3 = krbn::exprtk_utility::compile("x + 1", shared_variables);
+    expect(22.0_d == expression3->value());
+
+    // Expressions without shared_variables are independent.
+    auto expression4 = krbn::exprtk_utility::compile("x + 1");
+    expect(1.0_d == expression4->value());
+  };
+
   return 0;
 }
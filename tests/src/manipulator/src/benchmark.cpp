@@ -0,0 +1,211 @@
+#include "../../share/benchmark_helper.hpp"
+#include "dispatcher_utility.hpp"
+#include "manipulator/condition_factory.hpp"
+#include "manipulator/manipulator_manager.hpp"
+#include "manipulator/manipulator_managers_connector.hpp"
+
+namespace {
+const std::vector<std::string> key_codes{
+    "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m",
+    "n", "o", "p", "q", "r", "s", "t", "u", "v", "w", "x", "y", "z",
+    "1", "2", "3", "4", "5", "6", "7", "8", "9", "0",
+    "f1", "f2", "f3", "f4", "f5", "f6", "f7", "f8", "f9", "f10", "f11", "f12"};
+
+std::shared_ptr<krbn::manipulator::manipulator_manager> make_manipulator_manager(size_t size) {
+  auto manipulator_manager = std::make_shared<krbn::manipulator::manipulator_manager>();
+  auto parameters = std::make_shared<krbn::core_configuration::details::complex_modifications_parameters>();
+
+  for (size_t i = 0; i < size; ++i) {
+    auto json = nlohmann::json::object({
+        {"type", "basic"},
+        {"from", nlohmann::json::object({
+                     {"key_code", key_codes[i % key_codes.size()]},
+                     {"modifiers", nlohmann::json::object({
+                                       {"optional", nlohmann::json::array({"any"})},
+                                   })},
+                 })},
+        {"to", nlohmann::json::array({
+                   nlohmann::json::object({{"key_code", "escape"}}),
+               })},
+    });
+
+    auto m = krbn::manipulator::manipulator_factory::make_manipulator(json,
+                                                                      parameters);
+    // Never fulfilled in order to measure the dispatch cost.
+    m->push_back_condition(krbn::manipulator::condition_factory::make_condition(nlohmann::json::object({
+        {"type", "variable_if"},
+        {"name", fmt::format("benchmark_variable_{0}", i)},
+        {"value", 1},
+    })));
+
+    manipulator_manager->push_back_manipulator(m);
+  }
+
+  return manipulator_manager;
+}
+
+// Layer-style profile: each layer has a manipulator for each key, and they are enabled by `layer == n`.
+std::shared_ptr<krbn::manipulator::manipulator_manager> make_layered_manipulator_manager(size_t layers) {
+  auto manipulator_manager = std::make_shared<krbn::manipulator::manipulator_manager>();
+  auto parameters = std::make_shared<krbn::core_configuration::details::complex_modifications_parameters>();
+
+  for (size_t layer = 1; layer <= layers; ++layer) {
+    for (const auto& key_code : key_codes) {
+      manipulator_manager->push_back_manipulator(nlohmann::json::object({
+                                                     {"type", "basic"},
+                                                     {"from", nlohmann::json::object({
+                                                                  {"key_code", key_code},
+                                                                  {"modifiers", nlohmann::json::object({
+                                                                                    {"optional", nlohmann::json::array({"any"})},
+                                                                                })},
+                                                              })},
+                                                     {"to", nlohmann::json::array({
+                                                                nlohmann::json::object({{"key_code", "escape"}}),
+                                                            })},
+                                                     {"conditions", nlohmann::json::array({
+                                                                        nlohmann::json::object({
+                                                                            {"type", "variable_if"},
+                                                                            {"name", "layer"},
+                                                                            {"value", layer},
+                                                                        }),
+                                                                    })},
+                                                 }),
+                                                 parameters);
+    }
+  }
+
+  return manipulator_manager;
+}
+
+std::chrono::nanoseconds measure(krbn::manipulator::manipulator_manager& manipulator_manager,
+                                 const krbn::momentary_switch_event& momentary_switch_event,
+                                 int layer = 0) {
+  auto core_configuration = std::make_shared<krbn::core_configuration::core_configuration>();
+  auto input_event_queue = std::make_shared<krbn::event_queue::queue>();
+  auto output_event_queue = std::make_shared<krbn::event_queue::queue>();
+  output_event_queue->get_manipulator_environment().set_variable("layer",
+                                                                 krbn::manipulator_environment_variable_value(layer));
+  auto event_type = krbn::event_type::key_up;
+  uint64_t time_stamp = 0;
+
+  return krbn::unit_testing::benchmark_helper::measure(10000, [&] {
+    event_type = (event_type == krbn::event_type::key_down ? krbn::event_type::key_up
+                                                           : krbn::event_type::key_down);
+    time_stamp += 1000;
+
+    input_event_queue->emplace_back_entry(krbn::device_id(1),
+                                          krbn::event_queue::event_time_stamp(krbn::absolute_time_point(time_stamp)),
+                                          krbn::event_queue::event(momentary_switch_event),
+                                          event_type,
+                                          krbn::event_queue::event(momentary_switch_event),
+                                          krbn::event_queue::state::original);
+
+    manipulator_manager.manipulate(input_event_queue,
+                                   output_event_queue,
+                                   krbn::absolute_time_point(time_stamp),
+                                   core_configuration);
+
+    output_event_queue->clear_events();
+  });
+}
+
+// Measure the per-event cost of the whole pipeline.
+// (simple_modifications -> complex_modifications -> fn_function_keys -> post_event_to_virtual_devices in the grabber.)
+std::chrono::nanoseconds measure_pipeline(const std::vector<std::shared_ptr<krbn::manipulator::manipulator_manager>>& manipulator_managers,
+                                          const krbn::momentary_switch_event& momentary_switch_event) {
+  auto core_configuration = std::make_shared<krbn::core_configuration::core_configuration>();
+
+  std::vector<std::shared_ptr<krbn::event_queue::queue>> event_queues;
+  for (size_t i = 0; i < manipulator_managers.size() + 1; ++i) {
+    event_queues.push_back(std::make_shared<krbn::event_queue::queue>());
+  }
+
+  krbn::manipulator::manipulator_managers_connector connector;
+  for (size_t i = 0; i < manipulator_managers.size(); ++i) {
+    connector.emplace_back_connection(manipulator_managers[i],
+                                      event_queues[i],
+                                      event_queues[i + 1]);
+  }
+
+  auto event_type = krbn::event_type::key_up;
+  uint64_t time_stamp = 0;
+
+  return krbn::unit_testing::benchmark_helper::measure(10000, [&] {
+    event_type = (event_type == krbn::event_type::key_down ? krbn::event_type::key_up
+                                                           : krbn::event_type::key_down);
+    time_stamp += 1000;
+
+    event_queues.front()->emplace_back_entry(krbn::device_id(1),
+                                             krbn::event_queue::event_time_stamp(krbn::absolute_time_point(time_stamp)),
+                                             krbn::event_queue::event(momentary_switch_event),
+                                             event_type,
+                                             krbn::event_queue::event(momentary_switch_event),
+                                             krbn::event_queue::state::original);
+
+    connector.manipulate(krbn::absolute_time_point(time_stamp),
+                         core_configuration);
+
+    event_queues.back()->clear_events();
+  });
+}
+} // namespace
+
+int main(void) {
+  auto scoped_dispatcher_manager = krbn::dispatcher_utility::initialize_dispatchers();
+
+  // Per-event cost of `manipulator_manager::manipulate`.
+  // Each rule count is measured with a key which some manipulators handle, and a key which no manipulators handle.
+
+  krbn::momentary_switch_event target(pqrs::hid::usage_page::keyboard_or_keypad,
+                                      pqrs::hid::usage::keyboard_or_keypad::keyboard_a);
+  krbn::momentary_switch_event non_target(pqrs::hid::usage_page::keyboard_or_keypad,
+                                          pqrs::hid::usage::keyboard_or_keypad::keyboard_spacebar);
+
+  for (const auto& size : {10, 100, 1000, 10000}) {
+    auto manipulator_manager = make_manipulator_manager(size);
+
+    krbn::unit_testing::benchmark_helper::print(fmt::format("manipulator_manager::manipulate (rules: {0}, target)", size),
+                                                measure(*manipulator_manager, target));
+    krbn::unit_testing::benchmark_helper::print(fmt::format("manipulator_manager::manipulate (rules: {0}, non-target)", size),
+                                                measure(*manipulator_manager, non_target));
+  }
+
+  // Per-event cost of layer-style profiles.
+  // Manipulators of inactive layers are skipped by their `variable_if` gate.
+
+  for (const auto& layers : {1, 8, 32}) {
+    auto manipulator_manager = make_layered_manipulator_manager(layers);
+
+    krbn::unit_testing::benchmark_helper::print(fmt::format("manipulator_manager::manipulate (layers: {0}, all layers off)", layers),
+                                                measure(*manipulator_manager, target, 0));
+    krbn::unit_testing::benchmark_helper::print(fmt::format("manipulator_manager::manipulate (layers: {0}, layer {0} on)", layers),
+                                                measure(*manipulator_manager, target, layers));
+  }
+
+  // Per-event cost of `manipulator_managers_connector::manipulate` with 4 stages.
+  // Empty stages pass through events without `manipulator_manager::manipulate`.
+
+  {
+    std::vector<std::shared_ptr<krbn::manipulator::manipulator_manager>> manipulator_managers;
+    for (int i = 0; i < 4; ++i) {
+      manipulator_managers.push_back(make_manipulator_manager(0));
+    }
+
+    krbn::unit_testing::benchmark_helper::print("manipulator_managers_connector::manipulate (stages: 4, empty)",
+                                                measure_pipeline(manipulator_managers, target));
+  }
+
+  for (const auto& size : {10, 100}) {
+    std::vector<std::shared_ptr<krbn::manipulator::manipulator_manager>> manipulator_managers;
+    for (int i = 0; i < 4; ++i) {
+      manipulator_managers.push_back(make_manipulator_manager(size));
+    }
+
+    krbn::unit_testing::benchmark_helper::print(fmt::format("manipulator_managers_connector::manipulate (stages: 4, rules: {0}, target)", size),
+                                                measure_pipeline(manipulator_managers, target));
+    krbn::unit_testing::benchmark_helper::print(fmt::format("manipulator_managers_connector::manipulate (stages: 4, rules: {0}, non-target)", size),
+                                                measure_pipeline(manipulator_managers, non_target));
+  }
+
+  return 0;
+}
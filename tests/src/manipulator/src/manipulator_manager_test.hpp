@@ -1,5 +1,6 @@
 #include "../../share/json_helper.hpp"
 #include "../../share/manipulator_helper.hpp"
+#include "manipulator/manipulator_cache.hpp"
 #include <boost/ut.hpp>
 
 void run_manipulator_manager_test(void) {
@@ -88,6 +89,265 @@ void run_manipulator_manager_test(void) {
     manipulator_managers.clear();
   };
 
+  "manipulator_managers_connector.pass_through"_test = [] {
+    auto core_configuration = std::make_shared<krbn::core_configuration::core_configuration>();
+
+    std::vector<std::shared_ptr<krbn::event_queue::queue>> event_queues;
+    for (int i = 0; i < 4; ++i) {
+      event_queues.push_back(std::make_shared<krbn::event_queue::queue>());
+    }
+
+    // empty -> a to b -> empty
+
+    std::vector<std::shared_ptr<krbn::manipulator::manipulator_manager>> manipulator_managers;
+    for (size_t i = 0; i < event_queues.size() - 1; ++i) {
+      manipulator_managers.push_back(std::make_shared<krbn::manipulator::manipulator_manager>());
+    }
+
+    manipulator_managers[1]->push_back_manipulator(nlohmann::json::object({
+                                                       {"type", "basic"},
+                                                       {"from", nlohmann::json::object({
+                                                                    {"key_code", "a"},
+                                                                    {"modifiers", nlohmann::json::object({{"optional", nlohmann::json::array({"any"})}})},
+                                                                })},
+                                                       {"to", nlohmann::json::object({{"key_code", "b"}})},
+                                                   }),
+                                                   std::make_shared<krbn::core_configuration::details::complex_modifications_parameters>());
+
+    krbn::manipulator::manipulator_managers_connector connector;
+    for (size_t i = 0; i < manipulator_managers.size(); ++i) {
+      connector.emplace_back_connection(manipulator_managers[i],
+                                        event_queues[i],
+                                        event_queues[i + 1]);
+    }
+
+    auto a = krbn::event_queue::event(krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                                   pqrs::hid::usage::keyboard_or_keypad::keyboard_a));
+    auto b = krbn::event_queue::event(krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                                   pqrs::hid::usage::keyboard_or_keypad::keyboard_b));
+    auto left_shift = krbn::event_queue::event(krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                                            pqrs::hid::usage::keyboard_or_keypad::keyboard_left_shift));
+    auto released_event = krbn::event_queue::event::make_device_keys_and_pointing_buttons_are_released_event();
+
+    // Events which have the same time stamp are reordered even if the first stage is passed through.
+
+    auto t = krbn::absolute_time_point(1000);
+    event_queues[0]->emplace_back_entry(krbn::device_id(1),
+                                        krbn::event_queue::event_time_stamp(t),
+                                        a,
+                                        krbn::event_type::key_down,
+                                        a,
+                                        krbn::event_queue::state::original);
+    event_queues[0]->emplace_back_entry(krbn::device_id(1),
+                                        krbn::event_queue::event_time_stamp(t),
+                                        left_shift,
+                                        krbn::event_type::key_down,
+                                        left_shift,
+                                        krbn::event_queue::state::original);
+
+    connector.manipulate(t, core_configuration);
+
+    expect(event_queues[0]->empty());
+    expect(event_queues[1]->empty());
+    expect(event_queues[2]->empty());
+    expect(event_queues[3]->get_entries().size() == 2_ul);
+    expect(event_queues[3]->get_entries()[0].get_event() == left_shift);
+    expect(event_queues[3]->get_entries()[1].get_event() == b);
+
+    // Passed through queues keep the modifier flags.
+
+    expect(event_queues[1]->get_modifier_flag_manager().is_pressed(krbn::modifier_flag::left_shift));
+    expect(event_queues[3]->get_modifier_flag_manager().is_pressed(krbn::modifier_flag::left_shift));
+
+    // device_keys_and_pointing_buttons_are_released resets the modifier flags of passed through queues.
+
+    t += pqrs::osx::chrono::make_absolute_time_duration(std::chrono::milliseconds(1));
+    event_queues[0]->emplace_back_entry(krbn::device_id(1),
+                                        krbn::event_queue::event_time_stamp(t),
+                                        released_event,
+                                        krbn::event_type::single,
+                                        released_event,
+                                        krbn::event_queue::state::virtual_event);
+
+    connector.manipulate(t, core_configuration);
+
+    expect(event_queues[3]->get_entries().size() == 3_ul);
+    expect(!event_queues[1]->get_modifier_flag_manager().is_pressed(krbn::modifier_flag::left_shift));
+    expect(!event_queues[3]->get_modifier_flag_manager().is_pressed(krbn::modifier_flag::left_shift));
+
+    manipulator_managers.clear();
+  };
+
+  "manipulator_manager.pass_through"_test = [] {
+    auto core_configuration = std::make_shared<krbn::core_configuration::core_configuration>();
+    auto manager = std::make_shared<krbn::manipulator::manipulator_manager>();
+    manager->push_back_manipulator(nlohmann::json::object({
+                                       {"type", "basic"},
+                                       {"from", nlohmann::json::object({{"key_code", "a"}})},
+                                       {"to", nlohmann::json::object({{"key_code", "b"}})},
+                                   }),
+                                   std::make_shared<krbn::core_configuration::details::complex_modifications_parameters>());
+
+    auto input_event_queue = std::make_shared<krbn::event_queue::queue>();
+    auto output_event_queue = std::make_shared<krbn::event_queue::queue>();
+
+    auto a = krbn::event_queue::event(krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                                   pqrs::hid::usage::keyboard_or_keypad::keyboard_a));
+    auto c = krbn::event_queue::event(krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                                   pqrs::hid::usage::keyboard_or_keypad::keyboard_c));
+    auto released_event = krbn::event_queue::event::make_device_keys_and_pointing_buttons_are_released_event();
+
+    auto t = krbn::absolute_time_point(1000);
+    for (const auto& e : {c, c, a, c, released_event}) {
+      input_event_queue->emplace_back_entry(krbn::device_id(1),
+                                            krbn::event_queue::event_time_stamp(t),
+                                            e,
+                                            krbn::event_type::key_down,
+                                            e,
+                                            krbn::event_queue::state::original);
+    }
+
+    // Events which no manipulator handles are moved until `a`.
+
+    manager->pass_through(input_event_queue, output_event_queue, core_configuration);
+
+    expect(input_event_queue->get_entries().size() == 3_ul);
+    expect(input_event_queue->get_front_event().get_event() == a);
+    expect(output_event_queue->get_entries().size() == 2_ul);
+
+    manager->pass_through(input_event_queue, output_event_queue, core_configuration);
+
+    expect(input_event_queue->get_entries().size() == 3_ul);
+
+    // The active manipulator needs non-target events after `a` is manipulated.
+
+    manager->manipulate(input_event_queue, output_event_queue, t, core_configuration);
+    manager->pass_through(input_event_queue, output_event_queue, core_configuration);
+
+    expect(input_event_queue->get_entries().size() == 2_ul);
+    expect(input_event_queue->get_front_event().get_event() == c);
+    expect(output_event_queue->get_entries().size() == 3_ul);
+    expect(output_event_queue->get_entries()[2].get_event() == krbn::event_queue::event(krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                                                                                     pqrs::hid::usage::keyboard_or_keypad::keyboard_b)));
+
+    // device_keys_and_pointing_buttons_are_released is handled by all manipulators.
+
+    manager->manipulate(input_event_queue, output_event_queue, t, core_configuration);
+    manager->pass_through(input_event_queue, output_event_queue, core_configuration);
+
+    expect(input_event_queue->get_entries().size() == 1_ul);
+    expect(input_event_queue->get_front_event().get_event() == released_event);
+  };
+
+  "manipulator_manager.variable_gates"_test = [] {
+    auto core_configuration = std::make_shared<krbn::core_configuration::core_configuration>();
+    auto parameters = std::make_shared<krbn::core_configuration::details::complex_modifications_parameters>();
+    auto manager = std::make_shared<krbn::manipulator::manipulator_manager>();
+
+    // Conditions are attached before `push_back_manipulator` in the same way as complex_modifications_manipulator_manager.
+    auto push_back_manipulator = [&](const nlohmann::json& json) {
+      auto m = krbn::manipulator::manipulator_factory::make_manipulator(json,
+                                                                        parameters);
+      for (const auto& c : json["conditions"]) {
+        m->push_back_condition(krbn::manipulator::condition_factory::make_condition(c));
+      }
+      manager->push_back_manipulator(m);
+    };
+
+    // layer 1: a -> b
+    // layer 2: a -> c
+    // no layer: a -> d (gated by variable_unless, which is not used as a gate)
+
+    for (const auto& [layer, to] : std::vector<std::pair<int, std::string>>{{1, "b"}, {2, "c"}}) {
+      push_back_manipulator(nlohmann::json::object({
+          {"type", "basic"},
+          {"from", nlohmann::json::object({{"key_code", "a"}})},
+          {"to", nlohmann::json::object({{"key_code", to}})},
+          {"conditions", nlohmann::json::array({
+                             nlohmann::json::object({
+                                 {"type", "variable_if"},
+                                 {"name", "layer"},
+                                 {"value", layer},
+                             }),
+                         })},
+      }));
+    }
+    push_back_manipulator(nlohmann::json::object({
+        {"type", "basic"},
+        {"from", nlohmann::json::object({{"key_code", "a"}})},
+        {"to", nlohmann::json::object({{"key_code", "d"}})},
+        {"conditions", nlohmann::json::array({
+                           nlohmann::json::object({
+                               {"type", "variable_unless"},
+                               {"name", "layer"},
+                               {"value", 2},
+                           }),
+                       })},
+    }));
+
+    auto input_event_queue = std::make_shared<krbn::event_queue::queue>();
+    auto output_event_queue = std::make_shared<krbn::event_queue::queue>();
+
+    auto make_event = [](pqrs::hid::usage::value_t usage) {
+      return krbn::event_queue::event(krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                                   usage));
+    };
+    auto a = make_event(pqrs::hid::usage::keyboard_or_keypad::keyboard_a);
+
+    uint64_t time_stamp = 0;
+    auto push_back = [&](krbn::event_type event_type) {
+      time_stamp += 1000;
+      input_event_queue->emplace_back_entry(krbn::device_id(1),
+                                            krbn::event_queue::event_time_stamp(krbn::absolute_time_point(time_stamp)),
+                                            a,
+                                            event_type,
+                                            a,
+                                            krbn::event_queue::state::original);
+      while (manager->manipulate(input_event_queue,
+                                 output_event_queue,
+                                 krbn::absolute_time_point(time_stamp),
+                                 core_configuration)) {
+      }
+
+      auto e = output_event_queue->get_entries().back().get_event();
+      output_event_queue->clear_events();
+      return e;
+    };
+    auto set_layer = [&](int value) {
+      output_event_queue->get_manipulator_environment().set_variable("layer",
+                                                                     krbn::manipulator_environment_variable_value(value));
+    };
+
+    // No layer
+
+    expect(push_back(krbn::event_type::key_down) == make_event(pqrs::hid::usage::keyboard_or_keypad::keyboard_d));
+    expect(push_back(krbn::event_type::key_up) == make_event(pqrs::hid::usage::keyboard_or_keypad::keyboard_d));
+
+    // layer 1
+
+    set_layer(1);
+    expect(push_back(krbn::event_type::key_down) == make_event(pqrs::hid::usage::keyboard_or_keypad::keyboard_b));
+    expect(push_back(krbn::event_type::key_up) == make_event(pqrs::hid::usage::keyboard_or_keypad::keyboard_b));
+
+    // layer 2
+
+    set_layer(2);
+    expect(push_back(krbn::event_type::key_down) == make_event(pqrs::hid::usage::keyboard_or_keypad::keyboard_c));
+
+    // Pressed keys are released by the same manipulator even if the layer is changed.
+
+    set_layer(0);
+    expect(push_back(krbn::event_type::key_up) == make_event(pqrs::hid::usage::keyboard_or_keypad::keyboard_c));
+
+    // Gates are evaluated again after the variable is changed.
+
+    set_layer(1);
+    expect(push_back(krbn::event_type::key_down) == make_event(pqrs::hid::usage::keyboard_or_keypad::keyboard_b));
+    expect(push_back(krbn::event_type::key_up) == make_event(pqrs::hid::usage::keyboard_or_keypad::keyboard_b));
+
+    manager = nullptr;
+  };
+
   "needs_virtual_hid_pointing"_test = [] {
     for (const auto& file_name : {
              std::string("json/needs_virtual_hid_pointing_test1.json"),
@@ -118,4 +378,218 @@ void run_manipulator_manager_test(void) {
       manager = nullptr;
     }
   };
+
+  "manipulator_manager.replace_manipulators"_test = [] {
+    auto make_manipulators = [](const std::string& file_name) {
+      std::vector<gsl::not_null<std::shared_ptr<krbn::manipulator::manipulators::base>>> manipulators;
+      for (const auto& j : krbn::unit_testing::json_helper::load_jsonc(file_name)) {
+        auto parameters = std::make_shared<krbn::core_configuration::details::complex_modifications_parameters>();
+        manipulators.push_back(krbn::manipulator::manipulator_factory::make_manipulator(j,
+                                                                                        parameters));
+      }
+      return manipulators;
+    };
+
+    auto manager = std::make_shared<krbn::manipulator::manipulator_manager>();
+
+    auto manipulators1 = make_manipulators("json/needs_virtual_hid_pointing_test1.json");
+    manager->replace_manipulators(manipulators1);
+    expect(manager->get_manipulators_size() == manipulators1.size());
+    expect(!manager->needs_virtual_hid_pointing());
+
+    // Inactive manipulators are removed.
+
+    auto manipulators2 = make_manipulators("json/needs_virtual_hid_pointing_test2.json");
+    manager->replace_manipulators(manipulators2);
+    expect(manager->get_manipulators_size() == manipulators2.size());
+    expect(manager->needs_virtual_hid_pointing());
+    for (const auto& m : manipulators1) {
+      expect(m->get_validity() == krbn::validity::invalid);
+    }
+
+    manager->replace_manipulators({});
+    expect(manager->get_manipulators_size() == 0);
+
+    manager = nullptr;
+  };
+
+  "manipulator_manager.from_event_index"_test = [] {
+    using from_event = krbn::manipulator::manipulators::basic::manipulated_original_event::from_event;
+
+    auto a = krbn::event_queue::event(krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                                   pqrs::hid::usage::keyboard_or_keypad::keyboard_a));
+    auto s = krbn::event_queue::event(krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                                   pqrs::hid::usage::keyboard_or_keypad::keyboard_s));
+    auto tab = krbn::event_queue::event(krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                                     pqrs::hid::usage::keyboard_or_keypad::keyboard_tab));
+
+    // The same from_event might be held by multiple manipulators.
+
+    {
+      krbn::manipulator::manipulators::basic::manipulated_original_event::from_event_index index;
+      from_event fe(krbn::device_id(1), a, a);
+
+      index.insert(fe);
+      index.insert(fe);
+      expect(index.contains(fe));
+      expect(index.size() == 1);
+
+      index.erase(fe);
+      expect(index.contains(fe));
+
+      index.erase(fe);
+      expect(!index.contains(fe));
+      expect(index.size() == 0);
+
+      // Erasing a missing from_event is ignored.
+      index.erase(fe);
+      expect(index.size() == 0);
+    }
+
+    // Key down events held by `simultaneous` are skipped by one lookup.
+
+    {
+      auto core_configuration = std::make_shared<krbn::core_configuration::core_configuration>();
+      auto input_event_queue = std::make_shared<krbn::event_queue::queue>();
+      auto output_event_queue = std::make_shared<krbn::event_queue::queue>();
+
+      auto manager = std::make_shared<krbn::manipulator::manipulator_manager>();
+      manager->push_back_manipulator(nlohmann::json::object({
+                                         {"type", "basic"},
+                                         {"from", nlohmann::json::object({
+                                                      {"simultaneous", nlohmann::json::array({
+                                                                           nlohmann::json::object({{"key_code", "a"}}),
+                                                                           nlohmann::json::object({{"key_code", "s"}}),
+                                                                       })},
+                                                  })},
+                                         {"to", nlohmann::json::object({{"key_code", "tab"}})},
+                                     }),
+                                     std::make_shared<krbn::core_configuration::details::complex_modifications_parameters>());
+
+      auto emplace_back = [&](krbn::absolute_time_point t,
+                              const krbn::event_queue::event& e,
+                              krbn::event_type event_type) {
+        input_event_queue->emplace_back_entry(krbn::device_id(1),
+                                              krbn::event_queue::event_time_stamp(t),
+                                              e,
+                                              event_type,
+                                              e,
+                                              krbn::event_queue::state::original);
+      };
+
+      auto manipulate = [&](krbn::absolute_time_point now) {
+        while (manager->manipulate(input_event_queue,
+                                   output_event_queue,
+                                   now,
+                                   core_configuration)) {
+        }
+      };
+
+      auto t = krbn::absolute_time_point(1000);
+      auto now = t + pqrs::osx::chrono::make_absolute_time_duration(std::chrono::seconds(1));
+
+      emplace_back(t, a, krbn::event_type::key_down);
+      emplace_back(t, s, krbn::event_type::key_down);
+      emplace_back(t, a, krbn::event_type::key_up);
+      emplace_back(t, s, krbn::event_type::key_up);
+      manipulate(now);
+
+      expect(input_event_queue->empty());
+      expect(output_event_queue->get_entries().size() == 2_ul);
+      expect(output_event_queue->get_entries()[0].get_event() == tab);
+      expect(output_event_queue->get_entries()[0].get_event_type() == krbn::event_type::key_down);
+      expect(output_event_queue->get_entries()[1].get_event() == tab);
+      expect(output_event_queue->get_entries()[1].get_event_type() == krbn::event_type::key_up);
+
+      // Released from_events are removed from the index.
+
+      t = now;
+      now = t + pqrs::osx::chrono::make_absolute_time_duration(std::chrono::seconds(1));
+
+      emplace_back(t, s, krbn::event_type::key_down);
+      manipulate(now);
+
+      expect(output_event_queue->get_entries().size() == 3_ul);
+      expect(output_event_queue->get_entries()[2].get_event() == s);
+      expect(output_event_queue->get_entries()[2].get_event_type() == krbn::event_type::key_down);
+    }
+  };
+
+  "manipulator_cache"_test = [] {
+    auto make = [](const std::string& file_name) {
+      return [file_name] {
+        krbn::manipulator::manipulator_cache::manipulators_t manipulators;
+        for (const auto& j : krbn::unit_testing::json_helper::load_jsonc(file_name)) {
+          auto parameters = std::make_shared<krbn::core_configuration::details::complex_modifications_parameters>();
+          manipulators.push_back(krbn::manipulator::manipulator_factory::make_manipulator(j,
+                                                                                          parameters));
+        }
+        return manipulators;
+      };
+    };
+
+    krbn::manipulator::manipulator_cache cache;
+    auto manager = std::make_shared<krbn::manipulator::manipulator_manager>();
+
+    // Build all
+
+    cache.begin_update();
+    auto manipulators1 = cache.find_or_make(1, "test1", make("json/needs_virtual_hid_pointing_test1.json"));
+    auto manipulators2 = cache.find_or_make(2, "test2", make("json/needs_virtual_hid_pointing_test2.json"));
+    cache.end_update();
+    expect(cache.get_reused_count() == 0);
+    expect(cache.get_rebuilt_count() == 2);
+
+    {
+      auto manipulators = manipulators1;
+      manipulators.insert(std::end(manipulators), std::begin(manipulators2), std::end(manipulators2));
+      manager->replace_manipulators(manipulators);
+    }
+
+    // Reuse unchanged manipulators
+
+    cache.begin_update();
+    auto manipulators3 = cache.find_or_make(1, "test1", make("json/needs_virtual_hid_pointing_test1.json"));
+    auto manipulators4 = cache.find_or_make(3, "test3", make("json/needs_virtual_hid_pointing_test3.json"));
+    cache.end_update();
+    expect(cache.get_reused_count() == 1);
+    expect(cache.get_rebuilt_count() == 1);
+    expect(manipulators3 == manipulators1);
+
+    {
+      auto manipulators = manipulators3;
+      manipulators.insert(std::end(manipulators), std::begin(manipulators4), std::end(manipulators4));
+      manager->replace_manipulators(manipulators);
+      expect(manager->get_manipulators_size() == manipulators.size());
+    }
+
+    for (const auto& m : manipulators1) {
+      expect(m->get_validity() == krbn::validity::valid);
+    }
+    for (const auto& m : manipulators2) {
+      expect(m->get_validity() == krbn::validity::invalid);
+    }
+
+    // An entry is reused only once in an update.
+
+    cache.begin_update();
+    cache.find_or_make(1, "test1", make("json/needs_virtual_hid_pointing_test1.json"));
+    cache.find_or_make(1, "test1", make("json/needs_virtual_hid_pointing_test1.json"));
+    cache.end_update();
+    expect(cache.get_reused_count() == 1);
+    expect(cache.get_rebuilt_count() == 1);
+
+    // An entry is not reused if only the hash matches.
+
+    cache.begin_update();
+    auto manipulators5 = cache.find_or_make(1, "test1", make("json/needs_virtual_hid_pointing_test1.json"));
+    auto manipulators6 = cache.find_or_make(1, "test3", make("json/needs_virtual_hid_pointing_test3.json"));
+    cache.end_update();
+    expect(cache.get_reused_count() == 1);
+    expect(cache.get_rebuilt_count() == 1);
+    expect(manipulators6 != manipulators5);
+    expect(manipulators6.size() == manipulators4.size());
+
+    manager = nullptr;
+  };
 }
@@ -0,0 +1,395 @@
+#pragma once
+
+#include "../../share/manipulator_conditions_helper.hpp"
+#include "manipulator/condition_expression_manager.hpp"
+#include "manipulator/condition_factory.hpp"
+#include "manipulator/condition_manager.hpp"
+#include <boost/ut.hpp>
+
+void run_condition_manager_test(void) {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "manipulator_environment.generations"_test = [] {
+    using facet = krbn::manipulator::manipulator_environment::facet;
+
+    krbn::manipulator::manipulator_environment environment;
+
+    // variables
+
+    {
+      auto g = environment.get_generation(facet::variables);
+
+      environment.set_variable("v", krbn::manipulator_environment_variable_value(1));
+      expect(environment.get_generation(facet::variables) == g + 1);
+
+      // Setting the same value does not change the generation.
+      environment.set_variable("v", krbn::manipulator_environment_variable_value(1));
+      expect(environment.get_generation(facet::variables) == g + 1);
+
+      environment.set_variable("v", krbn::manipulator_environment_variable_value(2));
+      expect(environment.get_generation(facet::variables) == g + 2);
+
+      environment.unset_variable("v");
+      expect(environment.get_generation(facet::variables) == g + 3);
+
+      environment.unset_variable("v");
+      expect(environment.get_generation(facet::variables) == g + 3);
+    }
+
+    // frontmost_application
+
+    {
+      auto g = environment.get_generation(facet::frontmost_application);
+
+      pqrs::osx::frontmost_application_monitor::application application;
+      application.set_bundle_identifier("com.apple.Terminal");
+
+      environment.set_frontmost_application(application);
+      expect(environment.get_generation(facet::frontmost_application) == g + 1);
+
+      environment.set_frontmost_application(application);
+      expect(environment.get_generation(facet::frontmost_application) == g + 1);
+    }
+
+    // input_source
+
+    {
+      auto g = environment.get_generation(facet::input_source);
+
+      pqrs::osx::input_source::properties properties;
+      properties.set_first_language("en");
+
+      environment.set_input_source_properties(properties);
+      expect(environment.get_generation(facet::input_source) == g + 1);
+
+      environment.set_input_source_properties(properties);
+      expect(environment.get_generation(facet::input_source) == g + 1);
+    }
+
+    // Other facets are not changed.
+
+    expect(environment.get_generation(facet::devices) == 0);
+    expect(environment.get_generation(facet::core_configuration) == 0);
+
+    // instance_id
+
+    {
+      krbn::manipulator::manipulator_environment other;
+      expect(environment.get_instance_id() != other.get_instance_id());
+    }
+  };
+
+  "manipulator_environment.variables (slots)"_test = [] {
+    auto& table = krbn::get_shared_manipulator_environment_variable_name_table();
+
+    auto slot1 = *table.intern("slot_test_variable1");
+    auto slot2 = *table.intern("slot_test_variable2");
+    expect(slot1 != slot2);
+    expect(table.intern("slot_test_variable1") == slot1);
+    expect(table.find("slot_test_variable2") == slot2);
+    expect(table.find("slot_test_unknown_variable") == std::nullopt);
+    expect(table.get_name(slot1) == "slot_test_variable1");
+
+    krbn::manipulator::manipulator_environment environment;
+
+    // Name-based and slot-based accessors share the same storage.
+
+    environment.set_variable("slot_test_variable1", krbn::manipulator_environment_variable_value(1));
+    expect(environment.get_variable(slot1) == krbn::manipulator_environment_variable_value(1));
+
+    environment.set_variable(slot2, krbn::manipulator_environment_variable_value("two"));
+    expect(environment.get_variable("slot_test_variable2") == krbn::manipulator_environment_variable_value("two"));
+
+    expect(environment.to_json()["variables"]["slot_test_variable1"] == 1);
+    expect(environment.to_json()["variables"]["slot_test_variable2"] == "two");
+
+    environment.unset_variable(slot1);
+    expect(environment.get_variable("slot_test_variable1") == krbn::manipulator_environment_variable_value());
+    expect(!environment.to_json()["variables"].contains("slot_test_variable1"));
+
+    // Unknown names are not interned by getters.
+
+    expect(environment.get_variable("slot_test_unknown_variable") == krbn::manipulator_environment_variable_value());
+    environment.unset_variable("slot_test_unknown_variable");
+    expect(table.find("slot_test_unknown_variable") == std::nullopt);
+
+    // set_variable events carry the interned slot.
+
+    krbn::manipulator_environment_variable_set_variable set_variable("slot_test_variable2",
+                                                                     krbn::manipulator_environment_variable_value(2),
+                                                                     std::nullopt);
+    expect(set_variable.get_name_slot() == slot2);
+
+    set_variable.set_name(std::nullopt);
+    expect(set_variable.get_name_slot() == std::nullopt);
+
+    // The number of names is limited.
+
+    {
+      krbn::manipulator_environment_variable_name_table small_table(2);
+
+      expect(small_table.intern("slot_test_variable1") != std::nullopt);
+      expect(small_table.intern("slot_test_variable2") != std::nullopt);
+      expect(small_table.intern("slot_test_variable3") == std::nullopt);
+      expect(small_table.find("slot_test_variable3") == std::nullopt);
+
+      // Interned names are still available.
+      expect(small_table.intern("slot_test_variable1") != std::nullopt);
+      expect(small_table.size() == 2_ul);
+    }
+  };
+
+  "condition_expression_manager"_test = [] {
+    krbn::manipulator::condition_expression_manager manager;
+
+    krbn::manipulator::conditions::expression condition1(R"(
+{
+  "type": "expression_if",
+  "expression": "device.vendor_id == 1000"
+}
+    )"_json,
+                                                         manager.get_shared_variables());
+    manager.insert(condition1.get_expression());
+
+    expect(manager.referenced("device.vendor_id"));
+    expect(!manager.referenced("device.product_id"));
+
+    {
+      auto condition2 = std::make_shared<krbn::manipulator::conditions::expression>(R"(
+{
+  "type": "expression_if",
+  "expression": "device.product_id == 2000"
+}
+      )"_json,
+                                                                                    manager.get_shared_variables());
+      manager.insert(condition2->get_expression());
+
+      expect(manager.referenced("device.product_id"));
+    }
+
+    // condition2 is destroyed.
+    expect(!manager.referenced("device.product_id"));
+
+    // set_variable
+
+    krbn::manipulator::manipulator_environment environment;
+    auto entry = krbn::unit_testing::manipulator_conditions_helper().make_event_queue_entry(krbn::device_id(1));
+
+    expect(condition1.is_fulfilled(entry, environment) == false);
+
+    expect(manager.set_variable("device.vendor_id", 1000) == true);
+    expect(manager.set_variable("device.vendor_id", 1000) == false);
+    expect(condition1.is_fulfilled(entry, environment) == true);
+
+    // Type mismatch
+    expect(manager.set_variable("device.vendor_id", "1000") == false);
+
+    // device_variables_source
+
+    krbn::manipulator::condition_expression_manager::device_variables_source source{
+        .manipulator_environment_instance_id = environment.get_instance_id(),
+        .entry_device_id = krbn::device_id(1),
+    };
+    expect(manager.update_device_variables_source(source) == true);
+    expect(manager.update_device_variables_source(source) == false);
+
+    source.entry_device_id = krbn::device_id(2);
+    expect(manager.update_device_variables_source(source) == true);
+
+    // Inserting an expression resets the source.
+    manager.insert(condition1.get_expression());
+    expect(manager.update_device_variables_source(source) == true);
+  };
+
+  "condition_manager.cache (variables)"_test = [] {
+    krbn::unit_testing::manipulator_conditions_helper helper;
+    auto& environment = helper.get_manipulator_environment();
+    auto entry = helper.make_event_queue_entry(krbn::device_id(1));
+
+    krbn::manipulator::condition_manager condition_manager;
+    condition_manager.push_back_condition(krbn::manipulator::condition_factory::make_condition(R"(
+{
+  "type": "variable_if",
+  "name": "layer",
+  "value": 1
+}
+    )"_json));
+
+    expect(condition_manager.is_fulfilled(entry, environment) == false);
+    expect(condition_manager.is_fulfilled(entry, environment) == false);
+
+    environment.set_variable("layer", krbn::manipulator_environment_variable_value(1));
+    expect(condition_manager.is_fulfilled(entry, environment) == true);
+    expect(condition_manager.is_fulfilled(entry, environment) == true);
+
+    // Another variable
+    environment.set_variable("other", krbn::manipulator_environment_variable_value(1));
+    expect(condition_manager.is_fulfilled(entry, environment) == true);
+
+    environment.unset_variable("layer");
+    expect(condition_manager.is_fulfilled(entry, environment) == false);
+  };
+
+  "condition_manager.cache (frontmost_application)"_test = [] {
+    krbn::unit_testing::manipulator_conditions_helper helper;
+    auto& environment = helper.get_manipulator_environment();
+    auto entry = helper.make_event_queue_entry(krbn::device_id(1));
+
+    krbn::manipulator::condition_manager condition_manager;
+    condition_manager.push_back_condition(krbn::manipulator::condition_factory::make_condition(R"(
+{
+  "type": "frontmost_application_if",
+  "bundle_identifiers": ["^com\\.apple\\.Terminal$"]
+}
+    )"_json));
+
+    expect(condition_manager.is_fulfilled(entry, environment) == false);
+
+    pqrs::osx::frontmost_application_monitor::application application;
+    application.set_bundle_identifier("com.apple.Terminal");
+    environment.set_frontmost_application(application);
+    expect(condition_manager.is_fulfilled(entry, environment) == true);
+    expect(condition_manager.is_fulfilled(entry, environment) == true);
+
+    application.set_bundle_identifier("com.googlecode.iterm2");
+    environment.set_frontmost_application(application);
+    expect(condition_manager.is_fulfilled(entry, environment) == false);
+  };
+
+  "condition_manager.cache (input_source)"_test = [] {
+    krbn::unit_testing::manipulator_conditions_helper helper;
+    auto& environment = helper.get_manipulator_environment();
+    auto entry = helper.make_event_queue_entry(krbn::device_id(1));
+
+    krbn::manipulator::condition_manager condition_manager;
+    condition_manager.push_back_condition(krbn::manipulator::condition_factory::make_condition(R"(
+{
+  "type": "input_source_if",
+  "input_sources": [{ "language": "^en$" }]
+}
+    )"_json));
+
+    expect(condition_manager.is_fulfilled(entry, environment) == false);
+
+    pqrs::osx::input_source::properties properties;
+    properties.set_first_language("en");
+    environment.set_input_source_properties(properties);
+    expect(condition_manager.is_fulfilled(entry, environment) == true);
+    expect(condition_manager.is_fulfilled(entry, environment) == true);
+
+    properties.set_first_language("ja");
+    environment.set_input_source_properties(properties);
+    expect(condition_manager.is_fulfilled(entry, environment) == false);
+  };
+
+  "condition_manager.cache (devices)"_test = [] {
+    krbn::unit_testing::manipulator_conditions_helper helper;
+    auto& environment = helper.get_manipulator_environment();
+
+    krbn::manipulator::condition_manager condition_manager;
+    condition_manager.push_back_condition(krbn::manipulator::condition_factory::make_condition(R"(
+{
+  "type": "device_if",
+  "identifiers": [{ "vendor_id": 1000 }]
+}
+    )"_json));
+
+    auto device_id_1000 = helper.prepare_device(krbn::device_properties::initialization_parameters{
+        .vendor_id = pqrs::hid::vendor_id::value_t(1000),
+        .product_id = pqrs::hid::product_id::value_t(2000),
+        .is_keyboard = true,
+    });
+    auto device_id_2000 = helper.prepare_device(krbn::device_properties::initialization_parameters{
+        .vendor_id = pqrs::hid::vendor_id::value_t(2000),
+        .product_id = pqrs::hid::product_id::value_t(2000),
+        .is_keyboard = true,
+    });
+
+    // The result depends on the entry's device_id.
+
+    expect(condition_manager.is_fulfilled(helper.make_event_queue_entry(device_id_1000), environment) == true);
+    expect(condition_manager.is_fulfilled(helper.make_event_queue_entry(device_id_2000), environment) == false);
+    expect(condition_manager.is_fulfilled(helper.make_event_queue_entry(device_id_1000), environment) == true);
+
+    // Device removal
+
+    environment.erase_device_properties(device_id_1000);
+    expect(condition_manager.is_fulfilled(helper.make_event_queue_entry(device_id_1000), environment) == false);
+  };
+
+  "condition_manager.cache (core_configuration)"_test = [] {
+    krbn::unit_testing::manipulator_conditions_helper helper;
+    auto& environment = helper.get_manipulator_environment();
+    auto entry = helper.make_event_queue_entry(krbn::device_id(1));
+
+    krbn::manipulator::condition_manager condition_manager;
+    condition_manager.push_back_condition(krbn::manipulator::condition_factory::make_condition(R"(
+{
+  "type": "keyboard_type_if",
+  "keyboard_types": ["iso"]
+}
+    )"_json));
+
+    auto core_configuration = helper.get_core_configuration();
+
+    core_configuration->get_selected_profile().get_virtual_hid_keyboard()->set_keyboard_type_v2("iso");
+    environment.set_core_configuration(core_configuration);
+    expect(condition_manager.is_fulfilled(entry, environment) == true);
+    expect(condition_manager.is_fulfilled(entry, environment) == true);
+
+    core_configuration->get_selected_profile().get_virtual_hid_keyboard()->set_keyboard_type_v2("ansi");
+    environment.set_core_configuration(core_configuration);
+    expect(condition_manager.is_fulfilled(entry, environment) == false);
+  };
+
+  "condition_manager.cache (expression)"_test = [] {
+    krbn::unit_testing::manipulator_conditions_helper helper;
+    auto& environment = helper.get_manipulator_environment();
+
+    krbn::manipulator::condition_manager condition_manager;
+    condition_manager.push_back_condition(krbn::manipulator::condition_factory::make_condition(R"(
+{
+  "type": "expression_if",
+  "expression": "device.vendor_id == 1000"
+}
+    )"_json));
+
+    auto device_id_1000 = helper.prepare_device(krbn::device_properties::initialization_parameters{
+        .vendor_id = pqrs::hid::vendor_id::value_t(1000),
+        .product_id = pqrs::hid::product_id::value_t(2000),
+        .is_keyboard = true,
+    });
+    auto device_id_2000 = helper.prepare_device(krbn::device_properties::initialization_parameters{
+        .vendor_id = pqrs::hid::vendor_id::value_t(2000),
+        .product_id = pqrs::hid::product_id::value_t(2000),
+        .is_keyboard = true,
+    });
+
+    expect(condition_manager.is_fulfilled(helper.make_event_queue_entry(device_id_1000), environment) == true);
+    expect(condition_manager.is_fulfilled(helper.make_event_queue_entry(device_id_2000), environment) == false);
+    expect(condition_manager.is_fulfilled(helper.make_event_queue_entry(device_id_1000), environment) == true);
+  };
+
+  "condition_manager.cache (manipulator_environment instances)"_test = [] {
+    krbn::unit_testing::manipulator_conditions_helper helper1;
+    krbn::unit_testing::manipulator_conditions_helper helper2;
+    auto entry = helper1.make_event_queue_entry(krbn::device_id(1));
+
+    krbn::manipulator::condition_manager condition_manager;
+    condition_manager.push_back_condition(krbn::manipulator::condition_factory::make_condition(R"(
+{
+  "type": "variable_if",
+  "name": "layer",
+  "value": 1
+}
+    )"_json));
+
+    // Both environments have the same generations.
+    helper1.get_manipulator_environment().set_variable("layer", krbn::manipulator_environment_variable_value(1));
+    helper2.get_manipulator_environment().set_variable("layer", krbn::manipulator_environment_variable_value(2));
+
+    expect(condition_manager.is_fulfilled(entry, helper1.get_manipulator_environment()) == true);
+    expect(condition_manager.is_fulfilled(entry, helper2.get_manipulator_environment()) == false);
+  };
+}
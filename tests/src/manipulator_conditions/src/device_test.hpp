@@ -333,4 +333,120 @@ void run_device_test(void) {
       }
     }
   };
+
+  "conditions.device (hot-plug)"_test = [] {
+    krbn::unit_testing::manipulator_conditions_helper manipulator_conditions_helper;
+    auto& environment = manipulator_conditions_helper.get_manipulator_environment();
+
+    krbn::manipulator::conditions::device device_if(R"(
+{
+  "type": "device_if",
+  "identifiers": [{ "vendor_id": 1000 }]
+}
+    )"_json);
+
+    krbn::manipulator::conditions::device device_unless(R"(
+{
+  "type": "device_unless",
+  "identifiers": [{ "vendor_id": 1000 }]
+}
+    )"_json);
+
+    auto device_id = krbn::device_id(100);
+    auto e = manipulator_conditions_helper.make_event_queue_entry(device_id);
+
+    auto make_device_properties = [device_id](pqrs::hid::vendor_id::value_t vendor_id) {
+      return std::make_shared<krbn::device_properties>(krbn::device_properties::initialization_parameters{
+          .device_id = device_id,
+          .vendor_id = vendor_id,
+          .product_id = pqrs::hid::product_id::value_t(2000),
+          .is_keyboard = true,
+      });
+    };
+
+    // Events before the device is grabbed
+
+    expect(device_if.is_fulfilled(e, environment) == false);
+    expect(device_unless.is_fulfilled(e, environment) == true);
+
+    // Grabbed
+
+    environment.insert_device_properties(device_id, make_device_properties(pqrs::hid::vendor_id::value_t(1000)));
+    expect(device_if.is_fulfilled(e, environment) == true);
+    expect(device_unless.is_fulfilled(e, environment) == false);
+    expect(device_if.is_fulfilled(e, environment) == true);
+    expect(device_unless.is_fulfilled(e, environment) == false);
+
+    // Ungrabbed
+
+    environment.erase_device_properties(device_id);
+    expect(device_if.is_fulfilled(e, environment) == false);
+    expect(device_unless.is_fulfilled(e, environment) == true);
+
+    // The same device_id is reused by another device
+
+    environment.insert_device_properties(device_id, make_device_properties(pqrs::hid::vendor_id::value_t(2000)));
+    expect(device_if.is_fulfilled(e, environment) == false);
+    expect(device_unless.is_fulfilled(e, environment) == true);
+
+    // Grabbed again without ungrabbed event
+
+    environment.insert_device_properties(device_id, make_device_properties(pqrs::hid::vendor_id::value_t(1000)));
+    expect(device_if.is_fulfilled(e, environment) == true);
+    expect(device_unless.is_fulfilled(e, environment) == false);
+
+    // Other devices do not affect the cached results
+
+    auto device_id_2000 = manipulator_conditions_helper.prepare_device(krbn::device_properties::initialization_parameters{
+        .vendor_id = pqrs::hid::vendor_id::value_t(2000),
+        .product_id = pqrs::hid::product_id::value_t(2000),
+        .is_keyboard = true,
+    });
+    auto e_2000 = manipulator_conditions_helper.make_event_queue_entry(device_id_2000);
+
+    for (int i = 0; i < 3; ++i) {
+      expect(device_if.is_fulfilled(e, environment) == true);
+      expect(device_if.is_fulfilled(e_2000, environment) == false);
+    }
+
+    environment.erase_device_properties(device_id_2000);
+    expect(device_if.is_fulfilled(e, environment) == true);
+    expect(device_if.is_fulfilled(e_2000, environment) == false);
+    expect(environment.get_device_condition_results().size() == 2);
+  };
+
+  "conditions.device (condition id reuse)"_test = [] {
+    krbn::unit_testing::manipulator_conditions_helper manipulator_conditions_helper;
+    auto& environment = manipulator_conditions_helper.get_manipulator_environment();
+
+    auto device_id = manipulator_conditions_helper.prepare_device(krbn::device_properties::initialization_parameters{
+        .vendor_id = pqrs::hid::vendor_id::value_t(1000),
+        .product_id = pqrs::hid::product_id::value_t(2000),
+        .is_keyboard = true,
+    });
+    auto e = manipulator_conditions_helper.make_event_queue_entry(device_id);
+
+    {
+      krbn::manipulator::conditions::device condition(R"(
+{
+  "type": "device_if",
+  "identifiers": [{ "vendor_id": 1000 }]
+}
+      )"_json);
+      expect(condition.is_fulfilled(e, environment) == true);
+    }
+
+    // A new condition may get the released condition id.
+    // The result of the destroyed condition must not be used.
+
+    {
+      krbn::manipulator::conditions::device condition(R"(
+{
+  "type": "device_if",
+  "identifiers": [{ "vendor_id": 2000 }]
+}
+      )"_json);
+      expect(condition.is_fulfilled(e, environment) == false);
+    }
+  };
 }
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "manipulator/pattern_matcher.hpp"
+#include <boost/ut.hpp>
+
+void run_pattern_matcher_test(void) {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "pattern_matcher"_test = [] {
+    std::vector<std::string> patterns{
+        // Literals
+        "^com\\.apple\\.Terminal$",
+        "^com\\.googlecode\\.iterm2$",
+        "^com/apple/Terminal$",
+        "^com\\.apple\\.",
+        "com\\.apple",
+        "Terminal$",
+        "iTerm",
+        "^/Applications/",
+        "\\.app$",
+        "^en$",
+        "^ja",
+        "^$",
+        "",
+        "a\\$",
+        // Regexes
+        "\\-x",
+        "com\\/apple",
+        "a\\\\$",
+        "a.b",
+        "\\d+",
+        "^com\\.apple\\.(Terminal|Safari)$",
+        "^com\\.[a-z]+\\.Terminal$",
+        "^/Users/[^/]+/Applications/iTerm\\.app$",
+    };
+
+    std::vector<std::string> subjects{
+        "com.apple.Terminal",
+        "com/apple/Terminal",
+        "com.apple.Safari",
+        "com.appleXTerminal",
+        "com.googlecode.iterm2",
+        "/Applications/Utilities/Terminal.app",
+        "/Applications/iTerm.app",
+        "/Users/tekezo/Applications/iTerm.app",
+        "en",
+        "ja",
+        "",
+        "a$",
+        "a\\",
+        "a-x",
+        "a.b",
+        "axb",
+        "123",
+    };
+
+    krbn::manipulator::pattern_matcher matcher;
+
+    std::vector<krbn::manipulator::pattern_matcher::pattern_id> ids;
+    for (const auto& p : patterns) {
+      ids.push_back(matcher.register_pattern(p));
+    }
+
+    expect(patterns.size() == matcher.size());
+    expect(14_ul == matcher.literal_size());
+
+    // The same pattern gets the same id.
+    expect(ids[0] == matcher.register_pattern(patterns[0]));
+    expect(patterns.size() == matcher.size());
+
+    // The results are the same as std::regex.
+    for (const auto& s : subjects) {
+      for (size_t i = 0; i < patterns.size(); ++i) {
+        auto expected = std::regex_search(s, std::regex(patterns[i]));
+        expect(expected == matcher.matches(ids[i], s)) << "pattern:" << patterns[i] << " subject:" << s;
+      }
+    }
+
+    // Register a pattern after matching.
+    {
+      auto id = matcher.register_pattern("^com\\.apple\\.Safari$");
+      expect(matcher.matches(id, "com.apple.Safari"));
+      expect(!matcher.matches(id, "com.apple.Terminal"));
+    }
+
+    // Invalid pattern
+    expect(throws<std::regex_error>([&] {
+      matcher.register_pattern("[");
+    }));
+  };
+
+  "pattern_matcher.unregister_pattern"_test = [] {
+    auto matcher = std::make_shared<krbn::manipulator::pattern_matcher>();
+
+    {
+      krbn::manipulator::registered_pattern p1(matcher, "^com\\.apple\\.Terminal$");
+      krbn::manipulator::registered_pattern p2(matcher, "^com\\.apple\\.Terminal$");
+      krbn::manipulator::registered_pattern p3(matcher, "a.b");
+
+      expect(2_ul == matcher->size());
+      expect(p1.matches("com.apple.Terminal"));
+      expect(p3.matches("axb"));
+    }
+
+    // Patterns are removed when the last registration is destroyed.
+    expect(0_ul == matcher->size());
+
+    // The slot is reused and the removed pattern is not matched.
+    {
+      auto id1 = matcher->register_pattern("^com\\.apple\\.Safari$");
+      auto id2 = matcher->register_pattern("^com\\.apple\\.Terminal$");
+      expect(2_ul == matcher->size());
+      expect(id1 < 2_ul);
+      expect(id2 < 2_ul);
+      expect(!matcher->matches(id1, "com.apple.Terminal"));
+      expect(matcher->matches(id2, "com.apple.Terminal"));
+
+      matcher->unregister_pattern(id1);
+      expect(1_ul == matcher->size());
+      expect(matcher->matches(id2, "com.apple.Terminal"));
+    }
+  };
+}
@@ -1,7 +1,9 @@
+#include "condition_manager_test.hpp"
 #include "device_exists_test.hpp"
 #include "device_test.hpp"
 #include "errors_test.hpp"
 #include "manipulator_conditions_test.hpp"
+#include "pattern_matcher_test.hpp"
 #include "run_loop_thread_utility.hpp"
 
 int main(void) {
@@ -12,6 +14,8 @@ int main(void) {
   run_manipulator_conditions_test();
   run_device_exists_test();
   run_device_test();
+  run_condition_manager_test();
+  run_pattern_matcher_test();
 
   return 0;
 }
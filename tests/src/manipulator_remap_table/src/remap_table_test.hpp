@@ -0,0 +1,276 @@
+#include "manipulator/condition_factory.hpp"
+#include "manipulator/manipulator_factory.hpp"
+#include "manipulator/manipulator_manager.hpp"
+#include "manipulator/manipulators/remap_table/remap_table.hpp"
+#include <boost/ut.hpp>
+
+namespace {
+using definitions_t = std::vector<std::pair<krbn::manipulator::manipulators::basic::from_event_definition,
+                                            krbn::manipulator::to_event_definitions>>;
+
+std::pair<krbn::manipulator::manipulators::basic::from_event_definition,
+          krbn::manipulator::to_event_definitions>
+make_definition(nlohmann::json from_json,
+                const nlohmann::json& to_json) {
+  if (!from_json.contains("modifiers")) {
+    from_json["modifiers"]["optional"] = nlohmann::json::array({"any"});
+  }
+
+  krbn::manipulator::to_event_definitions to_event_definitions;
+  for (const auto& j : to_json) {
+    to_event_definitions.push_back(std::make_shared<krbn::manipulator::to_event_definition>(j));
+  }
+
+  return std::make_pair(krbn::manipulator::manipulators::basic::from_event_definition(from_json),
+                        to_event_definitions);
+}
+
+definitions_t make_simple_definitions(void) {
+  definitions_t definitions;
+
+  definitions.push_back(make_definition(nlohmann::json::object({{"key_code", "a"}}),
+                                        nlohmann::json::array({nlohmann::json::object({{"key_code", "b"}})})));
+  definitions.push_back(make_definition(nlohmann::json::object({{"key_code", "b"}}),
+                                        nlohmann::json::array({nlohmann::json::object({{"key_code", "a"}})})));
+  definitions.push_back(make_definition(nlohmann::json::object({{"key_code", "caps_lock"}}),
+                                        nlohmann::json::array({nlohmann::json::object({{"key_code", "left_control"}})})));
+  definitions.push_back(make_definition(nlohmann::json::object({{"consumer_key_code", "mute"}}),
+                                        nlohmann::json::array({nlohmann::json::object({{"key_code", "f10"}})})));
+  // Ignored since `a` is already defined.
+  definitions.push_back(make_definition(nlohmann::json::object({{"key_code", "a"}}),
+                                        nlohmann::json::array({nlohmann::json::object({{"key_code", "c"}})})));
+
+  return definitions;
+}
+
+std::vector<krbn::event_queue::entry> manipulate(const std::vector<gsl::not_null<std::shared_ptr<krbn::manipulator::manipulators::base>>>& manipulators) {
+  auto core_configuration = std::make_shared<krbn::core_configuration::core_configuration>();
+
+  auto manager = std::make_shared<krbn::manipulator::manipulator_manager>();
+  for (const auto& m : manipulators) {
+    m->push_back_condition(krbn::manipulator::condition_factory::make_condition(nlohmann::json::object({
+        {"type", "variable_unless"},
+        {"name", "remap_table_test"},
+        {"value", 1},
+    })));
+    manager->push_back_manipulator(m);
+  }
+
+  auto input_event_queue = std::make_shared<krbn::event_queue::queue>();
+  auto output_event_queue = std::make_shared<krbn::event_queue::queue>();
+
+  auto device_id_1 = krbn::device_id(1);
+  auto device_id_2 = krbn::device_id(2);
+  auto state_original = krbn::event_queue::state::original;
+  auto state_virtual = krbn::event_queue::state::virtual_event;
+
+  auto a = krbn::event_queue::event(krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                                 pqrs::hid::usage::keyboard_or_keypad::keyboard_a));
+  auto b = krbn::event_queue::event(krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                                 pqrs::hid::usage::keyboard_or_keypad::keyboard_b));
+  auto c = krbn::event_queue::event(krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                                 pqrs::hid::usage::keyboard_or_keypad::keyboard_c));
+  auto caps_lock = krbn::event_queue::event(krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                                         pqrs::hid::usage::keyboard_or_keypad::keyboard_caps_lock));
+  auto mute = krbn::event_queue::event(krbn::momentary_switch_event(pqrs::hid::usage_page::consumer,
+                                                                    pqrs::hid::usage::consumer::mute));
+  auto ungrabbed_event = krbn::event_queue::event::make_device_ungrabbed_event();
+
+  auto t = krbn::absolute_time_point(0);
+  auto push_back = [&](krbn::device_id device_id,
+                       const krbn::event_queue::event& e,
+                       krbn::event_type event_type,
+                       krbn::event_queue::state state) {
+    t += pqrs::osx::chrono::make_absolute_time_duration(std::chrono::milliseconds(1));
+    input_event_queue->emplace_back_entry(device_id, krbn::event_queue::event_time_stamp(t), e, event_type, e, state);
+    while (manager->manipulate(input_event_queue, output_event_queue, t, core_configuration)) {
+    }
+  };
+  auto set_variable = [&](int value) {
+    output_event_queue->get_manipulator_environment().set_variable("remap_table_test",
+                                                                   krbn::manipulator_environment_variable_value(value));
+  };
+
+  // Overlapped key presses
+  push_back(device_id_1, a, krbn::event_type::key_down, state_original);
+  push_back(device_id_1, b, krbn::event_type::key_down, state_original);
+  push_back(device_id_1, a, krbn::event_type::key_up, state_original);
+  push_back(device_id_1, b, krbn::event_type::key_up, state_original);
+
+  // Keys which are not in the table
+  push_back(device_id_1, c, krbn::event_type::key_down, state_original);
+  push_back(device_id_1, c, krbn::event_type::key_up, state_original);
+
+  // Modifier keys and other usage pages
+  push_back(device_id_1, caps_lock, krbn::event_type::key_down, state_original);
+  push_back(device_id_1, mute, krbn::event_type::key_down, state_original);
+  push_back(device_id_1, mute, krbn::event_type::key_up, state_original);
+  push_back(device_id_1, caps_lock, krbn::event_type::key_up, state_original);
+
+  // The same key on multiple devices
+  push_back(device_id_1, a, krbn::event_type::key_down, state_original);
+  push_back(device_id_2, a, krbn::event_type::key_down, state_original);
+  push_back(device_id_1, a, krbn::event_type::key_up, state_original);
+  push_back(device_id_2, a, krbn::event_type::key_up, state_original);
+
+  // Conditions are tested only at key_down.
+  push_back(device_id_1, a, krbn::event_type::key_down, state_original);
+  set_variable(1);
+  push_back(device_id_1, b, krbn::event_type::key_down, state_original);
+  push_back(device_id_1, a, krbn::event_type::key_up, state_original);
+  push_back(device_id_1, b, krbn::event_type::key_up, state_original);
+  set_variable(0);
+
+  // Ungrabbed devices
+  push_back(device_id_2, b, krbn::event_type::key_down, state_original);
+  push_back(device_id_2, ungrabbed_event, krbn::event_type::single, state_virtual);
+  push_back(device_id_2, b, krbn::event_type::key_up, state_original);
+
+  std::vector<krbn::event_queue::entry> entries;
+  for (const auto& e : output_event_queue->get_entries()) {
+    entries.push_back(e);
+  }
+  return entries;
+}
+} // namespace
+
+void run_remap_table_test(void) {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "remap_table.remappable"_test = [] {
+    using krbn::manipulator::manipulators::remap_table::remap_table;
+
+    for (const auto& [from, to] : make_simple_definitions()) {
+      expect(remap_table::remappable(from, to));
+    }
+
+    // from.modifiers.mandatory
+    {
+      auto [from, to] = make_definition(nlohmann::json::object({
+                                            {"key_code", "a"},
+                                            {"modifiers", nlohmann::json::object({
+                                                              {"mandatory", nlohmann::json::array({"fn"})},
+                                                              {"optional", nlohmann::json::array({"any"})},
+                                                          })},
+                                        }),
+                                        nlohmann::json::array({nlohmann::json::object({{"key_code", "b"}})}));
+      expect(!remap_table::remappable(from, to));
+    }
+
+    // from.modifiers.optional without any
+    {
+      auto [from, to] = make_definition(nlohmann::json::object({
+                                            {"key_code", "a"},
+                                            {"modifiers", nlohmann::json::object({
+                                                              {"optional", nlohmann::json::array({"shift"})},
+                                                          })},
+                                        }),
+                                        nlohmann::json::array({nlohmann::json::object({{"key_code", "b"}})}));
+      expect(!remap_table::remappable(from, to));
+    }
+
+    // from.any
+    {
+      auto [from, to] = make_definition(nlohmann::json::object({{"any", "key_code"}}),
+                                        nlohmann::json::array({nlohmann::json::object({{"key_code", "b"}})}));
+      expect(!remap_table::remappable(from, to));
+    }
+
+    // to.modifiers
+    {
+      auto [from, to] = make_definition(nlohmann::json::object({{"key_code", "a"}}),
+                                        nlohmann::json::array({nlohmann::json::object({
+                                            {"key_code", "f1"},
+                                            {"modifiers", nlohmann::json::array({"fn"})},
+                                        })}));
+      expect(!remap_table::remappable(from, to));
+    }
+
+    // to.lazy
+    {
+      auto [from, to] = make_definition(nlohmann::json::object({{"key_code", "a"}}),
+                                        nlohmann::json::array({nlohmann::json::object({
+                                            {"key_code", "left_shift"},
+                                            {"lazy", true},
+                                        })}));
+      expect(!remap_table::remappable(from, to));
+    }
+
+    // Multiple `to` events
+    {
+      auto [from, to] = make_definition(nlohmann::json::object({{"key_code", "a"}}),
+                                        nlohmann::json::array({
+                                            nlohmann::json::object({{"key_code", "b"}}),
+                                            nlohmann::json::object({{"key_code", "c"}}),
+                                        }));
+      expect(!remap_table::remappable(from, to));
+    }
+
+    // Non momentary_switch_event `to`
+    {
+      auto [from, to] = make_definition(nlohmann::json::object({{"key_code", "a"}}),
+                                        nlohmann::json::array({nlohmann::json::object({{"shell_command", "open -a 'Safari.app'"}})}));
+      expect(!remap_table::remappable(from, to));
+    }
+  };
+
+  "remap_table.insert"_test = [] {
+    krbn::manipulator::manipulators::remap_table::remap_table table;
+
+    for (const auto& [from, to] : make_simple_definitions()) {
+      table.insert(from, to);
+    }
+
+    // The duplicated `a` is ignored.
+    expect(table.size() == 4_ul);
+    expect(table.make_target_event_definitions()->size() == 4_ul);
+    expect(!table.needs_virtual_hid_pointing());
+    expect(!table.active());
+  };
+
+  "manipulator_factory::make_remap_manipulators"_test = [] {
+    {
+      auto manipulators = krbn::manipulator::manipulator_factory::make_remap_manipulators(make_simple_definitions());
+      expect(manipulators.size() == 1_ul);
+      expect(dynamic_cast<krbn::manipulator::manipulators::remap_table::remap_table*>(manipulators[0].get().get()) != nullptr);
+    }
+
+    // `basic` manipulators are used if some definitions are not remappable.
+    {
+      auto definitions = make_simple_definitions();
+      definitions.push_back(make_definition(nlohmann::json::object({{"key_code", "c"}}),
+                                            nlohmann::json::array({nlohmann::json::object({
+                                                {"key_code", "d"},
+                                                {"modifiers", nlohmann::json::array({"left_shift"})},
+                                            })})));
+      auto manipulators = krbn::manipulator::manipulator_factory::make_remap_manipulators(definitions);
+      expect(manipulators.size() == definitions.size());
+      for (const auto& m : manipulators) {
+        expect(dynamic_cast<krbn::manipulator::manipulators::basic::basic*>(m.get().get()) != nullptr);
+      }
+    }
+
+    expect(krbn::manipulator::manipulator_factory::make_remap_manipulators({}).empty());
+  };
+
+  "remap_table.manipulate"_test = [] {
+    // remap_table sends the same events as basic manipulators.
+
+    std::vector<gsl::not_null<std::shared_ptr<krbn::manipulator::manipulators::base>>> basic_manipulators;
+    for (const auto& [from, to] : make_simple_definitions()) {
+      basic_manipulators.push_back(std::make_shared<krbn::manipulator::manipulators::basic::basic>(from, to));
+    }
+
+    auto expected = manipulate(basic_manipulators);
+    auto actual = manipulate(krbn::manipulator::manipulator_factory::make_remap_manipulators(make_simple_definitions()));
+
+    expect(expected.size() == 21_ul);
+    expect(actual == expected);
+
+    // a -> b
+    expect(actual[0].get_event() == krbn::event_queue::event(krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                                                          pqrs::hid::usage::keyboard_or_keypad::keyboard_b)));
+    expect(actual[0].get_state() == krbn::event_queue::state::manipulated);
+  };
+}
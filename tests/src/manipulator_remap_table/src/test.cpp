@@ -0,0 +1,10 @@
+#include "dispatcher_utility.hpp"
+#include "remap_table_test.hpp"
+
+int main(void) {
+  auto scoped_dispatcher_manager = krbn::dispatcher_utility::initialize_dispatchers();
+
+  run_remap_table_test();
+
+  return 0;
+}
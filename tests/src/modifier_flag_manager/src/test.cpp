@@ -376,6 +376,11 @@ int main(void) {
                  krbn::modifier_flag::right_command,
                  krbn::modifier_flag::fn,
              }) == modifier_flag_manager.make_modifier_flags());
+
+      expect((krbn::make_modifier_flag_bitmask(krbn::modifier_flag::caps_lock) |
+              krbn::make_modifier_flag_bitmask(krbn::modifier_flag::left_shift) |
+              krbn::make_modifier_flag_bitmask(krbn::modifier_flag::right_command) |
+              krbn::make_modifier_flag_bitmask(krbn::modifier_flag::fn)) == modifier_flag_manager.get_pressed_modifier_flags());
     }
   };
 
@@ -0,0 +1,392 @@
+#pragma once
+
+#include "manipulator/manipulators/post_event_to_virtual_devices/queue.hpp"
+#include <boost/ut.hpp>
+
+namespace {
+using queue = krbn::manipulator::manipulators::post_event_to_virtual_devices::queue;
+
+std::string make_report_string(const krbn::manipulator::manipulators::post_event_to_virtual_devices::hid_report& report) {
+  if (auto r = std::get_if<pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input>(&report)) {
+    return fmt::format("pointing:{0}", static_cast<int>(r->x));
+  }
+  return "keyboard";
+}
+
+// A stand-in of hid_report_submitter which logs each batch as one submission.
+class logging_submitter final {
+public:
+  logging_submitter(std::vector<std::string>& log) : log_(log) {
+  }
+
+  void submit(const std::vector<krbn::manipulator::manipulators::post_event_to_virtual_devices::hid_report>& hid_reports) const {
+    std::string s;
+    for (const auto& r : hid_reports) {
+      if (!s.empty()) {
+        s += ", ";
+      }
+      s += make_report_string(r);
+    }
+    log_.push_back(fmt::format("submission [{0}]", s));
+  }
+
+private:
+  std::vector<std::string>& log_;
+};
+
+// A stand-in of console_user_server_client.
+class console_client final {
+public:
+  console_client(std::vector<std::string>& log) : log_(log) {
+  }
+
+  void async_shell_command_execution(const std::string& shell_command) {
+    log_.push_back(fmt::format("shell_command {0}", shell_command));
+  }
+
+  void async_select_input_source(std::shared_ptr<std::vector<pqrs::osx::input_source_selector::specifier>> input_source_specifiers) {
+    log_.push_back("select_input_source");
+  }
+
+  void async_software_function(const krbn::software_function& software_function) {
+    log_.push_back("software_function");
+  }
+
+private:
+  std::vector<std::string>& log_;
+};
+
+// A stand-in of hid_report_submitter which keeps the submitted reports.
+class recording_submitter final {
+public:
+  void submit(const std::vector<krbn::manipulator::manipulators::post_event_to_virtual_devices::hid_report>& hid_reports) const {
+    reports_.insert(std::end(reports_),
+                    std::begin(hid_reports),
+                    std::end(hid_reports));
+  }
+
+  const std::vector<krbn::manipulator::manipulators::post_event_to_virtual_devices::hid_report>& get_reports(void) const {
+    return reports_;
+  }
+
+private:
+  mutable std::vector<krbn::manipulator::manipulators::post_event_to_virtual_devices::hid_report> reports_;
+};
+
+pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input make_pointing_input(int x) {
+  pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input report;
+  report.x = x;
+  return report;
+}
+} // namespace
+
+void run_queue_test(void) {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "queue.post_events"_test = [] {
+    auto t = krbn::absolute_time_point(1000);
+    auto t1 = t + pqrs::osx::chrono::make_absolute_time_duration(std::chrono::milliseconds(1));
+    auto t2 = t + pqrs::osx::chrono::make_absolute_time_duration(std::chrono::seconds(10));
+
+    auto prepare = [&](queue& q) {
+      q.emplace_back_pointing_input(make_pointing_input(1), krbn::event_type::single, t);
+      q.emplace_back_pointing_input(make_pointing_input(2), krbn::event_type::single, t);
+      q.emplace_back_pointing_input(make_pointing_input(3), krbn::event_type::single, t);
+      q.push_back_shell_command_event("open -a Safari", t);
+      q.emplace_back_pointing_input(make_pointing_input(4), krbn::event_type::single, t);
+      q.emplace_back_pointing_input(make_pointing_input(5), krbn::event_type::single, t1);
+      q.emplace_back_pointing_input(make_pointing_input(6), krbn::event_type::single, t2);
+    };
+
+    // Reports which have the same time stamp are submitted at once.
+
+    {
+      std::vector<std::string> log;
+      logging_submitter submitter(log);
+      auto console = std::make_shared<console_client>(log);
+
+      queue q;
+      prepare(q);
+
+      auto next = q.post_events(t1,
+                                submitter,
+                                std::weak_ptr<console_client>(console));
+      expect(next == t2);
+      expect(q.get_events().size() == 1_ul);
+
+      std::vector<std::string> expected{
+          "submission [pointing:1, pointing:2, pointing:3]",
+          "shell_command open -a Safari",
+          "submission [pointing:4]",
+          "submission [pointing:5]",
+      };
+      expect(log == expected);
+
+      next = q.post_events(t2,
+                           submitter,
+                           std::weak_ptr<console_client>(console));
+      expect(next == std::nullopt);
+      expect(q.empty());
+
+      expected.push_back("submission [pointing:6]");
+      expect(log == expected);
+    }
+
+    // Events are consumed even if the clients are gone.
+
+    {
+      queue q;
+      prepare(q);
+
+      auto next = q.post_events(t1,
+                                krbn::manipulator::manipulators::post_event_to_virtual_devices::hid_report_submitter(std::weak_ptr<pqrs::karabiner::driverkit::virtual_hid_device_service::client>()),
+                                std::weak_ptr<console_client>());
+      expect(next == t2);
+      expect(q.get_events().size() == 1_ul);
+    }
+  };
+
+  "queue.coalesce_pointing_inputs"_test = [] {
+    using pointing_input = pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input;
+
+    auto t = krbn::absolute_time_point(1000);
+    auto now = t + pqrs::osx::chrono::make_absolute_time_duration(std::chrono::seconds(1));
+    auto future = now + pqrs::osx::chrono::make_absolute_time_duration(std::chrono::seconds(1));
+
+    struct totals final {
+      int x = 0;
+      int y = 0;
+      int vertical_wheel = 0;
+      int horizontal_wheel = 0;
+      size_t count = 0;
+
+      void add(const pointing_input& r) {
+        x += static_cast<int8_t>(r.x);
+        y += static_cast<int8_t>(r.y);
+        vertical_wheel += static_cast<int8_t>(r.vertical_wheel);
+        horizontal_wheel += static_cast<int8_t>(r.horizontal_wheel);
+        ++count;
+      }
+    };
+
+    auto make = [](int x, int y, int vertical_wheel, int horizontal_wheel, std::optional<int> button = std::nullopt) {
+      pointing_input r;
+      r.x = x;
+      r.y = y;
+      r.vertical_wheel = vertical_wheel;
+      r.horizontal_wheel = horizontal_wheel;
+      if (button) {
+        r.buttons.insert(*button);
+      }
+      return r;
+    };
+
+    queue q;
+    q.set_coalesce_pointing_inputs(true);
+
+    // (1) 100 reports without buttons
+    totals expected1;
+    for (int i = 0; i < 100; ++i) {
+      auto r = make(100, -70, (i % 2 == 0 ? 3 : -1), -1);
+      expected1.add(r);
+      q.emplace_back_pointing_input(r, krbn::event_type::single, t + krbn::absolute_time_duration(i));
+    }
+
+    // (2) keyboard
+    q.emplace_back_key_event(pqrs::hid::usage_pair(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                   pqrs::hid::usage::keyboard_or_keypad::keyboard_a),
+                             krbn::event_type::key_down,
+                             t);
+
+    // (3) 10 reports without buttons
+    totals expected3;
+    for (int i = 0; i < 10; ++i) {
+      auto r = make(-128, 127, 0, 0);
+      expected3.add(r);
+      q.emplace_back_pointing_input(r, krbn::event_type::single, t);
+    }
+
+    // (4) 10 reports with button1
+    totals expected4;
+    for (int i = 0; i < 10; ++i) {
+      auto r = make(1, 1, 0, 0, 1);
+      expected4.add(r);
+      q.emplace_back_pointing_input(r, krbn::event_type::single, t);
+    }
+
+    // (5) a report in the future
+    q.emplace_back_pointing_input(make(5, 5, 0, 0), krbn::event_type::single, future);
+
+    recording_submitter submitter;
+
+    auto next = q.post_events(now,
+                              submitter,
+                              std::weak_ptr<console_client>());
+    expect(next == future);
+    expect(q.get_events().size() == 1_ul);
+
+    // Split the reports into groups by keyboard and button changes.
+
+    std::vector<totals> actual(1);
+    std::vector<bool> actual_buttons;
+    for (const auto& report : submitter.get_reports()) {
+      if (auto r = std::get_if<pointing_input>(&report)) {
+        if (actual_buttons.size() < actual.size()) {
+          actual_buttons.push_back(!r->buttons.empty());
+        } else if (actual_buttons.back() != !r->buttons.empty()) {
+          actual.emplace_back();
+          actual_buttons.push_back(!r->buttons.empty());
+        }
+        actual.back().add(*r);
+      } else {
+        actual.emplace_back();
+      }
+    }
+
+    expect(actual.size() == 3_ul);
+    expect(actual_buttons == std::vector<bool>{false, false, true});
+
+    // Totals are preserved exactly.
+
+    expect(actual[0].x == expected1.x);
+    expect(actual[0].y == expected1.y);
+    expect(actual[0].vertical_wheel == expected1.vertical_wheel);
+    expect(actual[0].horizontal_wheel == expected1.horizontal_wheel);
+    expect(actual[1].x == expected3.x);
+    expect(actual[1].y == expected3.y);
+    expect(actual[1].vertical_wheel == expected3.vertical_wheel);
+    expect(actual[1].horizontal_wheel == expected3.horizontal_wheel);
+    expect(actual[2].x == expected4.x);
+    expect(actual[2].y == expected4.y);
+
+    // The number of reports is reduced.
+    // (10000 / 127 -> 79 reports for (1), 1280 / 127 -> 11 reports for (3), 1 report for (4))
+
+    expect(actual[0].count == 79_ul);
+    expect(actual[1].count == 11_ul);
+    expect(actual[2].count == 1_ul);
+
+    {
+      // Events before the first merged reports are kept.
+
+      queue q2;
+      q2.set_coalesce_pointing_inputs(true);
+
+      q2.emplace_back_pointing_input(make(1, 0, 0, 0, 1), krbn::event_type::single, t);
+      q2.emplace_back_key_event(pqrs::hid::usage_pair(pqrs::hid::usage_page::keyboard_or_keypad,
+                                                      pqrs::hid::usage::keyboard_or_keypad::keyboard_a),
+                                krbn::event_type::key_down,
+                                t);
+      q2.emplace_back_pointing_input(make(2, 0, 0, 0), krbn::event_type::single, t);
+      q2.emplace_back_pointing_input(make(3, 0, 0, 0), krbn::event_type::single, t);
+      q2.emplace_back_pointing_input(make(4, 0, 0, 0, 1), krbn::event_type::single, t);
+
+      recording_submitter submitter2;
+
+      q2.post_events(now,
+                     submitter2,
+                     std::weak_ptr<console_client>());
+      expect(q2.get_events().empty());
+
+      auto& reports = submitter2.get_reports();
+      expect(reports.size() == 4_ul);
+      if (reports.size() == 4) {
+        expect(std::get_if<pointing_input>(&reports[0])->x == 1);
+        expect(std::get_if<pointing_input>(&reports[1]) == nullptr);
+        expect(std::get_if<pointing_input>(&reports[2])->x == 5);
+        expect(std::get_if<pointing_input>(&reports[3])->x == 4);
+      }
+    }
+  };
+
+  "queue.async_post_events (flush timer)"_test = [] {
+    auto time_source = std::make_shared<pqrs::dispatcher::pseudo_time_source>();
+    auto dispatcher = std::make_shared<pqrs::dispatcher::dispatcher>(time_source);
+    auto object_id = pqrs::dispatcher::make_new_object_id();
+    dispatcher->attach(object_id);
+
+    auto wait_for_dispatcher = [&] {
+      auto wait = pqrs::make_thread_wait();
+      dispatcher->enqueue(
+          object_id,
+          [wait] {
+            wait->notify();
+          });
+      wait->wait_notice();
+    };
+
+    auto async_post_events = [](queue& q) {
+      q.async_post_events(std::weak_ptr<pqrs::karabiner::driverkit::virtual_hid_device_service::client>(),
+                          std::weak_ptr<krbn::console_user_server_client>());
+    };
+
+    // The pseudo time is not advanced in this test, so the armed flushes never fire.
+    // The events are far enough in the future not to become due while the test is running on a busy machine.
+
+    auto now = pqrs::osx::chrono::mach_absolute_time_point();
+    auto t1 = now + pqrs::osx::chrono::make_absolute_time_duration(std::chrono::hours(1));
+    auto t2 = now + pqrs::osx::chrono::make_absolute_time_duration(std::chrono::hours(2));
+
+    {
+      queue q(dispatcher);
+
+      // No flush is scheduled for an empty queue.
+
+      async_post_events(q);
+      wait_for_dispatcher();
+      expect(q.get_scheduled_flush_count() == 0_ul);
+
+      q.emplace_back_pointing_input(make_pointing_input(1), krbn::event_type::single, t2);
+
+      async_post_events(q);
+      wait_for_dispatcher();
+      expect(q.get_scheduled_flush_count() == 1_ul);
+
+      // Repeated calls do not schedule redundant flushes.
+
+      for (int i = 0; i < 10; ++i) {
+        async_post_events(q);
+      }
+      wait_for_dispatcher();
+      expect(q.get_scheduled_flush_count() == 1_ul);
+
+      // A later event does not re-arm the flush.
+
+      q.emplace_back_pointing_input(make_pointing_input(2), krbn::event_type::single, t2);
+
+      async_post_events(q);
+      wait_for_dispatcher();
+      expect(q.get_scheduled_flush_count() == 1_ul);
+
+      // An earlier event re-arms the flush.
+
+      q.clear();
+      q.emplace_back_pointing_input(make_pointing_input(3), krbn::event_type::single, t1);
+
+      async_post_events(q);
+      async_post_events(q);
+      wait_for_dispatcher();
+      expect(q.get_scheduled_flush_count() == 2_ul);
+      expect(q.get_events().size() == 1_ul);
+
+      // The armed flush is forgotten when the queue is drained without the timer.
+
+      q.post_events(t2,
+                    krbn::manipulator::manipulators::post_event_to_virtual_devices::hid_report_submitter(std::weak_ptr<pqrs::karabiner::driverkit::virtual_hid_device_service::client>()),
+                    std::weak_ptr<krbn::console_user_server_client>());
+      expect(q.get_events().empty());
+
+      q.emplace_back_pointing_input(make_pointing_input(4), krbn::event_type::single, t2);
+
+      async_post_events(q);
+      wait_for_dispatcher();
+      expect(q.get_scheduled_flush_count() == 3_ul);
+      expect(q.get_events().size() == 1_ul);
+    }
+
+    dispatcher->detach(object_id);
+    dispatcher->terminate();
+    dispatcher = nullptr;
+  };
+}
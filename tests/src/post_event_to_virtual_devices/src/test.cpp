@@ -1,6 +1,7 @@
 #include "../../share/json_helper.hpp"
 #include "../../share/manipulator_helper.hpp"
 #include "manipulator/manipulators/post_event_to_virtual_devices/post_event_to_virtual_devices.hpp"
+#include "queue_test.hpp"
 #include "run_loop_thread_utility.hpp"
 #include <boost/ut.hpp>
 
@@ -46,5 +47,7 @@ int main(void) {
     }
   };
 
+  run_queue_test();
+
   return 0;
 }
@@ -0,0 +1,81 @@
+#include "../../share/benchmark_helper.hpp"
+#include "pointing_button_manager.hpp"
+#include "pressed_keys_manager.hpp"
+#include <array>
+
+int main(void) {
+  //
+  // 6-key rollover stream
+  //
+
+  std::array<krbn::momentary_switch_event, 6> keys{
+      krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad, pqrs::hid::usage::keyboard_or_keypad::keyboard_a),
+      krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad, pqrs::hid::usage::keyboard_or_keypad::keyboard_s),
+      krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad, pqrs::hid::usage::keyboard_or_keypad::keyboard_d),
+      krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad, pqrs::hid::usage::keyboard_or_keypad::keyboard_f),
+      krbn::momentary_switch_event(pqrs::hid::usage_page::keyboard_or_keypad, pqrs::hid::usage::keyboard_or_keypad::keyboard_left_shift),
+      krbn::momentary_switch_event(pqrs::hid::usage_page::consumer, pqrs::hid::usage::consumer::mute),
+  };
+
+  // Each iteration sends 12 events (6 key_down and 6 key_up).
+  constexpr int events_per_iteration = 12;
+
+  {
+    krbn::pressed_keys_manager manager;
+
+    auto duration = krbn::unit_testing::benchmark_helper::measure(100000, [&] {
+      // Same as event_queue::utility::insert_device_keys_and_pointing_buttons_are_released_event.
+      for (const auto& k : keys) {
+        manager.insert(k);
+      }
+      for (const auto& k : keys) {
+        if (!manager.empty()) {
+          manager.erase(k);
+        }
+      }
+    });
+
+    krbn::unit_testing::benchmark_helper::print("pressed_keys_manager (6-key rollover, per event)",
+                                                duration / events_per_iteration);
+  }
+
+  {
+    using active_pointing_button = krbn::pointing_button_manager::active_pointing_button;
+
+    krbn::pointing_button_manager manager;
+    pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::buttons empty_buttons;
+    // Keep the reports alive so that the compiler does not omit make_hid_report_buttons.
+    size_t empty_report_count = 0;
+
+    std::vector<pqrs::hid::usage_pair> buttons;
+    for (int i = 1; i <= 6; ++i) {
+      buttons.push_back(pqrs::hid::usage_pair(pqrs::hid::usage_page::button,
+                                              pqrs::hid::usage::value_t(i)));
+    }
+
+    auto duration = krbn::unit_testing::benchmark_helper::measure(100000, [&] {
+      for (const auto& b : buttons) {
+        manager.push_back_active_pointing_button(active_pointing_button(active_pointing_button::type::increase,
+                                                                        b,
+                                                                        krbn::device_id(1)));
+        if (manager.make_hid_report_buttons() == empty_buttons) {
+          ++empty_report_count;
+        }
+      }
+      for (const auto& b : buttons) {
+        manager.push_back_active_pointing_button(active_pointing_button(active_pointing_button::type::decrease,
+                                                                        b,
+                                                                        krbn::device_id(1)));
+        if (manager.make_hid_report_buttons() == empty_buttons) {
+          ++empty_report_count;
+        }
+      }
+    });
+
+    krbn::unit_testing::benchmark_helper::print("pointing_button_manager (6 buttons, per event)",
+                                                duration / events_per_iteration);
+    std::cout << "  empty reports: " << empty_report_count << std::endl;
+  }
+
+  return 0;
+}
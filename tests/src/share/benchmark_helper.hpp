@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+
+namespace krbn {
+namespace unit_testing {
+class benchmark_helper final {
+public:
+  // Run `function` `iterations` times and return the average duration per iteration.
+  static std::chrono::nanoseconds measure(size_t iterations,
+                                          const std::function<void(void)>& function) {
+    if (iterations == 0) {
+      return std::chrono::nanoseconds(0);
+    }
+
+    // Warm up
+
+    function();
+
+    auto begin = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < iterations; ++i) {
+      function();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin) / iterations;
+  }
+
+  static void print(const std::string& name,
+                    std::chrono::nanoseconds duration) {
+    std::cout << name << ": " << duration.count() << " ns" << std::endl;
+  }
+};
+} // namespace unit_testing
+} // namespace krbn
@@ -0,0 +1,484 @@
+#include "dispatcher_utility.hpp"
+#include "timer_wheel.hpp"
+#include <boost/ut.hpp>
+#include <pqrs/thread_wait.hpp>
+#include <random>
+
+namespace {
+class test_environment final {
+public:
+  test_environment(void) : time_source_(std::make_shared<pqrs::dispatcher::pseudo_time_source>()),
+                           dispatcher_(std::make_shared<pqrs::dispatcher::dispatcher>(time_source_)),
+                           object_id_(pqrs::dispatcher::make_new_object_id()),
+                           timer_wheel_(std::make_shared<krbn::timer_wheel>(dispatcher_)) {
+    dispatcher_->attach(object_id_);
+  }
+
+  ~test_environment(void) {
+    timer_wheel_ = nullptr;
+    dispatcher_->detach(object_id_);
+    dispatcher_->terminate();
+  }
+
+  krbn::timer_wheel& get_timer_wheel(void) const {
+    return *timer_wheel_;
+  }
+
+  std::shared_ptr<pqrs::dispatcher::dispatcher> get_dispatcher(void) const {
+    return dispatcher_;
+  }
+
+  static pqrs::dispatcher::time_point make_time_point(int64_t ms) {
+    return pqrs::dispatcher::time_point(std::chrono::milliseconds(ms));
+  }
+
+  // Move the pseudo time and wait until tasks at `ms` or earlier are finished.
+  void advance_now(int64_t ms) {
+    time_source_->set_now(make_time_point(ms));
+
+    auto wait = pqrs::make_thread_wait();
+    dispatcher_->enqueue(
+        object_id_,
+        [wait] {
+          wait->notify();
+        },
+        make_time_point(ms));
+    wait->wait_notice();
+  }
+
+  void set_now(int64_t ms) {
+    time_source_->set_now(make_time_point(ms));
+  }
+
+private:
+  std::shared_ptr<pqrs::dispatcher::pseudo_time_source> time_source_;
+  std::shared_ptr<pqrs::dispatcher::dispatcher> dispatcher_;
+  pqrs::dispatcher::object_id object_id_;
+  std::shared_ptr<krbn::timer_wheel> timer_wheel_;
+};
+
+class timer_client final : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  timer_client(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher) : dispatcher_client(weak_dispatcher),
+                                                                             timer_(*this),
+                                                                             count_(0) {
+  }
+
+  ~timer_client(void) {
+    detach_from_dispatcher([this] {
+      timer_.stop();
+    });
+  }
+
+  void start(std::chrono::milliseconds interval) {
+    timer_.start(
+        [this] {
+          ++count_;
+        },
+        interval);
+  }
+
+  void stop(void) {
+    timer_.stop();
+  }
+
+  int get_count(void) const {
+    return count_;
+  }
+
+private:
+  krbn::timer_wheel_timer timer_;
+  std::atomic<int> count_;
+};
+
+class one_shot_timer_client final : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  one_shot_timer_client(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher) : dispatcher_client(weak_dispatcher),
+                                                                                       timer_(*this, weak_dispatcher),
+                                                                                       count_(0) {
+  }
+
+  ~one_shot_timer_client(void) {
+    detach_from_dispatcher([this] {
+      timer_.cancel();
+    });
+  }
+
+  void arm(std::chrono::milliseconds duration) {
+    enqueue_to_dispatcher([this, duration] {
+      timer_.arm(duration,
+                 [this] {
+                   ++count_;
+                 });
+    });
+  }
+
+  void cancel(void) {
+    enqueue_to_dispatcher([this] {
+      timer_.cancel();
+    });
+  }
+
+  int get_count(void) const {
+    return count_;
+  }
+
+private:
+  krbn::timer_wheel_one_shot_timer timer_;
+  std::atomic<int> count_;
+};
+} // namespace
+
+int main(void) {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "timer_wheel.order"_test = [] {
+    test_environment environment;
+    auto& wheel = environment.get_timer_wheel();
+
+    std::vector<std::string> actual;
+    std::mutex actual_mutex;
+    auto push_back = [&](const std::string& value) {
+      return [&, value] {
+        std::lock_guard<std::mutex> lock(actual_mutex);
+        actual.push_back(value);
+      };
+    };
+
+    wheel.arm(test_environment::make_time_point(30), push_back("30"));
+    wheel.arm(test_environment::make_time_point(10), push_back("10a"));
+    wheel.arm(test_environment::make_time_point(20), push_back("20"));
+    wheel.arm(test_environment::make_time_point(10), push_back("10b"));
+
+    expect(wheel.size() == 4);
+    expect(wheel.get_next_deadline() == test_environment::make_time_point(10));
+
+    environment.advance_now(9);
+    expect(actual.empty());
+
+    environment.advance_now(10);
+    expect(actual == std::vector<std::string>({"10a", "10b"}));
+
+    environment.advance_now(100);
+    expect(actual == std::vector<std::string>({"10a", "10b", "20", "30"}));
+    expect(wheel.size() == 0);
+    expect(wheel.get_next_deadline() == std::nullopt);
+  };
+
+  "timer_wheel.cancel"_test = [] {
+    test_environment environment;
+    auto& wheel = environment.get_timer_wheel();
+
+    std::atomic<int> count1 = 0;
+    std::atomic<int> count2 = 0;
+
+    auto id1 = wheel.arm(test_environment::make_time_point(10), [&] { ++count1; });
+    auto id2 = wheel.arm(test_environment::make_time_point(10), [&] { ++count2; });
+    expect(id1 != id2);
+
+    wheel.cancel(id1);
+    expect(wheel.size() == 1);
+
+    // A canceled id is ignored.
+    wheel.cancel(id1);
+    expect(wheel.size() == 1);
+
+    environment.advance_now(100);
+    expect(count1 == 0);
+    expect(count2 == 1);
+
+    // The id of fired timer is ignored.
+    wheel.cancel(id2);
+    expect(wheel.size() == 0);
+  };
+
+  "timer_wheel.cancel in function"_test = [] {
+    test_environment environment;
+    auto& wheel = environment.get_timer_wheel();
+
+    std::atomic<int> count = 0;
+
+    krbn::timer_wheel::timer_id id2 = 0;
+    wheel.arm(test_environment::make_time_point(10), [&] { wheel.cancel(id2); });
+    id2 = wheel.arm(test_environment::make_time_point(10), [&] { ++count; });
+
+    environment.advance_now(100);
+    expect(count == 0);
+    expect(wheel.size() == 0);
+  };
+
+  "timer_wheel.wakeup"_test = [] {
+    test_environment environment;
+    auto& wheel = environment.get_timer_wheel();
+
+    // No task is executed while no timer is armed.
+
+    environment.advance_now(1000);
+    expect(wheel.get_wakeup_count() == 0);
+
+    // Timers which share the deadline are fired in a task.
+
+    std::atomic<int> count = 0;
+    for (int i = 0; i < 10; ++i) {
+      wheel.arm(test_environment::make_time_point(1500), [&] { ++count; });
+    }
+
+    environment.advance_now(1499);
+    expect(count == 0);
+    expect(wheel.get_wakeup_count() == 0);
+
+    environment.advance_now(1500);
+    expect(count == 10);
+    expect(wheel.get_wakeup_count() == 1);
+
+    // Distant deadlines do not wake up the dispatcher until the deadline.
+
+    wheel.arm(test_environment::make_time_point(1500 + 100000), [&] { ++count; });
+    expect(wheel.get_next_deadline() == test_environment::make_time_point(1500 + 100000));
+
+    environment.advance_now(1500 + 99999);
+    expect(count == 10);
+    expect(wheel.get_wakeup_count() == 1);
+
+    environment.advance_now(1500 + 100000);
+    expect(count == 11);
+    expect(wheel.get_wakeup_count() == 2);
+  };
+
+  "timer_wheel.levels"_test = [] {
+    test_environment environment;
+    auto& wheel = environment.get_timer_wheel();
+
+    std::vector<int64_t> deadlines{
+        63,
+        64,
+        65,
+        4095,
+        4096,
+        4097,
+        262143,
+        262144,
+        16777215,
+        16777216,
+        16777217,
+        40000000,
+    };
+
+    std::vector<int64_t> actual;
+    std::mutex actual_mutex;
+
+    for (auto it = std::rbegin(deadlines); it != std::rend(deadlines); ++it) {
+      auto d = *it;
+      wheel.arm(test_environment::make_time_point(d), [&, d] {
+        std::lock_guard<std::mutex> lock(actual_mutex);
+        actual.push_back(d);
+      });
+    }
+
+    for (size_t i = 0; i < deadlines.size(); ++i) {
+      expect(wheel.get_next_deadline() == test_environment::make_time_point(deadlines[i]));
+
+      environment.advance_now(deadlines[i] - 1);
+      expect(actual.size() == i);
+
+      environment.advance_now(deadlines[i]);
+      expect(actual.size() == i + 1);
+      expect(actual.back() == deadlines[i]);
+    }
+  };
+
+  "timer_wheel.time source goes backwards"_test = [] {
+    test_environment environment;
+    auto& wheel = environment.get_timer_wheel();
+
+    std::atomic<int> count1 = 0;
+    std::atomic<int> count2 = 0;
+
+    environment.advance_now(10000);
+    wheel.arm(test_environment::make_time_point(10100), [&] { ++count1; });
+
+    environment.set_now(0);
+    wheel.arm(test_environment::make_time_point(50), [&] { ++count2; });
+
+    environment.advance_now(60);
+    expect(count1 == 0);
+    expect(count2 == 1);
+
+    environment.advance_now(10100);
+    expect(count1 == 1);
+    expect(count2 == 1);
+  };
+
+  "timer_wheel.random"_test = [] {
+    test_environment environment;
+    auto& wheel = environment.get_timer_wheel();
+
+    std::mt19937 engine(0);
+    std::uniform_int_distribution<int64_t> delay_distribution(0, 10000);
+    std::uniform_int_distribution<int> action_distribution(0, 9);
+
+    struct expected_timer final {
+      int64_t deadline;
+      int serial;
+    };
+
+    std::vector<std::pair<krbn::timer_wheel::timer_id, expected_timer>> armed;
+    std::vector<int> expected;
+    std::vector<int> actual;
+    std::mutex actual_mutex;
+
+    int64_t now = 0;
+    int serial = 0;
+
+    for (int step = 0; step < 2000; ++step) {
+      switch (action_distribution(engine)) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+        case 4: {
+          auto deadline = now + delay_distribution(engine);
+          auto s = serial++;
+          auto id = wheel.arm(test_environment::make_time_point(deadline), [&, s] {
+            std::lock_guard<std::mutex> lock(actual_mutex);
+            actual.push_back(s);
+          });
+          armed.push_back({id, {deadline, s}});
+          break;
+        }
+
+        case 5:
+          if (!armed.empty()) {
+            auto i = std::uniform_int_distribution<size_t>(0, armed.size() - 1)(engine);
+            wheel.cancel(armed[i].first);
+            armed.erase(std::begin(armed) + i);
+          }
+          break;
+
+        default: {
+          now += delay_distribution(engine) / 10;
+
+          std::stable_sort(std::begin(armed),
+                           std::end(armed),
+                           [](const auto& a, const auto& b) {
+                             return a.second.deadline < b.second.deadline;
+                           });
+          while (!armed.empty() && armed.front().second.deadline <= now) {
+            expected.push_back(armed.front().second.serial);
+            armed.erase(std::begin(armed));
+          }
+
+          environment.advance_now(now);
+          break;
+        }
+      }
+
+      std::lock_guard<std::mutex> lock(actual_mutex);
+      if (actual != expected) {
+        expect(false) << "step:" << step;
+        break;
+      }
+    }
+
+    expect(wheel.size() == armed.size());
+  };
+
+  "timer_wheel_one_shot_timer"_test = [] {
+    // The timer uses its own timer wheel on a dispatcher which is not the shared dispatcher.
+
+    test_environment environment;
+
+    {
+      auto client = std::make_unique<one_shot_timer_client>(environment.get_dispatcher());
+
+      // `advance_now` is also called to wait until `arm` and `cancel` are processed.
+
+      client->arm(std::chrono::milliseconds(20));
+      environment.advance_now(0);
+      environment.advance_now(19);
+      expect(client->get_count() == 0);
+      environment.advance_now(20);
+      expect(client->get_count() == 1);
+      environment.advance_now(100);
+      expect(client->get_count() == 1);
+
+      // `arm` replaces the armed function.
+      client->arm(std::chrono::milliseconds(20));
+      environment.advance_now(100);
+      environment.advance_now(110);
+      client->arm(std::chrono::milliseconds(20));
+      environment.advance_now(110);
+      environment.advance_now(120);
+      expect(client->get_count() == 1);
+      environment.advance_now(130);
+      expect(client->get_count() == 2);
+
+      client->arm(std::chrono::milliseconds(20));
+      client->cancel();
+      environment.advance_now(130);
+      environment.advance_now(200);
+      expect(client->get_count() == 2);
+
+      client->arm(std::chrono::milliseconds(20));
+      environment.advance_now(200);
+      client = nullptr;
+      environment.advance_now(300);
+    }
+  };
+
+  "timer_wheel_timer"_test = [] {
+    auto scoped_dispatcher_manager = krbn::dispatcher_utility::initialize_dispatchers();
+
+    auto time_source = std::make_shared<pqrs::dispatcher::pseudo_time_source>();
+    auto dispatcher = pqrs::dispatcher::extra::get_shared_dispatcher();
+    dispatcher->set_weak_time_source(time_source);
+
+    auto object_id = pqrs::dispatcher::make_new_object_id();
+    dispatcher->attach(object_id);
+
+    auto advance_now = [&](int64_t ms) {
+      auto when = pqrs::dispatcher::time_point(std::chrono::milliseconds(ms));
+      time_source->set_now(when);
+
+      auto wait = pqrs::make_thread_wait();
+      dispatcher->enqueue(
+          object_id,
+          [wait] {
+            wait->notify();
+          },
+          when);
+      wait->wait_notice();
+    };
+
+    {
+      auto client = std::make_unique<timer_client>(dispatcher);
+
+      // `function` is called at 0, 20, 40, ..., 100.
+      client->start(std::chrono::milliseconds(20));
+      for (int ms = 0; ms <= 100; ms += 10) {
+        advance_now(ms);
+      }
+      advance_now(100);
+      expect(client->get_count() == 6);
+
+      client->stop();
+      advance_now(200);
+      expect(client->get_count() == 6);
+      expect(krbn::get_shared_timer_wheel()->size() == 0);
+
+      client->start(std::chrono::milliseconds(20));
+      advance_now(210);
+      expect(client->get_count() == 7);
+      expect(krbn::get_shared_timer_wheel()->size() == 1);
+
+      // The armed timer is canceled when the client is destroyed.
+      client = nullptr;
+      expect(krbn::get_shared_timer_wheel()->size() == 0);
+    }
+
+    dispatcher->detach(object_id);
+  };
+
+  return 0;
+}
@@ -0,0 +1,112 @@
+#include "types.hpp"
+#include <boost/ut.hpp>
+
+void run_hid_usage_class_test(void) {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "classify_hid_usage"_test = [] {
+    //
+    // momentary_switch
+    //
+
+    // The result is the same as the target functions of momentary_switch_event_details.
+
+    std::vector<pqrs::hid::usage_page::value_t> usage_pages{
+        pqrs::hid::usage_page::generic_desktop,
+        pqrs::hid::usage_page::keyboard_or_keypad,
+        pqrs::hid::usage_page::leds,
+        pqrs::hid::usage_page::button,
+        pqrs::hid::usage_page::consumer,
+        pqrs::hid::usage_page::apple_vendor_keyboard,
+        pqrs::hid::usage_page::apple_vendor_top_case,
+        pqrs::hid::usage_page::undefined,
+    };
+
+    std::vector<int32_t> usages{-1, 0xfffe, 0xffff, 0x10000};
+    for (int32_t u = 0; u < 0x400; ++u) {
+      usages.push_back(u);
+    }
+
+    for (const auto& usage_page : usage_pages) {
+      for (const auto& u : usages) {
+        pqrs::hid::usage::value_t usage(u);
+
+        auto expected = krbn::momentary_switch_event_details::key_code::target(usage_page, usage) ||
+                        krbn::momentary_switch_event_details::consumer_key_code::target(usage_page, usage) ||
+                        krbn::momentary_switch_event_details::apple_vendor_keyboard_key_code::target(usage_page, usage) ||
+                        krbn::momentary_switch_event_details::apple_vendor_top_case_key_code::target(usage_page, usage) ||
+                        krbn::momentary_switch_event_details::pointing_button::target(usage_page, usage) ||
+                        krbn::momentary_switch_event_details::generic_desktop::target(usage_page, usage);
+
+        expect((krbn::classify_hid_usage(usage_page, usage).kind == krbn::hid_usage_kind::momentary_switch) == expected)
+            << fmt::format("usage_page:{0} usage:{1}", type_safe::get(usage_page), u);
+      }
+    }
+
+    //
+    // Other kinds
+    //
+
+    expect(krbn::classify_hid_usage(pqrs::hid::usage_page::generic_desktop,
+                                    pqrs::hid::usage::generic_desktop::x)
+               .kind == krbn::hid_usage_kind::pointing_motion_x);
+    expect(krbn::classify_hid_usage(pqrs::hid::usage_page::generic_desktop,
+                                    pqrs::hid::usage::generic_desktop::y)
+               .kind == krbn::hid_usage_kind::pointing_motion_y);
+    expect(krbn::classify_hid_usage(pqrs::hid::usage_page::generic_desktop,
+                                    pqrs::hid::usage::generic_desktop::wheel)
+               .kind == krbn::hid_usage_kind::pointing_motion_vertical_wheel);
+    expect(krbn::classify_hid_usage(pqrs::hid::usage_page::consumer,
+                                    pqrs::hid::usage::consumer::ac_pan)
+               .kind == krbn::hid_usage_kind::pointing_motion_horizontal_wheel);
+    expect(krbn::classify_hid_usage(pqrs::hid::usage_page::leds,
+                                    pqrs::hid::usage::led::caps_lock)
+               .kind == krbn::hid_usage_kind::caps_lock_led);
+    expect(krbn::classify_hid_usage(pqrs::hid::usage_page::generic_desktop,
+                                    pqrs::hid::usage::generic_desktop::hat_switch)
+               .kind == krbn::hid_usage_kind::hat_switch);
+    expect(krbn::classify_hid_usage(pqrs::hid::usage_page::generic_desktop,
+                                    pqrs::hid::usage::generic_desktop::z)
+               .kind == krbn::hid_usage_kind::none);
+
+    //
+    // modifier
+    //
+
+    expect(krbn::classify_hid_usage(pqrs::hid::usage_page::keyboard_or_keypad,
+                                    pqrs::hid::usage::keyboard_or_keypad::keyboard_left_control)
+               .modifier == krbn::modifier_flag::left_control);
+    expect(krbn::classify_hid_usage(pqrs::hid::usage_page::keyboard_or_keypad,
+                                    pqrs::hid::usage::keyboard_or_keypad::keyboard_right_gui)
+               .modifier == krbn::modifier_flag::right_command);
+    expect(krbn::classify_hid_usage(pqrs::hid::usage_page::apple_vendor_keyboard,
+                                    pqrs::hid::usage::apple_vendor_keyboard::function)
+               .modifier == krbn::modifier_flag::fn);
+    expect(krbn::classify_hid_usage(pqrs::hid::usage_page::apple_vendor_top_case,
+                                    pqrs::hid::usage::apple_vendor_top_case::keyboard_fn)
+               .modifier == krbn::modifier_flag::fn);
+    expect(krbn::classify_hid_usage(pqrs::hid::usage_page::keyboard_or_keypad,
+                                    pqrs::hid::usage::keyboard_or_keypad::keyboard_caps_lock)
+               .modifier == krbn::modifier_flag::zero);
+    expect(krbn::classify_hid_usage(pqrs::hid::usage_page::keyboard_or_keypad,
+                                    pqrs::hid::usage::keyboard_or_keypad::keyboard_a)
+               .modifier == krbn::modifier_flag::zero);
+
+    //
+    // The modifier flag cached in momentary_switch_event
+    //
+
+    {
+      krbn::momentary_switch_event e(pqrs::hid::usage_page::keyboard_or_keypad,
+                                     pqrs::hid::usage::keyboard_or_keypad::keyboard_a);
+      expect(e.make_modifier_flag() == std::nullopt);
+
+      e.set_usage_pair(pqrs::hid::usage_pair(pqrs::hid::usage_page::keyboard_or_keypad,
+                                             pqrs::hid::usage::keyboard_or_keypad::keyboard_left_shift));
+      expect(e.make_modifier_flag() == krbn::modifier_flag::left_shift);
+
+      expect(e == krbn::momentary_switch_event(krbn::modifier_flag::left_shift));
+    }
+  };
+}
@@ -1,6 +1,7 @@
 #include "device_identifiers_test.hpp"
 #include "errors_test.hpp"
 #include "grabbable_state_test.hpp"
+#include "hid_usage_class_test.hpp"
 #include "manipulator_environment_variable_set_variable_test.hpp"
 #include "manipulator_environment_variable_value_test.hpp"
 #include "modifier_flag_test.hpp"
@@ -16,6 +17,7 @@ int main(void) {
   run_device_identifiers_test();
   run_errors_test();
   run_grabbable_state_test();
+  run_hid_usage_class_test();
   run_manipulator_environment_variable_set_variable_test();
   run_manipulator_environment_variable_value_test();
   run_modifier_flag_test();